@@ -28,9 +28,17 @@ PG_FUNCTION_INFO_V1(lp_function_minus);
 PG_FUNCTION_INFO_V1(lp_function_minus1);
 PG_FUNCTION_INFO_V1(lp_function_sum_trans);
 PG_FUNCTION_INFO_V1(lp_function_sum_final);
+PG_FUNCTION_INFO_V1(lp_function_sum_combine);
+PG_FUNCTION_INFO_V1(lp_function_sum_serialize);
+PG_FUNCTION_INFO_V1(lp_function_sum_deserialize);
+PG_FUNCTION_INFO_V1(lp_function_msum_trans);
+PG_FUNCTION_INFO_V1(lp_function_msum_inv);
+PG_FUNCTION_INFO_V1(lp_function_msum_final);
 PG_FUNCTION_INFO_V1(lp_function_unnest);
 /******************* Experimental functions ****************** */
 PG_FUNCTION_INFO_V1(lp_function_plus_sorted);
+PG_FUNCTION_INFO_V1(lp_function_sum_hash_trans);
+PG_FUNCTION_INFO_V1(lp_function_sum_hash_final);
 PG_FUNCTION_INFO_V1(lp_function_sum_array_trans);
 PG_FUNCTION_INFO_V1(lp_function_sum_array_final);
 
@@ -38,6 +46,8 @@ PG_FUNCTION_INFO_V1(lp_function_sum_array_final);
 // Internal declarations
 const struct pg_LPfunction LPfunction_EMPTY = {sizeof(pg_LPfunction), 0, 0};
 
+static Datum internal_lp_function_scale(FunctionCallInfo fcinfo, int argno, double factor);
+
 // Internal functions
 void lp_function_to_stringinfo(pg_LPfunction * terms, StringInfoData * buf){
 	if (terms)
@@ -179,274 +189,1421 @@ extern pg_LPfunction * internal_lp_function_mul(pg_LPfunction * t, double factor
 
 Datum lp_function_fmul(PG_FUNCTION_ARGS)
 {
-	PG_RETURN_LPfunction(internal_lp_function_mul(PG_GETARG_LPfunction(0), PG_GETARG_FLOAT8(1)));
+	return internal_lp_function_scale(fcinfo, 0, PG_GETARG_FLOAT8(1));
 }
 
 // A commutative version of the function
 Datum lp_function_fmulC(PG_FUNCTION_ARGS)
 {
-	PG_RETURN_LPfunction(internal_lp_function_mul(PG_GETARG_LPfunction(1), PG_GETARG_FLOAT8(0)));
+	return internal_lp_function_scale(fcinfo, 1, PG_GETARG_FLOAT8(0));
 }
 
 Datum lp_function_fdiv(PG_FUNCTION_ARGS)
 {
-	PG_RETURN_LPfunction(internal_lp_function_mul(PG_GETARG_LPfunction(0), 1.0/PG_GETARG_FLOAT8(1)));
+	return internal_lp_function_scale(fcinfo, 0, 1.0/PG_GETARG_FLOAT8(1));
 }
 
-/* Optimized aggregation functions routines based on HASH for large models
+/* Optimized aggregation functions routines for large models, adapting to the variable numbers (see lpAggStrategy)
  * */
-static inline lpAggstate * internal_lp_function_sum_trans(lpAggstate * state, pg_LPfunction * next)
+
+#define LP_AGG_SORTED_TERMS		32		/* The capacity of the sorted buffer */
+#define LP_AGG_ARRAY_SPREAD		4		/* An array may span up to 4 variable numbers per term */
+#define LP_AGG_MIN_SLOT_BITS	6		/* The initial table of 64 slots */
+#define LP_AGG_MAX_SLOT_BITS	30
+
+/* A slot of a variable number, taking the high bits of the Fibonacci hash */
+#define LP_AGG_SLOT(varNr, bits)	((int) (((uint32) (varNr) * 0x9E3779B9U) >> (32 - (bits))))
+
+/* Compares two terms on varNr for the use in qsort */
+static int compareTerms(const void * a, const void * b)
 {
-	int 			i;
-	bool            found;
+	int v1 = ((const lpTerm *) a)->varNr;
+	int v2 = ((const lpTerm *) b)->varNr;
 
-	/* Create a state */
-	if (state == NULL) {
-		HASHCTL		   ctl;
+	return v1 < v2 ? -1 : (v1 > v2 ? 1 : 0);
+}
 
-		// Initialize the hash
-		MemSet(&ctl, 0, sizeof(ctl));
-		ctl.keysize = sizeof(int);
-		ctl.entrysize = sizeof(lpTerm);		// Stores the pointers to double
-		ctl.hash = tag_hash;
-		ctl.hcxt = CurrentMemoryContext;
+/* Checks if "numTerms" terms spanning the variable numbers from..to are dense enough for an array */
+static inline bool internal_lp_function_sum_compact(int64 from, int64 to, int numTerms)
+{
+	return to - from + 1 <= (int64) LP_AGG_ARRAY_SPREAD * numTerms;
+}
 
-		state = palloc0(sizeof(lpAggstate));
-		SET_VARSIZE(state, sizeof(lpAggstate));
-		state-> factor0 = 0;
+/*
+ * (Re)builds the table of 2^bits slots for the terms of the arena. The functions below are called in the
+ * memory context of the state.
+ */
+static void internal_lp_function_sum_table_build(lpAggstate * state, int bits)
+{
+	int		mask = (1 << bits) - 1;
+	int		i;
 
-		state->hashVnr = hash_create("lp_function hash of variable numbers for efficient aggregation ",
-										1024,  &ctl, HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT );
+	if (bits > LP_AGG_MAX_SLOT_BITS)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("SolverLP: too many variables in lp_function aggregation")));
 
-		/* Take control over hash-tables memory context for performance optimization - see comments below.*/
-		state->htMemCtx = CurrentMemoryContext->firstchild; /* We do this way, as HTAB is incomplete */
+	if (state->slots != NULL)
+		pfree(state->slots);
+	state->slots = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int32) << bits);
+	MemSet(state->slots, 0, sizeof(int32) << bits);
+	state->slotBits = bits;
+
+	for (i = 0; i < state->numTerms; i++)
+	{
+		int slot = LP_AGG_SLOT(state->terms[i].varNr, bits);
+
+		while (state->slots[slot] != 0)
+			slot = (slot + 1) & mask;
+		state->slots[slot] = i + 1;
 	}
+}
 
-	/* Add all terms from next */
-	state->factor0 += next->factor0;
-	for (i = 0; i < next->numTerms; i++) {
-		lpTerm * term;
+/* Moves the terms of the sorted buffer or of the array into the hash table */
+static void internal_lp_function_sum_to_hash(lpAggstate * state)
+{
+	int bits = LP_AGG_MIN_SLOT_BITS;
 
-		term = (lpTerm *) hash_search(state->hashVnr, &(next->term[i].varNr), HASH_ENTER, &found);
-		if (found)
-			term->factor += next->term[i].factor;
-		else
-			term->factor = next->term[i].factor; /* Key is already inserted */
+	if (state->strategy == LP_AGG_ARRAY)
+	{
+		int i, n = 0;
+
+		state->maxTerms = Max(state->numTerms * 2, LP_AGG_SORTED_TERMS);
+		state->terms = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(lpTerm) * state->maxTerms);
+		for (i = 0; i <= state->fillTo - state->fillFrom; i++)
+			if (state->present[i])
+			{
+				state->terms[n].varNr = state->fillFrom + i;
+				state->terms[n].factor = state->factarray[i];
+				n++;
+			}
+		Assert(n == state->numTerms);
+
+		pfree(state->factarray);
+		pfree(state->present);
+		state->factarray = NULL;
+		state->present = NULL;
 	}
-	return state;
+
+	/* The terms come ascending from both */
+	state->sorted = true;
+	while ((int64) state->numTerms * 2 > ((int64) 1 << bits))
+		bits++;
+	internal_lp_function_sum_table_build(state, bits);
+	state->strategy = LP_AGG_HASH;
 }
 
-static inline pg_LPfunction * internal_lp_function_sum_final(lpAggstate * state, bool only_reset_hash_context) {
-	pg_LPfunction * result = NULL;
+/* Moves the terms of the sorted buffer or of the hash table into an array spanning the variable numbers seen */
+static void internal_lp_function_sum_to_array(lpAggstate * state)
+{
+	int64	size = (int64) state->maxVarNr - state->minVarNr + 1;
+	int		i;
+
+	state->fillFrom = state->minVarNr;
+	state->fillTo = state->maxVarNr;
+	state->factarray = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(double) * size);
+	state->present = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(bool) * size);
+	MemSet(state->factarray, 0, sizeof(double) * size);
+	MemSet(state->present, 0, sizeof(bool) * size);
+	for (i = 0; i < state->numTerms; i++)
+	{
+		state->factarray[state->terms[i].varNr - state->fillFrom] = state->terms[i].factor;
+		state->present[state->terms[i].varNr - state->fillFrom] = true;
+	}
 
-	if (state != NULL && state->hashVnr != NULL) {
-		int numEntries = hash_get_num_entries(state->hashVnr);
-		HASH_SEQ_STATUS seqstatus;
-		int i=0;
-		lpTerm *term;
+	pfree(state->terms);
+	state->terms = NULL;
+	if (state->slots != NULL)
+		pfree(state->slots);
+	state->slots = NULL;
+	state->strategy = LP_AGG_ARRAY;
+}
 
-		result = (pg_LPfunction *) palloc(LPfunction_SIZE(numEntries));
+/* Extends the array to the variable number, at least doubling it */
+static void internal_lp_function_sum_array_grow(lpAggstate * state, int varNr)
+{
+	int64	curSize = (int64) state->fillTo - state->fillFrom + 1;
+	int64	from = state->fillFrom;
+	int64	to = state->fillTo;
+	int64	newSize;
+	double *newarray;
+	bool   *newpresent;
+
+	if (varNr > to)
+		to = Min(Max(to + curSize, varNr), INT_MAX);
+	else
+		from = Max(Min(from - curSize, varNr), INT_MIN);
+	newSize = to - from + 1;
+
+	newarray = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(double) * newSize);
+	newpresent = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(bool) * newSize);
+	MemSet(newarray, 0, sizeof(double) * newSize);
+	MemSet(newpresent, 0, sizeof(bool) * newSize);
+	memcpy(newarray + (state->fillFrom - from), state->factarray, sizeof(double) * curSize);
+	memcpy(newpresent + (state->fillFrom - from), state->present, sizeof(bool) * curSize);
 
-		result->factor0 = state->factor0;
-		result->numTerms = numEntries;
+	pfree(state->factarray);
+	pfree(state->present);
+	state->factarray = newarray;
+	state->present = newpresent;
+	state->fillFrom = (int) from;
+	state->fillTo = (int) to;
+}
 
-		/* Copy all entries (unsorted) */
-		hash_seq_init(&seqstatus, state->hashVnr);
+/* Adds a term to the hash table */
+static inline void internal_lp_function_sum_hash_add(lpAggstate * state, lpTerm * term)
+{
+	int		mask = (1 << state->slotBits) - 1;
+	int		slot = LP_AGG_SLOT(term->varNr, state->slotBits);
+	int32	pos;
 
-		while ((term = (lpTerm *) hash_seq_search(&seqstatus)) != NULL)
-			if (i < numEntries)
-				result->term[i++] = *term;
+	/* Probe the slots until the variable or an empty slot is found */
+	while ((pos = state->slots[slot]) != 0 && state->terms[pos - 1].varNr != term->varNr)
+		slot = (slot + 1) & mask;
 
-		Assert(i==numEntries);
+	if (pos != 0)
+	{
+		state->terms[pos - 1].factor += term->factor;
+		return;
+	}
 
-		/* Sort the indices array */
-		// 2014-08-25 No sorting is required
-		// qsort(result->term, result->numTerms, sizeof(lpTerm), compareTerms);
-		SET_VARSIZE(result, LPfunction_SIZE(result->numTerms));
+	/* Append a new term to the arena. The table is kept at most half full. */
+	if (state->numTerms == state->maxTerms)
+	{
+		state->maxTerms *= 2;
+		state->terms = repalloc_huge(state->terms, sizeof(lpTerm) * state->maxTerms);
+	}
+	if (state->numTerms > 0 && state->terms[state->numTerms - 1].varNr > term->varNr)
+		state->sorted = false;
+	state->terms[state->numTerms++] = *term;
+	state->slots[slot] = state->numTerms;
 
-		// ************ This is an optimization trick. *******
-		// We do not destroy the table. Instead, only free the memory from the hash-table context.
-		// Otherwise, MemoryContextDelete will cause overhead, when thousands of hash tables are created with ORDER BY
-		// TODO: Use a non-PG HASH structure, which does not generate its own memory context
-		if (only_reset_hash_context && state->htMemCtx)
-			MemoryContextReset(state->htMemCtx);
+	/* A full table is doubled, unless the terms turned out to be dense (e.g., shuffled) */
+	if (state->numTerms * 2 > mask + 1)
+	{
+		if (internal_lp_function_sum_compact(state->minVarNr, state->maxVarNr, state->numTerms))
+			internal_lp_function_sum_to_array(state);
 		else
-		    hash_destroy(state->hashVnr);
-		pfree(state);
+			internal_lp_function_sum_table_build(state, state->slotBits + 1);
 	}
-
-	return result;
 }
 
-
-extern pg_LPfunction * internal_lp_function_plus(pg_LPfunction * p1, pg_LPfunction * p2)
+/* Adds a term to the array, unless the array would turn sparse. Returns false in that case. */
+static inline bool internal_lp_function_sum_array_add(lpAggstate * state, lpTerm * term)
 {
-	lpAggstate * state;
-	pg_LPfunction * result;
+	int idx;
 
-	state = internal_lp_function_sum_trans(NULL, p1);
-	state = internal_lp_function_sum_trans(state, p2);
-	result = internal_lp_function_sum_final(state, false);
+	if (term->varNr < state->fillFrom || term->varNr > state->fillTo)
+	{
+		if (!internal_lp_function_sum_compact(state->minVarNr, state->maxVarNr, state->numTerms + 1))
+			return false;
+		internal_lp_function_sum_array_grow(state, term->varNr);
+	}
 
-	return result;
+	idx = term->varNr - state->fillFrom;
+	if (state->present[idx])
+		state->factarray[idx] += term->factor;
+	else
+	{
+		state->factarray[idx] = term->factor;
+		state->present[idx] = true;
+		state->numTerms++;
+	}
+	return true;
 }
 
-Datum lp_function_plus(PG_FUNCTION_ARGS)
+/* Adds a term to the sorted buffer, unless the buffer is full. Returns false in that case. */
+static inline bool internal_lp_function_sum_sorted_add(lpAggstate * state, lpTerm * term)
 {
-	pg_LPfunction * p1 = PG_ARGISNULL(0) ? (pg_LPfunction *)&LPfunction_EMPTY
-									  : PG_GETARG_LPfunction(0);
-	pg_LPfunction * p2 = PG_ARGISNULL(1) ? (pg_LPfunction *)&LPfunction_EMPTY
-									  : PG_GETARG_LPfunction(1);
+	int lo = 0, hi = state->numTerms;
 
-	PG_RETURN_LPfunction(internal_lp_function_plus(p1,p2));
-}
+	/* Find the first term not below the variable number */
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
 
+		if (state->terms[mid].varNr < term->varNr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
 
-extern Datum lp_function_minus(PG_FUNCTION_ARGS)
-{
-	pg_LPfunction * p1 = PG_ARGISNULL(0) ? (pg_LPfunction *)&LPfunction_EMPTY
-										  : PG_GETARG_LPfunction(0);
-	pg_LPfunction * p2 = PG_ARGISNULL(1) ? (pg_LPfunction *)&LPfunction_EMPTY
-										  : PG_GETARG_LPfunction(1);
+	if (lo < state->numTerms && state->terms[lo].varNr == term->varNr)
+	{
+		state->terms[lo].factor += term->factor;
+		return true;
+	}
+	if (state->numTerms == LP_AGG_SORTED_TERMS)
+		return false;
 
-	PG_RETURN_LPfunction(internal_lp_function_plus(p1,internal_lp_function_mul(p2,-1)));
+	memmove(state->terms + lo + 1, state->terms + lo, sizeof(lpTerm) * (state->numTerms - lo));
+	state->terms[lo] = *term;
+	state->numTerms++;
+	return true;
 }
 
-/* Unary version of minus */
-extern Datum lp_function_minus1(PG_FUNCTION_ARGS)
+static lpAggstate * internal_lp_function_sum_create(void)
 {
-	pg_LPfunction * p1 = PG_ARGISNULL(0) ? (pg_LPfunction *)&LPfunction_EMPTY
-										  : PG_GETARG_LPfunction(0);
+	lpAggstate *state = palloc0(sizeof(lpAggstate));
 
-	PG_RETURN_LPfunction(internal_lp_function_mul(p1,-1));
+	state->strategy = LP_AGG_SORTED;
+	state->minVarNr = INT_MAX;
+	state->maxVarNr = INT_MIN;
+	state->maxTerms = LP_AGG_SORTED_TERMS;
+	state->sorted = true;
+	state->terms = palloc(sizeof(lpTerm) * LP_AGG_SORTED_TERMS);
+
+	return state;
 }
 
-extern Datum lp_function_sum_trans(PG_FUNCTION_ARGS)
+/* Adds a term with the strategy of the state, switching the strategy if needed */
+static inline void internal_lp_function_sum_add(lpAggstate * state, lpTerm * term)
 {
-	MemoryContext aggcontext;
-	lpAggstate * state;
-
-	if (!AggCheckCallContext(fcinfo, &aggcontext))
-		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								errmsg("lp_function_sum_trans() - must call from aggregate")));
-
-	state = PG_ARGISNULL(0) ? NULL : (lpAggstate *) PG_GETARG_BYTEA_P(0);
+	state->minVarNr = Min(state->minVarNr, term->varNr);
+	state->maxVarNr = Max(state->maxVarNr, term->varNr);
 
-	/* Discard NULL values of arg1 */
-	if (!PG_ARGISNULL(1))
+	switch (state->strategy)
 	{
-		pg_LPfunction	* func = PG_GETARG_LPfunction(1);
-		MemoryContext 	old_context;
+		case LP_AGG_SORTED:
+			if (internal_lp_function_sum_sorted_add(state, term))
+				break;
 
-		/* Create a hash in the aggcontext so that it persist between function calls */
-		old_context = MemoryContextSwitchTo(aggcontext);
-		state = internal_lp_function_sum_trans(state, func);
-		MemoryContextSwitchTo(old_context);
+			/* The buffer is full, so select the strategy on the variable numbers seen */
+			if (internal_lp_function_sum_compact(state->minVarNr, state->maxVarNr, state->numTerms + 1))
+			{
+				internal_lp_function_sum_to_array(state);
+				if (internal_lp_function_sum_array_add(state, term))
+					break;
+			}
+			internal_lp_function_sum_to_hash(state);
+			internal_lp_function_sum_hash_add(state, term);
+			break;
+		case LP_AGG_ARRAY:
+			if (internal_lp_function_sum_array_add(state, term))
+				break;
+			internal_lp_function_sum_to_hash(state);
+			internal_lp_function_sum_hash_add(state, term);
+			break;
+		case LP_AGG_HASH:
+			internal_lp_function_sum_hash_add(state, term);
+			break;
 	}
+}
 
-	if (state != NULL)
-		PG_RETURN_BYTEA_P(state);
+static inline lpAggstate * internal_lp_function_sum_trans(lpAggstate * state, pg_LPfunction * next)
+{
+	int 			i;
 
-	PG_RETURN_NULL();
+	/* Create a state */
+	if (state == NULL)
+		state = internal_lp_function_sum_create();
+
+	/* Add all terms from next */
+	state->factor0 += next->factor0;
+	for (i = 0; i < next->numTerms; i++)
+		internal_lp_function_sum_add(state, &next->term[i]);
+
+	return state;
 }
 
-extern Datum lp_function_sum_final(PG_FUNCTION_ARGS)
+/* Adds the terms of "other" to the state. Creates the state, if it is NULL. */
+static lpAggstate * internal_lp_function_sum_combine(lpAggstate * state, lpAggstate * other)
 {
-	lpAggstate * state;
+	int i;
 
-	if (!AggCheckCallContext(fcinfo, NULL))
-		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								errmsg("lp_function_sum_final() - must call from aggregate")));
+	if (state == NULL)
+		state = internal_lp_function_sum_create();
+
+	state->factor0 += other->factor0;
+	if (other->strategy == LP_AGG_ARRAY)
+	{
+		for (i = 0; i <= other->fillTo - other->fillFrom; i++)
+			if (other->present[i])
+			{
+				lpTerm term;
 
-	state = PG_ARGISNULL(0) ? NULL : (lpAggstate *) PG_GETARG_BYTEA_P(0);
+				term.varNr = other->fillFrom + i;
+				term.factor = other->factarray[i];
+				internal_lp_function_sum_add(state, &term);
+			}
+	}
+	else
+		for (i = 0; i < other->numTerms; i++)
+			internal_lp_function_sum_add(state, &other->terms[i]);
 
-	PG_RETURN_LPfunction (internal_lp_function_sum_final(state, true));
+	return state;
 }
 
-/* *************************** Experimental functions *********************** */
+/* Frees the state */
+static void internal_lp_function_sum_free(lpAggstate * state)
+{
+	if (state->terms != NULL)
+		pfree(state->terms);
+	if (state->slots != NULL)
+		pfree(state->slots);
+	if (state->factarray != NULL)
+		pfree(state->factarray);
+	if (state->present != NULL)
+		pfree(state->present);
+	pfree(state);
+}
 
-/*
- * Routines for adding two LPfunctions where variables sorted on variable numbers.
- * There are significantly slowed than HASH-based routines
- * */
-extern pg_LPfunction * internal_lp_function_plus_sorted(pg_LPfunction * p1, pg_LPfunction * p2)
+/* Writes the aggregated terms into "terms", ascending on varNr */
+static void internal_lp_function_sum_terms(lpAggstate * state, lpTerm * terms)
 {
-	// Pesimistic size of result
-	pg_LPfunction * result = (pg_LPfunction *) palloc(LPfunction_SIZE(p1->numTerms + p2->numTerms));
-	int i=0, j=0;
+	if (state->strategy == LP_AGG_ARRAY)
+	{
+		int i, n = 0;
 
-	// Check if concatenation of terms is sufficient
-	if (p1->numTerms == 0)
-		memcpy(result, p2, VARSIZE(p2));
-	else if (p2->numTerms == 0)
-		memcpy(result, p1, VARSIZE(p1));
-	else if (p1->term[p1->numTerms-1].varNr < p2->term[0].varNr)
-	{ /* We can concatenate p1 and p2 */
-		result->numTerms = p1->numTerms + p2->numTerms;
-		memcpy(result->term, p1->term, sizeof(lpTerm) * p1->numTerms);
-		memcpy((result->term +p1->numTerms), p2->term, sizeof(lpTerm) * p2->numTerms);
-	} else if (p2->term[p2->numTerms-1].varNr < p1->term[0].varNr)
-	{ /* We can concatenate p2 and p1 */
-		result->numTerms = p1->numTerms + p2->numTerms;
-		memcpy(result->term, p2->term, sizeof(lpTerm) * p2->numTerms);
-		memcpy((result->term + p2->numTerms), p1->term, sizeof(lpTerm) * p1->numTerms);
-	} else { /*  Otherwise, let's merge terms */
-		result->numTerms = 0;
-		while ((i < p1->numTerms) || (j < p2->numTerms))
-			if (i >= p1->numTerms
-					|| ((j < p2->numTerms)
-							&& (p1->term[i].varNr > p2->term[j].varNr))) {
-				result->term[result->numTerms] = p2->term[j];
-				result->numTerms++;
-				j++;
-			} else if (j >= p2->numTerms
-					|| p1->term[i].varNr < p2->term[j].varNr) {
-				result->term[result->numTerms] = p1->term[i];
-				result->numTerms++;
-				i++;
-			} else		// When varNr's are equal
+		for (i = 0; i <= state->fillTo - state->fillFrom; i++)
+			if (state->present[i])
 			{
-				result->term[result->numTerms] = p1->term[i];
-				result->term[result->numTerms].factor += p2->term[j].factor;
-				result->numTerms++;
-				i++;
-				j++;
+				terms[n].varNr = state->fillFrom + i;
+				terms[n].factor = state->factarray[i];
+				n++;
 			}
-		// Finally, release the unused memory
-		result = repalloc(result, LPfunction_SIZE(result->numTerms));
 	}
+	else
+	{
+		memcpy(terms, state->terms, sizeof(lpTerm) * state->numTerms);
+
+		/* The terms of the hash table come in the order of their first occurrence, which is mostly ascending already */
+		if (!state->sorted)
+			qsort(terms, state->numTerms, sizeof(lpTerm), compareTerms);
+	}
+}
 
-	/* Finally compute the sum of free residuals */
-	result->factor0 = p1->factor0 + p2->factor0;
-	SET_VARSIZE(result, LPfunction_SIZE(result->numTerms));
+/*
+ * Builds a function of the aggregated terms, ascending on varNr. The state is kept, as the final function
+ * of an aggregate can be called several times (e.g., in a window).
+ */
+static inline pg_LPfunction * internal_lp_function_sum_final(lpAggstate * state) {
+	pg_LPfunction * result = NULL;
+
+	if (state != NULL) {
+		result = (pg_LPfunction *) palloc(LPfunction_SIZE(state->numTerms));
+
+		result->factor0 = state->factor0;
+		result->numTerms = state->numTerms;
+		internal_lp_function_sum_terms(state, result->term);
+		SET_VARSIZE(result, LPfunction_SIZE(result->numTerms));
+	}
 
 	return result;
 }
 
-Datum lp_function_plus_sorted(PG_FUNCTION_ARGS)
+extern pg_LPfunction * internal_lp_function_plus(pg_LPfunction * p1, pg_LPfunction * p2)
 {
-	pg_LPfunction * p1 = PG_ARGISNULL(0) ? (pg_LPfunction *)&LPfunction_EMPTY
-									  : PG_GETARG_LPfunction(0);
-	pg_LPfunction * p2 = PG_ARGISNULL(1) ? (pg_LPfunction *)&LPfunction_EMPTY
-									  : PG_GETARG_LPfunction(1);
+	lpAggstate * state;
+	pg_LPfunction * result;
 
-	PG_RETURN_LPfunction(internal_lp_function_plus_sorted(p1,p2));
+	state = internal_lp_function_sum_trans(NULL, p1);
+	state = internal_lp_function_sum_trans(state, p2);
+	result = internal_lp_function_sum_final(state);
+	internal_lp_function_sum_free(state);
+
+	return result;
 }
 
-/* ************** ARRAY-based aggregation **************************** */
-extern Datum lp_function_sum_array_trans(PG_FUNCTION_ARGS)
-{
-	MemoryContext 			aggcontext;
-	lpAggArrayState 		* state;
+/* ************************* Expanded lp_function ************************ */
 
-	if (!AggCheckCallContext(fcinfo, &aggcontext))
-		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-								errmsg("lp_function_sum_array_trans() - must call from aggregate")));
+#define LP_EXPANDED_MAX_TERMS	((int) ((MaxAllocSize - LPfunction_SIZE(0)) / sizeof(lpTerm)))
 
-	state = PG_ARGISNULL(0) ? NULL : (lpAggArrayState *) PG_GETARG_BYTEA_P(0);
+/* The terms of an argument of the operators, flat or expanded */
+typedef struct lpFunctionArg
+{
+	pg_LPfunction	   *flat;			/* The flat function, or NULL if expanded */
+	ExpandedLPfunction *expanded;		/* The expanded function, or NULL if flat */
+	double				factor0;
+	int					numTerms;
+	lpTerm			   *terms;			/* The terms of a flat function (see "lp_function_arg_terms") */
+} lpFunctionArg;
+
+static Size lp_function_expanded_get_flat_size(ExpandedObjectHeader * eohptr);
+static void lp_function_expanded_flatten_into(ExpandedObjectHeader * eohptr, void * result, Size allocated_size);
+static void lp_function_expanded_deleted(void * arg);
+static void lp_function_expanded_arena_deleted(void * arg);
+
+static const ExpandedObjectMethods LPfunction_expanded_methods =
+{
+	lp_function_expanded_get_flat_size,
+	lp_function_expanded_flatten_into
+};
 
-	/* Discard NULL values of arg1 */
-	if (!PG_ARGISNULL(1))
+/* Creates an arena for "maxTerms" terms owned by a function, in a child of the memory context of the function */
+static lpTermArena * lp_function_arena_create(ExpandedLPfunction * efunc, int64 maxTerms)
+{
+	MemoryContext	arenacxt;
+	lpTermArena	   *arena;
+
+	arenacxt = AllocSetContextCreate(efunc->hdr.eoh_context, "lp_function arena", ALLOCSET_SMALL_MINSIZE,
+									 ALLOCSET_SMALL_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+	arena = (lpTermArena *) MemoryContextAlloc(arenacxt, sizeof(lpTermArena));
+	arena->context = arenacxt;
+	arena->owner = efunc;
+	dlist_init(&arena->borrowers);
+	arena->maxTerms = (int) Min(Max(maxTerms, LP_EXPANDED_MIN_TERMS), LP_EXPANDED_MAX_TERMS);
+	arena->terms = MemoryContextAllocHuge(arenacxt, sizeof(lpTerm) * arena->maxTerms);
+	arena->callback.func = lp_function_expanded_arena_deleted;
+	arena->callback.arg = arena;
+	MemoryContextRegisterResetCallback(arenacxt, &arena->callback);
+
+	return arena;
+}
+
+/* Creates an empty expanded function without an arena, in a child of the current memory context */
+static ExpandedLPfunction * lp_function_expanded_new(void)
+{
+	MemoryContext			objcxt;
+	ExpandedLPfunction	   *efunc;
+
+	objcxt = AllocSetContextCreate(CurrentMemoryContext, "expanded lp_function", ALLOCSET_SMALL_MINSIZE,
+								   ALLOCSET_SMALL_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+	efunc = (ExpandedLPfunction *) MemoryContextAlloc(objcxt, sizeof(ExpandedLPfunction));
+	EOH_init_header(&efunc->hdr, &LPfunction_expanded_methods, objcxt);
+
+	efunc->eo_magic = LP_EXPANDED_MAGIC;
+	efunc->factor0 = 0;
+	efunc->numTerms = 0;
+	efunc->normalized = true;
+	efunc->arena = NULL;
+	efunc->callback.func = lp_function_expanded_deleted;
+	efunc->callback.arg = efunc;
+	MemoryContextRegisterResetCallback(objcxt, &efunc->callback);
+
+	return efunc;
+}
+
+/* Creates an empty expanded function with an arena for "maxTerms" terms, in a child of the current memory context */
+static ExpandedLPfunction * lp_function_expanded_create(int64 maxTerms)
+{
+	ExpandedLPfunction * efunc = lp_function_expanded_new();
+
+	efunc->arena = lp_function_arena_create(efunc, maxTerms);
+
+	return efunc;
+}
+
+/* Returns the expanded function of a datum, or NULL for a flat function */
+static inline ExpandedLPfunction * lp_function_expanded_get(Datum d)
+{
+	ExpandedLPfunction * efunc;
+
+	if (!VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(d)))
+		return NULL;
+
+	efunc = (ExpandedLPfunction *) DatumGetEOHP(d);
+	Assert(efunc->eo_magic == LP_EXPANDED_MAGIC);
+	return efunc;
+}
+
+/* Returns the arena holding the terms of a function (see "lp_function_expanded_privatize") */
+static inline lpTermArena * lp_function_expanded_arena(ExpandedLPfunction * efunc)
+{
+	if (efunc->arena == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("SolverLP: the terms of an lp_function were lost for lack of memory")));
+	return efunc->arena;
+}
+
+/* Returns the terms of an argument of the operators */
+static inline lpTerm * lp_function_arg_terms(lpFunctionArg * arg)
+{
+	return arg->expanded != NULL ? lp_function_expanded_arena(arg->expanded)->terms : arg->terms;
+}
+
+/*
+ * Gives a function reading a prefix of the arena of another function its own copy of the terms. In the callback
+ * of a deleted arena ("no_oom"), nothing may be thrown: if the copy cannot be allocated, the terms are lost, and
+ * the function raises an error when it is read.
+ */
+static void lp_function_expanded_privatize(ExpandedLPfunction * efunc, bool no_oom)
+{
+	lpTermArena	   *from = efunc->arena;
+	lpTermArena	   *arena;
+	int				maxTerms = Max(efunc->numTerms, LP_EXPANDED_MIN_TERMS);
+
+	Assert(from != NULL && from->owner != efunc);
+
+	if (!no_oom)
+		arena = lp_function_arena_create(efunc, maxTerms);
+	else
+	{
+		/* Such an arena stays in the memory context of the function, thus it is not taken over */
+		arena = (lpTermArena *) MemoryContextAllocExtended(efunc->hdr.eoh_context, sizeof(lpTermArena),
+														   MCXT_ALLOC_NO_OOM);
+		if (arena != NULL)
+		{
+			arena->terms = (lpTerm *) MemoryContextAllocExtended(efunc->hdr.eoh_context, sizeof(lpTerm) * maxTerms,
+																 MCXT_ALLOC_HUGE | MCXT_ALLOC_NO_OOM);
+			if (arena->terms == NULL)
+			{
+				pfree(arena);
+				arena = NULL;
+			}
+		}
+		if (arena != NULL)
+		{
+			arena->context = NULL;
+			arena->owner = efunc;
+			dlist_init(&arena->borrowers);
+			arena->maxTerms = maxTerms;
+		}
+	}
+
+	if (arena != NULL)
+		memcpy(arena->terms, from->terms, sizeof(lpTerm) * efunc->numTerms);
+	dlist_delete(&efunc->borrower);
+	efunc->arena = arena;
+}
+
+/* Prepares a function to change its terms in place. The functions reading a prefix of them get their own copy. */
+static void lp_function_expanded_own(ExpandedLPfunction * efunc)
+{
+	lpTermArena		   *arena = lp_function_expanded_arena(efunc);
+	dlist_mutable_iter	iter;
+
+	if (arena->owner != efunc)
+	{
+		lp_function_expanded_privatize(efunc, false);
+		return;
+	}
+
+	dlist_foreach_modify(iter, &arena->borrowers)
+		lp_function_expanded_privatize(dlist_container(ExpandedLPfunction, borrower, iter.cur), false);
+}
+
+/* A function is deleted. It stops reading the arena of another function. */
+static void lp_function_expanded_deleted(void * arg)
+{
+	ExpandedLPfunction * efunc = (ExpandedLPfunction *) arg;
+
+	if (efunc->arena != NULL && efunc->arena->owner != efunc)
+		dlist_delete(&efunc->borrower);
+}
+
+/* An arena is deleted with its owner. The functions still reading a prefix of it get their own copy. */
+static void lp_function_expanded_arena_deleted(void * arg)
+{
+	lpTermArena		   *arena = (lpTermArena *) arg;
+	dlist_mutable_iter	iter;
+
+	/* The owner is deleted too, after its children */
+	arena->owner->arena = NULL;
+
+	dlist_foreach_modify(iter, &arena->borrowers)
+		lp_function_expanded_privatize(dlist_container(ExpandedLPfunction, borrower, iter.cur), true);
+}
+
+/* Can the arena of a read-only function be taken over (see "lp_function_expanded_take_over")? */
+static inline bool lp_function_expanded_can_take_over(ExpandedLPfunction * efunc)
+{
+	return efunc->arena != NULL && efunc->arena->owner == efunc && efunc->arena->context != NULL;
+}
+
+/*
+ * Creates a function with the value of a read-only function, taking over its arena. The read-only function keeps
+ * reading its terms, a prefix of the arena, as the new function only appends to the arena. Thus, f := f + x in
+ * PL/pgSQL, where "f" is passed read-only, extends the terms of "f" instead of copying them.
+ */
+static ExpandedLPfunction * lp_function_expanded_take_over(ExpandedLPfunction * from)
+{
+	ExpandedLPfunction *efunc = lp_function_expanded_new();
+	lpTermArena		   *arena = from->arena;
+
+	MemoryContextSetParent(arena->context, efunc->hdr.eoh_context);
+	arena->owner = efunc;
+	dlist_push_tail(&arena->borrowers, &from->borrower);
+
+	efunc->arena = arena;
+	efunc->factor0 = from->factor0;
+	efunc->numTerms = from->numTerms;
+	efunc->normalized = from->normalized;
+
+	return efunc;
+}
+
+/*
+ * Merges the repeated variables and sorts the terms on varNr. The factors of a variable are added in the order of
+ * the terms, as the flat additions do. The value of the function stays, thus read-only functions are normalized too.
+ */
+static void lp_function_expanded_normalize(ExpandedLPfunction * efunc)
+{
+	MemoryContext	oldcontext;
+	lpAggstate	   *state;
+	lpTerm		   *terms;
+	int				i;
+
+	if (efunc->normalized)
+		return;
+
+	lp_function_expanded_own(efunc);
+	terms = efunc->arena->terms;
+
+	oldcontext = MemoryContextSwitchTo(efunc->hdr.eoh_context);
+	state = internal_lp_function_sum_create();
+	for (i = 0; i < efunc->numTerms; i++)
+		internal_lp_function_sum_add(state, &terms[i]);
+
+	/* The merged terms fit the arena */
+	internal_lp_function_sum_terms(state, terms);
+	efunc->numTerms = state->numTerms;
+	efunc->normalized = true;
+
+	internal_lp_function_sum_free(state);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/* Makes room for "numTerms" more terms in the arena, at least doubling it. The function must own the arena. */
+static void lp_function_expanded_reserve(ExpandedLPfunction * efunc, int64 numTerms)
+{
+	lpTermArena	   *arena;
+	int64			maxTerms;
+
+	if (lp_function_expanded_arena(efunc)->owner != efunc)
+		lp_function_expanded_privatize(efunc, false);
+	arena = efunc->arena;
+
+	if (efunc->numTerms + numTerms <= arena->maxTerms)
+		return;
+
+	/* The flat function must fit in a varlena, so try merging the variables first */
+	if (efunc->numTerms + numTerms > LP_EXPANDED_MAX_TERMS)
+	{
+		lp_function_expanded_normalize(efunc);
+		if (efunc->numTerms + numTerms > LP_EXPANDED_MAX_TERMS)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("SolverLP: too many terms in lp_function")));
+		if (efunc->numTerms + numTerms <= arena->maxTerms)
+			return;
+	}
+
+	maxTerms = Min(Max((int64) arena->maxTerms * 2, efunc->numTerms + numTerms), LP_EXPANDED_MAX_TERMS);
+	arena->terms = repalloc_huge(arena->terms, sizeof(lpTerm) * maxTerms);
+	arena->maxTerms = (int) maxTerms;
+}
+
+/* Appends "factor" times the terms of a function to the arena, in place */
+static void lp_function_expanded_append(ExpandedLPfunction * efunc, lpFunctionArg * arg, double factor)
+{
+	lpTerm *src;
+	lpTerm *terms;
+	lpTerm *term;
+	int		i;
+
+	lp_function_expanded_reserve(efunc, arg->numTerms);
+
+	/* The arena may have moved, and it may hold the terms of the argument too */
+	src = lp_function_arg_terms(arg);
+	terms = efunc->arena->terms;
+
+	efunc->factor0 += arg->factor0 * factor;
+	term = terms + efunc->numTerms;
+	for (i = 0; i < arg->numTerms; i++, term++)
+	{
+		term->varNr = src[i].varNr;
+		term->factor = src[i].factor * factor;
+
+		/* The terms stay normalized while they come ascending */
+		if (efunc->normalized && term != terms && term[-1].varNr >= term->varNr)
+			efunc->normalized = false;
+	}
+	efunc->numTerms += arg->numTerms;
+}
+
+/*
+ * Inserts the terms of a function before the terms of the arena, in place, so that the terms stay in the order of
+ * the arguments (e.g., the factors of a variable in a + b are added as a's then b's).
+ */
+static void lp_function_expanded_prepend(ExpandedLPfunction * efunc, lpFunctionArg * arg)
+{
+	lpTerm *src;
+	lpTerm *terms;
+	int		i;
+
+	lp_function_expanded_own(efunc);
+	lp_function_expanded_reserve(efunc, arg->numTerms);
+
+	efunc->factor0 = arg->factor0 + efunc->factor0;
+	if (arg->numTerms == 0)
+		return;
+
+	src = lp_function_arg_terms(arg);
+	terms = efunc->arena->terms;
+	memmove(terms + arg->numTerms, terms, sizeof(lpTerm) * efunc->numTerms);
+	memcpy(terms, src, sizeof(lpTerm) * arg->numTerms);
+
+	/* The terms stay normalized if the arguments are and their variables come ascending */
+	for (i = 1; i < arg->numTerms && efunc->normalized; i++)
+		if (terms[i - 1].varNr >= terms[i].varNr)
+			efunc->normalized = false;
+	if (efunc->numTerms > 0 && terms[arg->numTerms - 1].varNr >= terms[arg->numTerms].varNr)
+		efunc->normalized = false;
+	efunc->numTerms += arg->numTerms;
+}
+
+/* Multiplies the function by "factor", in place */
+static void lp_function_expanded_scale(ExpandedLPfunction * efunc, double factor)
+{
+	lpTerm *terms;
+	int		i;
+
+	/* As for flat functions, the variables are merged before scaling */
+	lp_function_expanded_own(efunc);
+	lp_function_expanded_normalize(efunc);
+
+	terms = efunc->arena->terms;
+	for (i = 0; i < efunc->numTerms; i++)
+		terms[i].factor *= factor;
+	efunc->factor0 *= factor;
+}
+
+static Size lp_function_expanded_get_flat_size(ExpandedObjectHeader * eohptr)
+{
+	ExpandedLPfunction * efunc = (ExpandedLPfunction *) eohptr;
+
+	Assert(efunc->eo_magic == LP_EXPANDED_MAGIC);
+
+	/* The flat function is normalized, as the functions built by the flat operators */
+	lp_function_expanded_normalize(efunc);
+
+	return LPfunction_SIZE(efunc->numTerms);
+}
+
+static void lp_function_expanded_flatten_into(ExpandedObjectHeader * eohptr, void * result, Size allocated_size)
+{
+	ExpandedLPfunction * efunc = (ExpandedLPfunction *) eohptr;
+	pg_LPfunction	   * func = (pg_LPfunction *) result;
+
+	Assert(efunc->eo_magic == LP_EXPANDED_MAGIC);
+	Assert(efunc->normalized && allocated_size == LPfunction_SIZE(efunc->numTerms));
+
+	MemSet(func, 0, LPfunction_SIZE(0));
+	SET_VARSIZE(func, allocated_size);
+	func->factor0 = efunc->factor0;
+	func->numTerms = efunc->numTerms;
+	memcpy(func->term, lp_function_expanded_arena(efunc)->terms, sizeof(lpTerm) * efunc->numTerms);
+}
+
+/*
+ * Gets the terms of an argument, without flattening an expanded function. The terms of an expanded function are
+ * taken as they are, thus they are normalized lazily, when the result is. NULL is an empty function.
+ */
+static void lp_function_get_arg(FunctionCallInfo fcinfo, int argno, lpFunctionArg * arg)
+{
+	ExpandedLPfunction * efunc = PG_ARGISNULL(argno) ? NULL : lp_function_expanded_get(PG_GETARG_DATUM(argno));
+
+	if (efunc != NULL)
+	{
+		arg->flat = NULL;
+		arg->expanded = efunc;
+		arg->factor0 = efunc->factor0;
+		arg->numTerms = efunc->numTerms;
+		arg->terms = NULL;
+	}
+	else
+	{
+		arg->flat = PG_ARGISNULL(argno) ? (pg_LPfunction *) &LPfunction_EMPTY : PG_GETARG_LPfunction(argno);
+		arg->expanded = NULL;
+		arg->factor0 = arg->flat->factor0;
+		arg->numTerms = arg->flat->numTerms;
+		arg->terms = arg->flat->term;
+	}
+}
+
+/*
+ * Adds "factor" times the second argument to the first one. A read-write expanded argument (e.g., the result of
+ * the previous operator of an expression) is extended in place, and a sum of LP_EXPANDED_MIN_TERMS terms or more
+ * is returned expanded. Thus, a chain of additions, such as a*x + b*y + c*z + ..., takes linear time. A read-only
+ * expanded first argument passes its arena over to the sum (see "lp_function_expanded_take_over"), thus a loop of
+ * f := f + x in PL/pgSQL takes linear time too.
+ */
+static Datum internal_lp_function_add(FunctionCallInfo fcinfo, double factor)
+{
+	Datum				d1 = PG_GETARG_DATUM(0);
+	Datum				d2 = PG_GETARG_DATUM(1);
+	ExpandedLPfunction *result;
+	ExpandedLPfunction *from;
+	lpFunctionArg		arg1, arg2;
+	bool				same;
+
+	/* An object passed twice (e.g., x + x) is not changed in place */
+	from = PG_ARGISNULL(0) ? NULL : lp_function_expanded_get(d1);
+	same = from != NULL && !PG_ARGISNULL(1) && from == lp_function_expanded_get(d2);
+
+	if (!same && DatumIsReadWriteExpandedObject(d1, PG_ARGISNULL(0), -1))
+	{
+		result = (ExpandedLPfunction *) DatumGetEOHP(d1);
+		lp_function_get_arg(fcinfo, 1, &arg2);
+		lp_function_expanded_append(result, &arg2, factor);
+	}
+	else if (!same && DatumIsReadWriteExpandedObject(d2, PG_ARGISNULL(1), -1))
+	{
+		/*
+		 * The first argument is inserted before the terms of the second one, which are merged first. Thus, the
+		 * factors of a variable are added from left to right, as in the flat addition.
+		 */
+		result = (ExpandedLPfunction *) DatumGetEOHP(d2);
+		if (factor != 1.0)
+			lp_function_expanded_scale(result, factor);
+		else
+			lp_function_expanded_normalize(result);
+		lp_function_get_arg(fcinfo, 0, &arg1);
+		lp_function_expanded_prepend(result, &arg1);
+	}
+	else if (!same && from != NULL && lp_function_expanded_can_take_over(from))
+	{
+		result = lp_function_expanded_take_over(from);
+		lp_function_get_arg(fcinfo, 1, &arg2);
+		lp_function_expanded_append(result, &arg2, factor);
+	}
+	else
+	{
+		lp_function_get_arg(fcinfo, 0, &arg1);
+		lp_function_get_arg(fcinfo, 1, &arg2);
+
+		/* Short functions are added flat */
+		if (arg1.flat != NULL && arg2.flat != NULL && arg1.numTerms + arg2.numTerms < LP_EXPANDED_MIN_TERMS)
+			PG_RETURN_LPfunction(internal_lp_function_plus(arg1.flat, factor == 1.0 ? arg2.flat
+																			   : internal_lp_function_mul(arg2.flat, factor)));
+
+		/* A read-only expanded function, which cannot be taken over, is copied as it is, without merging */
+		result = lp_function_expanded_create((int64) arg1.numTerms + arg2.numTerms);
+		lp_function_expanded_append(result, &arg1, 1.0);
+		lp_function_expanded_append(result, &arg2, factor);
+	}
+
+	PG_RETURN_DATUM(EOHPGetRWDatum(&result->hdr));
+}
+
+/* Multiplies an argument by "factor". A read-write expanded argument is scaled in place. NULL is an empty function. */
+static Datum internal_lp_function_scale(FunctionCallInfo fcinfo, int argno, double factor)
+{
+	Datum d = PG_GETARG_DATUM(argno);
+
+	if (DatumIsReadWriteExpandedObject(d, PG_ARGISNULL(argno), -1))
+	{
+		lp_function_expanded_scale((ExpandedLPfunction *) DatumGetEOHP(d), factor);
+		PG_RETURN_DATUM(d);
+	}
+
+	PG_RETURN_LPfunction(internal_lp_function_mul(PG_ARGISNULL(argno) ? (pg_LPfunction *) &LPfunction_EMPTY
+																	  : PG_GETARG_LPfunction(argno), factor));
+}
+
+Datum lp_function_plus(PG_FUNCTION_ARGS)
+{
+	return internal_lp_function_add(fcinfo, 1.0);
+}
+
+
+extern Datum lp_function_minus(PG_FUNCTION_ARGS)
+{
+	return internal_lp_function_add(fcinfo, -1.0);
+}
+
+/* Unary version of minus */
+extern Datum lp_function_minus1(PG_FUNCTION_ARGS)
+{
+	return internal_lp_function_scale(fcinfo, 0, -1.0);
+}
+
+extern Datum lp_function_sum_trans(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	lpAggstate * state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_trans() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggstate *) PG_GETARG_POINTER(0);
+
+	/* Discard NULL values of arg1 */
+	if (!PG_ARGISNULL(1))
+	{
+		pg_LPfunction	* func = PG_GETARG_LPfunction(1);
+		MemoryContext 	old_context;
+
+		/* Create a state in the aggcontext so that it persist between function calls */
+		old_context = MemoryContextSwitchTo(aggcontext);
+		state = internal_lp_function_sum_trans(state, func);
+		MemoryContextSwitchTo(old_context);
+	}
+
+	if (state != NULL)
+		PG_RETURN_POINTER(state);
+
+	PG_RETURN_NULL();
+}
+
+extern Datum lp_function_sum_final(PG_FUNCTION_ARGS)
+{
+	lpAggstate * state;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_final() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggstate *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_LPfunction (internal_lp_function_sum_final(state));
+}
+
+/* Combines the states of the partial aggregations (e.g., of parallel workers) */
+extern Datum lp_function_sum_combine(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	lpAggstate * state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_combine() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggstate *) PG_GETARG_POINTER(0);
+
+	if (!PG_ARGISNULL(1))
+	{
+		MemoryContext 	old_context;
+
+		/* The other state may be short-lived (e.g., deserialized), so its terms are copied into the aggcontext */
+		old_context = MemoryContextSwitchTo(aggcontext);
+		state = internal_lp_function_sum_combine(state, (lpAggstate *) PG_GETARG_POINTER(1));
+		MemoryContextSwitchTo(old_context);
+	}
+
+	if (state != NULL)
+		PG_RETURN_POINTER(state);
+
+	PG_RETURN_NULL();
+}
+
+/* Serializes the state as the lp_function of its terms */
+extern Datum lp_function_sum_serialize(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_serialize() - must call from aggregate")));
+
+	PG_RETURN_BYTEA_P (internal_lp_function_sum_final((lpAggstate *) PG_GETARG_POINTER(0)));
+}
+
+/* Deserializes the state from the lp_function of its terms */
+extern Datum lp_function_sum_deserialize(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_deserialize() - must call from aggregate")));
+
+	PG_RETURN_POINTER (internal_lp_function_sum_trans(NULL, DatumGetLPfunction(PG_GETARG_DATUM(0))));
+}
+
+/* Moving aggregation routines, used by the sliding window frames (see lpAggMovingState)
+ * */
+
+/* Doubles the table of the moving state, and puts the terms into it */
+static void internal_lp_function_msum_grow(lpAggMovingState * state)
+{
+	lpAggMovingTerm	*old = state->slots;
+	int				oldSize = 1 << state->slotBits;
+	int				bits = state->slotBits + 1;
+	int				mask = (1 << bits) - 1;
+	int				i;
+
+	if (bits > LP_AGG_MAX_SLOT_BITS)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("SolverLP: too many variables in lp_function aggregation")));
+
+	state->slots = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(lpAggMovingTerm) << bits);
+	MemSet(state->slots, 0, sizeof(lpAggMovingTerm) << bits);
+	state->slotBits = bits;
+
+	for (i = 0; i < oldSize; i++)
+		if (old[i].count != 0)
+		{
+			int slot = LP_AGG_SLOT(old[i].varNr, bits);
+
+			while (state->slots[slot].count != 0)
+				slot = (slot + 1) & mask;
+			state->slots[slot] = old[i];
+		}
+	pfree(old);
+}
+
+/* Adds the terms of the function to the moving state. Creates the state, if it is NULL. */
+static lpAggMovingState * internal_lp_function_msum_trans(lpAggMovingState * state, pg_LPfunction * next)
+{
+	int i;
+
+	if (state == NULL)
+	{
+		state = palloc0(sizeof(lpAggMovingState));
+		state->slotBits = LP_AGG_MIN_SLOT_BITS;
+		state->slots = palloc0(sizeof(lpAggMovingTerm) << LP_AGG_MIN_SLOT_BITS);
+	}
+
+	state->factor0 += next->factor0;
+	state->numFunctions++;
+	for (i = 0; i < next->numTerms; i++)
+	{
+		int		mask = (1 << state->slotBits) - 1;
+		int		slot = LP_AGG_SLOT(next->term[i].varNr, state->slotBits);
+
+		while (state->slots[slot].count != 0 && state->slots[slot].varNr != next->term[i].varNr)
+			slot = (slot + 1) & mask;
+
+		if (state->slots[slot].count != 0)
+		{
+			state->slots[slot].factor += next->term[i].factor;
+			state->slots[slot].count++;
+			continue;
+		}
+
+		state->slots[slot].varNr = next->term[i].varNr;
+		state->slots[slot].factor = next->term[i].factor;
+		state->slots[slot].count = 1;
+		if (++state->numTerms * 2 > mask + 1)
+			internal_lp_function_msum_grow(state);
+	}
+
+	return state;
+}
+
+/* Removes the terms of a function, aggregated before, from the moving state */
+static void internal_lp_function_msum_inv(lpAggMovingState * state, pg_LPfunction * prev)
+{
+	int		mask = (1 << state->slotBits) - 1;
+	int		i;
+
+	state->factor0 -= prev->factor0;
+	state->numFunctions--;
+	for (i = 0; i < prev->numTerms; i++)
+	{
+		int		slot = LP_AGG_SLOT(prev->term[i].varNr, state->slotBits);
+		int		next;
+
+		while (state->slots[slot].count != 0 && state->slots[slot].varNr != prev->term[i].varNr)
+			slot = (slot + 1) & mask;
+
+		if (state->slots[slot].count == 0)
+			elog(ERROR, "SolverLP: variable %d is not in the moving sum", prev->term[i].varNr);
+
+		state->slots[slot].factor -= prev->term[i].factor;
+		if (--state->slots[slot].count > 0)
+			continue;
+
+		/* The variable left the frame. Shift the following terms of the probe sequence back into the slot. */
+		state->numTerms--;
+		for (next = (slot + 1) & mask; state->slots[next].count != 0; next = (next + 1) & mask)
+		{
+			int home = LP_AGG_SLOT(state->slots[next].varNr, state->slotBits);
+
+			/* The term can move, unless its home slot lies cyclically in (slot, next] */
+			if ((next > slot && (home <= slot || home > next)) ||
+				(next < slot && home <= slot && home > next))
+			{
+				state->slots[slot] = state->slots[next];
+				slot = next;
+			}
+		}
+		state->slots[slot].count = 0;
+	}
+}
+
+extern Datum lp_function_msum_trans(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	lpAggMovingState * state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_msum_trans() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggMovingState *) PG_GETARG_POINTER(0);
+
+	/* Discard NULL values of arg1 */
+	if (!PG_ARGISNULL(1))
+	{
+		MemoryContext 	old_context;
+
+		old_context = MemoryContextSwitchTo(aggcontext);
+		state = internal_lp_function_msum_trans(state, PG_GETARG_LPfunction(1));
+		MemoryContextSwitchTo(old_context);
+	}
+
+	if (state != NULL)
+		PG_RETURN_POINTER(state);
+
+	PG_RETURN_NULL();
+}
+
+extern Datum lp_function_msum_inv(PG_FUNCTION_ARGS)
+{
+	lpAggMovingState * state;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_msum_inv() - must call from aggregate")));
+
+	/* A frame of NULLs only has no state yet */
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (lpAggMovingState *) PG_GETARG_POINTER(0);
+
+	if (!PG_ARGISNULL(1))
+		internal_lp_function_msum_inv(state, PG_GETARG_LPfunction(1));
+
+	PG_RETURN_POINTER(state);
+}
+
+/* Builds a function of the terms in the frame, ascending on varNr. Returns NULL for a frame of NULLs only. */
+extern Datum lp_function_msum_final(PG_FUNCTION_ARGS)
+{
+	lpAggMovingState * state;
+	pg_LPfunction * result;
+	int				i, n = 0;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_msum_final() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggMovingState *) PG_GETARG_POINTER(0);
+	if (state == NULL || state->numFunctions == 0)
+		PG_RETURN_NULL();
+
+	result = (pg_LPfunction *) palloc(LPfunction_SIZE(state->numTerms));
+	result->factor0 = state->factor0;
+	result->numTerms = state->numTerms;
+	for (i = 0; i < (1 << state->slotBits); i++)
+		if (state->slots[i].count != 0)
+		{
+			result->term[n].varNr = state->slots[i].varNr;
+			result->term[n].factor = state->slots[i].factor;
+			n++;
+		}
+	Assert(n == state->numTerms);
+
+	qsort(result->term, result->numTerms, sizeof(lpTerm), compareTerms);
+	SET_VARSIZE(result, LPfunction_SIZE(result->numTerms));
+
+	PG_RETURN_LPfunction (result);
+}
+
+/* *************************** Experimental functions *********************** */
+
+/*
+ * Routines for adding two LPfunctions where variables sorted on variable numbers.
+ * There are significantly slowed than HASH-based routines
+ * */
+extern pg_LPfunction * internal_lp_function_plus_sorted(pg_LPfunction * p1, pg_LPfunction * p2)
+{
+	// Pesimistic size of result
+	pg_LPfunction * result = (pg_LPfunction *) palloc(LPfunction_SIZE(p1->numTerms + p2->numTerms));
+	int i=0, j=0;
+
+	// Check if concatenation of terms is sufficient
+	if (p1->numTerms == 0)
+		memcpy(result, p2, VARSIZE(p2));
+	else if (p2->numTerms == 0)
+		memcpy(result, p1, VARSIZE(p1));
+	else if (p1->term[p1->numTerms-1].varNr < p2->term[0].varNr)
+	{ /* We can concatenate p1 and p2 */
+		result->numTerms = p1->numTerms + p2->numTerms;
+		memcpy(result->term, p1->term, sizeof(lpTerm) * p1->numTerms);
+		memcpy((result->term +p1->numTerms), p2->term, sizeof(lpTerm) * p2->numTerms);
+	} else if (p2->term[p2->numTerms-1].varNr < p1->term[0].varNr)
+	{ /* We can concatenate p2 and p1 */
+		result->numTerms = p1->numTerms + p2->numTerms;
+		memcpy(result->term, p2->term, sizeof(lpTerm) * p2->numTerms);
+		memcpy((result->term + p2->numTerms), p1->term, sizeof(lpTerm) * p1->numTerms);
+	} else { /*  Otherwise, let's merge terms */
+		result->numTerms = 0;
+		while ((i < p1->numTerms) || (j < p2->numTerms))
+			if (i >= p1->numTerms
+					|| ((j < p2->numTerms)
+							&& (p1->term[i].varNr > p2->term[j].varNr))) {
+				result->term[result->numTerms] = p2->term[j];
+				result->numTerms++;
+				j++;
+			} else if (j >= p2->numTerms
+					|| p1->term[i].varNr < p2->term[j].varNr) {
+				result->term[result->numTerms] = p1->term[i];
+				result->numTerms++;
+				i++;
+			} else		// When varNr's are equal
+			{
+				result->term[result->numTerms] = p1->term[i];
+				result->term[result->numTerms].factor += p2->term[j].factor;
+				result->numTerms++;
+				i++;
+				j++;
+			}
+		// Finally, release the unused memory
+		result = repalloc(result, LPfunction_SIZE(result->numTerms));
+	}
+
+	/* Finally compute the sum of free residuals */
+	result->factor0 = p1->factor0 + p2->factor0;
+	SET_VARSIZE(result, LPfunction_SIZE(result->numTerms));
+
+	return result;
+}
+
+Datum lp_function_plus_sorted(PG_FUNCTION_ARGS)
+{
+	pg_LPfunction * p1 = PG_ARGISNULL(0) ? (pg_LPfunction *)&LPfunction_EMPTY
+									  : PG_GETARG_LPfunction(0);
+	pg_LPfunction * p2 = PG_ARGISNULL(1) ? (pg_LPfunction *)&LPfunction_EMPTY
+									  : PG_GETARG_LPfunction(1);
+
+	PG_RETURN_LPfunction(internal_lp_function_plus_sorted(p1,p2));
+}
+
+/* ************** HASH-based (dynahash) aggregation **************************** */
+static inline lpAggHashState * internal_lp_function_sum_hash_trans(lpAggHashState * state, pg_LPfunction * next)
+{
+	int 			i;
+	bool            found;
+
+	/* Create a state */
+	if (state == NULL) {
+		HASHCTL		   ctl;
+
+		// Initialize the hash
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(int);
+		ctl.entrysize = sizeof(lpTerm);		// Stores the pointers to double
+		ctl.hash = tag_hash;
+		ctl.hcxt = CurrentMemoryContext;
+
+		state = palloc0(sizeof(lpAggHashState));
+		SET_VARSIZE(state, sizeof(lpAggHashState));
+		state-> factor0 = 0;
+
+		state->hashVnr = hash_create("lp_function hash of variable numbers for efficient aggregation ",
+										1024,  &ctl, HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT );
+
+		/* Take control over hash-tables memory context for performance optimization - see comments below.*/
+		state->htMemCtx = CurrentMemoryContext->firstchild; /* We do this way, as HTAB is incomplete */
+	}
+
+	/* Add all terms from next */
+	state->factor0 += next->factor0;
+	for (i = 0; i < next->numTerms; i++) {
+		lpTerm * term;
+
+		term = (lpTerm *) hash_search(state->hashVnr, &(next->term[i].varNr), HASH_ENTER, &found);
+		if (found)
+			term->factor += next->term[i].factor;
+		else
+			term->factor = next->term[i].factor; /* Key is already inserted */
+	}
+	return state;
+}
+
+static inline pg_LPfunction * internal_lp_function_sum_hash_final(lpAggHashState * state, bool only_reset_hash_context) {
+	pg_LPfunction * result = NULL;
+
+	if (state != NULL && state->hashVnr != NULL) {
+		int numEntries = hash_get_num_entries(state->hashVnr);
+		HASH_SEQ_STATUS seqstatus;
+		int i=0;
+		lpTerm *term;
+
+		result = (pg_LPfunction *) palloc(LPfunction_SIZE(numEntries));
+
+		result->factor0 = state->factor0;
+		result->numTerms = numEntries;
+
+		/* Copy all entries (unsorted) */
+		hash_seq_init(&seqstatus, state->hashVnr);
+
+		while ((term = (lpTerm *) hash_seq_search(&seqstatus)) != NULL)
+			if (i < numEntries)
+				result->term[i++] = *term;
+
+		Assert(i==numEntries);
+
+		/* Sort the indices array */
+		// 2014-08-25 No sorting is required
+		// qsort(result->term, result->numTerms, sizeof(lpTerm), compareTerms);
+		SET_VARSIZE(result, LPfunction_SIZE(result->numTerms));
+
+		// ************ This is an optimization trick. *******
+		// We do not destroy the table. Instead, only free the memory from the hash-table context.
+		// Otherwise, MemoryContextDelete will cause overhead, when thousands of hash tables are created with ORDER BY
+		// TODO: Use a non-PG HASH structure, which does not generate its own memory context
+		if (only_reset_hash_context && state->htMemCtx)
+			MemoryContextReset(state->htMemCtx);
+		else
+		    hash_destroy(state->hashVnr);
+		pfree(state);
+	}
+
+	return result;
+}
+
+
+extern Datum lp_function_sum_hash_trans(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	lpAggHashState * state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_hash_trans() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggHashState *) PG_GETARG_BYTEA_P(0);
+
+	/* Discard NULL values of arg1 */
+	if (!PG_ARGISNULL(1))
+	{
+		pg_LPfunction	* func = PG_GETARG_LPfunction(1);
+		MemoryContext 	old_context;
+
+		/* Create a hash in the aggcontext so that it persist between function calls */
+		old_context = MemoryContextSwitchTo(aggcontext);
+		state = internal_lp_function_sum_hash_trans(state, func);
+		MemoryContextSwitchTo(old_context);
+	}
+
+	if (state != NULL)
+		PG_RETURN_BYTEA_P(state);
+
+	PG_RETURN_NULL();
+}
+
+extern Datum lp_function_sum_hash_final(PG_FUNCTION_ARGS)
+{
+	lpAggHashState * state;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_hash_final() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggHashState *) PG_GETARG_BYTEA_P(0);
+
+	PG_RETURN_LPfunction (internal_lp_function_sum_hash_final(state, true));
+}
+
+/* ************** ARRAY-based aggregation **************************** */
+extern Datum lp_function_sum_array_trans(PG_FUNCTION_ARGS)
+{
+	MemoryContext 			aggcontext;
+	lpAggArrayState 		* state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+		ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+								errmsg("lp_function_sum_array_trans() - must call from aggregate")));
+
+	state = PG_ARGISNULL(0) ? NULL : (lpAggArrayState *) PG_GETARG_BYTEA_P(0);
+
+	/* Discard NULL values of arg1 */
+	if (!PG_ARGISNULL(1))
 	{
 		pg_LPfunction 		* fn = PG_GETARG_LPfunction(1);
 		MemoryContext 		old_context;
@@ -507,8 +1664,7 @@ extern Datum lp_function_sum_array_trans(PG_FUNCTION_ARGS)
 				pfree(state->factarray);
 				state->factarray = newarray;
 				state->fillFrom = state->fillTo - newSize + 1;
-			} else
-				Assert(false);
+			}
 
 		    /* OK, so variable falls into the array range now */
 			state->factarray[varNr - state->fillFrom] += factor;
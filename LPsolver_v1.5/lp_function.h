@@ -12,7 +12,9 @@
 
 #include "lib/stringinfo.h"
 #include "fmgr.h"
+#include "lib/ilist.h"
 #include "nodes/pg_list.h"
+#include "utils/expandeddatum.h"
 #include "utils/hsearch.h"
 
 
@@ -66,25 +68,125 @@ extern Datum lp_function_minus1(PG_FUNCTION_ARGS);
 // Utility funtions
 // Split lp_function expression to individual terms
 extern Datum lp_function_unnest(PG_FUNCTION_ARGS);
+// Microbenchmark of the operators and aggregates (lp_function_bench.c)
+extern Datum lp_function_bench(PG_FUNCTION_ARGS);
 
 // Internal functions
 // A general function for adding two pg_LPfunction instances
 extern pg_LPfunction * internal_lp_function_mul(pg_LPfunction * t, double factor);
 extern pg_LPfunction * internal_lp_function_plus(pg_LPfunction * p1, pg_LPfunction * p2);
 
+/*
+ * The expanded representation of lp_function (see utils/expandeddatum.h), returned by the arithmetic
+ * operators for long functions. The operators append the terms to an arena in place, without merging
+ * the variables. The terms are normalized (merged and ascending on varNr) lazily, when the function
+ * is flattened (i.e., stored, returned to the client or read as pg_LPfunction) or scaled.
+ *
+ * The arena may be shared. A read-only function (e.g., "f" in f := f + x in PL/pgSQL) passes its arena
+ * over to the sum, and keeps reading its own terms, a prefix of the arena, as the owner of the arena only
+ * appends to it. Before the owner changes the terms in place, or the arena is deleted with the owner,
+ * the functions reading a prefix get their own copy.
+ */
+#define LP_EXPANDED_MAGIC		0x4C50464E	/* "LPFN", an ID for debugging crosschecks */
+#define LP_EXPANDED_MIN_TERMS	32			/* The operators build shorter functions flat */
+
+typedef struct lpTermArena
+{
+	MemoryContext	context;		/* The context of the arena, a child of the context of the owner, or NULL if the
+									 * arena is allocated in the context of the owner (and is never passed over) */
+	struct ExpandedLPfunction *owner;	/* The function, which may change the terms */
+	dlist_head		borrowers;		/* The functions reading a prefix of the terms */
+	int				maxTerms;		/* A number of terms allocated for the arena */
+	lpTerm			*terms;
+	MemoryContextCallback callback;	/* Copies the terms of the borrowers, when the arena is deleted */
+} lpTermArena;
+
+typedef struct ExpandedLPfunction
+{
+	ExpandedObjectHeader hdr;		/* The standard header of expanded objects */
+	int				eo_magic;		/* LP_EXPANDED_MAGIC */
+	double			factor0;
+	int				numTerms;		/* A number of terms, a prefix of the arena, possibly with repeated variables */
+	bool			normalized;		/* Are the terms ascending on varNr, with distinct variables? */
+	lpTermArena		*arena;			/* The arena of terms, or NULL if they were lost for lack of memory */
+	dlist_node		borrower;		/* A member of the borrowers of the arena, unless the function owns it */
+	MemoryContextCallback callback;	/* Stops borrowing, when the function is deleted */
+} ExpandedLPfunction;
+
 /* Optimized aggregation functions and all-related structures */
+
+/*
+ * The strategies of the aggregation. It starts with a small sorted buffer of terms. When the buffer
+ * is full, it continues with a dense array if the variable numbers seen are compact relative to the
+ * number of terms, or with a hash table otherwise. An array turning sparse is moved to a hash table.
+ */
+typedef enum lpAggStrategy
+{
+	LP_AGG_SORTED,					/* The terms in the arena, ascending on varNr */
+	LP_AGG_ARRAY,					/* The factors in an array indexed by varNr */
+	LP_AGG_HASH						/* The terms in the arena, found by an open-addressing table */
+} lpAggStrategy;
+
+/*
+ * The state of the aggregation. The sorted buffer and the hash table keep the terms in an arena, which
+ * the hash table extends in the order of the first occurrence of the variables. The hash table is an
+ * open-addressing table of arena positions with linear probing. The arena, the table and the array grow
+ * by doubling, thus no memory is allocated per term. The aggregate passes the state as "internal", and
+ * serializes it as an lp_function to combine the states of parallel workers.
+ */
 typedef struct lpAggstate
 {
-	int32			vl_len_;		/* varlena header (do not touch directly!) */
 	double			factor0;
-	HTAB 			*hashVnr;		/* A pointer to hash mapping VarNr --> lpTerm if a variable exist in "allTerms"  */
-	MemoryContext   htMemCtx;  /* A memory context internally used by a hash table */
+	lpAggStrategy	strategy;
+	int				numTerms;		/* A number of distinct variables */
+	int				minVarNr;		/* The range of the variable numbers seen */
+	int				maxVarNr;
+	/* LP_AGG_SORTED and LP_AGG_HASH */
+	int				maxTerms;		/* A number of terms allocated for the arena */
+	bool			sorted;			/* Are the terms in the arena ascending on varNr? */
+	lpTerm			*terms;			/* The arena of terms */
+	/* LP_AGG_HASH */
+	int				slotBits;		/* The table has 2^slotBits slots */
+	int32			*slots;			/* 1-based positions of the terms in the arena, 0 for an empty slot */
+	/* LP_AGG_ARRAY */
+	int				fillFrom;		/* The range of the variable numbers allocated in the array */
+	int				fillTo;
+	double			*factarray;		/* The factors of the variables fillFrom .. fillTo */
+	bool			*present;		/* Does a variable occur in the aggregated functions? */
 } lpAggstate;
 
 /* These are the state/final function, used to implement the aggregation of large pg_LPfunction */
 
 extern Datum lp_function_sum_trans(PG_FUNCTION_ARGS);
 extern Datum lp_function_sum_final(PG_FUNCTION_ARGS);
+extern Datum lp_function_sum_combine(PG_FUNCTION_ARGS);
+extern Datum lp_function_sum_serialize(PG_FUNCTION_ARGS);
+extern Datum lp_function_sum_deserialize(PG_FUNCTION_ARGS);
+
+/*
+ * The state of the moving aggregation, used by the sliding window frames. The terms are kept in
+ * an open-addressing table with linear probing, with the number of the aggregated functions having
+ * each variable, so that the inverse function removes a variable leaving the frame.
+ */
+typedef struct lpAggMovingTerm
+{
+	int				varNr;
+	int32			count;			/* The functions having the variable, 0 for an empty slot */
+	double			factor;
+} lpAggMovingTerm;
+
+typedef struct lpAggMovingState
+{
+	double			factor0;
+	int64			numFunctions;	/* A number of the aggregated (non-NULL) functions */
+	int				numTerms;		/* A number of the variables */
+	int				slotBits;		/* The table has 2^slotBits slots */
+	lpAggMovingTerm	*slots;
+} lpAggMovingState;
+
+extern Datum lp_function_msum_trans(PG_FUNCTION_ARGS);
+extern Datum lp_function_msum_inv(PG_FUNCTION_ARGS);
+extern Datum lp_function_msum_final(PG_FUNCTION_ARGS);
 
 /* ***********************  For experimental purposes  ****************************** */
 
@@ -92,6 +194,19 @@ extern Datum lp_function_sum_final(PG_FUNCTION_ARGS);
 extern Datum lp_function_plus_sorted(PG_FUNCTION_ARGS);
 extern pg_LPfunction * internal_lp_function_plus_sorted(pg_LPfunction * p1, pg_LPfunction * p2);
 
+// Functions for aggregating pg_LPfunction instances based on the PG hash tables (dynahash)
+extern Datum lp_function_sum_hash_trans(PG_FUNCTION_ARGS);
+extern Datum lp_function_sum_hash_final(PG_FUNCTION_ARGS);
+
+/* The structure of the state variable of the dynahash-based aggregation */
+typedef struct lpAggHashState
+{
+	int32			vl_len_;		/* varlena header (do not touch directly!) */
+	double			factor0;
+	HTAB 			*hashVnr;		/* A pointer to hash mapping VarNr --> lpTerm if a variable exist in "allTerms"  */
+	MemoryContext   htMemCtx;  /* A memory context internally used by a hash table */
+} lpAggHashState;
+
 // Functions for adding/aggregating pg_LPfunction instances based on ARRAYS
 extern Datum lp_function_sum_array_trans(PG_FUNCTION_ARGS);
 extern Datum lp_function_sum_array_final(PG_FUNCTION_ARGS);
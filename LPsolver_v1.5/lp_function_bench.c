@@ -0,0 +1,415 @@
+/*
+ * lp_function_bench.c
+ *
+ *  A microbenchmark of the lp_function operators and aggregates. "lp_function_bench" runs an
+ *  operation over generated terms and reports the time per input term and the memory allocated.
+ *  The aggregates (sum, sum_hash, sum_sorted, sum_array) get one single-term function per term,
+ *  the operators (+, *, unnest) a function with all the terms ("+" adds its two halves). "chain"
+ *  adds the single-term functions with "+" one by one, as an expression x1 + x2 + ... + xn does.
+ *
+ *  The C functions are called the way the executor calls them: the transition functions see an
+ *  AggState whose aggregate context is a memory context of the benchmark, a changed transition
+ *  value is copied into that context, and the per-row memory is reset after each call. The
+ *  operators are called through their fmgr entry points, as the SQL operators are. Thus, the
+ *  "peak_bytes" reported are the space held by the benchmark's contexts at the peak (the
+ *  transition state just before the final function, or the result), not the bytes allocated.
+ */
+
+#include "postgres.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
+#include "executor/executor.h"
+#include "nodes/execnodes.h"
+#include "portability/instr_time.h"
+#include <math.h>
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/memutils.h"
+#include "lp_function.h"
+#include "libsolverapi.h"
+#include "utils.h"
+
+PG_FUNCTION_INFO_V1(lp_function_bench);
+
+typedef enum {
+	LPbenchSum,
+	LPbenchSumHash,
+	LPbenchSumSorted,
+	LPbenchSumArray,
+	LPbenchPlus,
+	LPbenchChain,
+	LPbenchMul,
+	LPbenchUnnest
+} LPbenchOp;
+
+static const struct
+{
+	const char	   *name;
+	LPbenchOp		op;
+} lp_bench_ops[] = {
+	{"sum", LPbenchSum},
+	{"sum_hash", LPbenchSumHash},
+	{"sum_sorted", LPbenchSumSorted},
+	{"sum_array", LPbenchSumArray},
+	{"+", LPbenchPlus},
+	{"chain", LPbenchChain},
+	{"*", LPbenchMul},
+	{"unnest", LPbenchUnnest}
+};
+
+/* The memory contexts of a run */
+typedef struct LPbenchContexts
+{
+	MemoryContext	run;			/* Everything allocated by the operation */
+	MemoryContext	agg;			/* The aggregate context */
+	MemoryContext	row;			/* The per-row memory, reset after each call */
+} LPbenchContexts;
+
+// Static function list
+static int * bench_var_numbers(int terms, int distinct, double density, double skew, bool ordered, int64 seed);
+static pg_LPfunction * bench_function(const int * vars, int from, int to);
+static pg_LPfunction * bench_aggregate(LPbenchOp op, pg_LPfunction ** inputs, int count,
+									   LPbenchContexts * ctx, int64 * peak);
+static pg_LPfunction * bench_chain(pg_LPfunction ** inputs, int count);
+static int bench_unnest(pg_LPfunction * func, LPbenchContexts * ctx);
+
+
+/* Generates the variable numbers of the terms. There are "distinct" variables, numbered
+ * 1 + k / density for k = 0 .. distinct - 1. The terms cycle over the variables and are then
+ * shuffled, unless "ordered", in which case they are ascending. With a "skew", the terms draw
+ * k = distinct * u^(1 / (1 - skew)) for a uniform u instead, thus the low numbers are frequent. */
+static int * bench_var_numbers(int terms, int distinct, double density, double skew, bool ordered, int64 seed)
+{
+	int			   *vars = palloc(sizeof(int) * terms);
+	unsigned short	xseed[3];
+	int				i;
+
+	if ((distinct - 1) / density >= INT_MAX)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("SolverLP: the variable numbers exceed the integer range, increase \"density\"")));
+
+	xseed[0] = 0x330E;
+	xseed[1] = (unsigned short) seed;
+	xseed[2] = (unsigned short) ((uint64) seed >> 16);
+
+	if (skew > 0)
+	{
+		for (i = 0; i < terms; i++)
+		{
+			int		k = Min((int) (distinct * pow(pg_erand48(xseed), 1 / (1 - skew))), distinct - 1);
+
+			vars[i] = 1 + (int) (k / density);
+		}
+		if (ordered)
+			qsort(vars, terms, sizeof(int), compareInts);
+		return vars;
+	}
+
+	for (i = 0; i < terms; i++)
+	{
+		int		k = ordered ? (int) ((int64) i * distinct / terms) : i % distinct;
+
+		vars[i] = 1 + (int) (k / density);
+	}
+
+	if (!ordered)
+	{
+		for (i = terms - 1; i > 0; i--)
+		{
+			int		j = (int) (pg_erand48(xseed) * (i + 1));
+			int		tmp = vars[i];
+
+			vars[i] = vars[j];
+			vars[j] = tmp;
+		}
+	}
+
+	return vars;
+}
+
+/* Builds a function of the terms [from, to). The factors cycle over 1 .. 7. */
+static pg_LPfunction * bench_function(const int * vars, int from, int to)
+{
+	pg_LPfunction  *func = palloc(LPfunction_SIZE(to - from));
+	int				i;
+
+	func->factor0 = 0;
+	func->numTerms = to - from;
+	for (i = from; i < to; i++)
+	{
+		func->term[i - from].varNr = vars[i];
+		func->term[i - from].factor = 1 + i % 7;
+	}
+	SET_VARSIZE(func, LPfunction_SIZE(func->numTerms));
+
+	return func;
+}
+
+/* Aggregates the inputs as the executor does. Sets "peak" to the space held before the final function. */
+static pg_LPfunction * bench_aggregate(LPbenchOp op, pg_LPfunction ** inputs, int count,
+									   LPbenchContexts * ctx, int64 * peak)
+{
+	AggState			   *aggstate = makeNode(AggState);
+	ExprContext			   *econtext = makeNode(ExprContext);
+	ExprContext			   *aggcontexts[1];
+	FunctionCallInfoData	fcinfo;
+	PGFunction				trans, final;
+	Datum					state = (Datum) 0;
+	bool					isnull = true;
+	MemoryContext			oldcontext;
+	int						i;
+
+	switch (op)
+	{
+		case LPbenchSum:		trans = lp_function_sum_trans;			final = lp_function_sum_final;			break;
+		case LPbenchSumHash:	trans = lp_function_sum_hash_trans;		final = lp_function_sum_hash_final;		break;
+		case LPbenchSumArray:	trans = lp_function_sum_array_trans;	final = lp_function_sum_array_final;	break;
+		default:				trans = lp_function_plus_sorted;		final = NULL;							break;
+	}
+
+	econtext->ecxt_per_tuple_memory = ctx->agg;
+	aggcontexts[0] = econtext;
+	aggstate->aggcontexts = aggcontexts;
+	aggstate->current_set = 0;
+
+	oldcontext = MemoryContextSwitchTo(ctx->row);
+	for (i = 0; i < count; i++)
+	{
+		Datum	newstate;
+
+		InitFunctionCallInfoData(fcinfo, NULL, 2, InvalidOid, (Node *) aggstate, NULL);
+		fcinfo.arg[0] = state;
+		fcinfo.argnull[0] = isnull;
+		fcinfo.arg[1] = PointerGetDatum(inputs[i]);
+		fcinfo.argnull[1] = false;
+
+		newstate = trans(&fcinfo);
+
+		/* Keep a new transition value in the aggregate context, and free the former one. The "internal"
+		 * state of sum is passed by value, as a pointer into the aggregate context. */
+		if (op != LPbenchSum && DatumGetPointer(newstate) != DatumGetPointer(state))
+		{
+			if (!fcinfo.isnull)
+			{
+				MemoryContextSwitchTo(ctx->agg);
+				newstate = datumCopy(newstate, false, -1);
+				MemoryContextSwitchTo(ctx->row);
+			}
+			if (!isnull)
+				pfree(DatumGetPointer(state));
+		}
+		state = newstate;
+		isnull = fcinfo.isnull;
+
+		MemoryContextReset(ctx->row);
+	}
+
+	*peak = sl_memory_context_size(ctx->run);
+
+	if (final != NULL && !isnull)
+	{
+		InitFunctionCallInfoData(fcinfo, NULL, 1, InvalidOid, (Node *) aggstate, NULL);
+		fcinfo.arg[0] = state;
+		fcinfo.argnull[0] = false;
+
+		MemoryContextSwitchTo(ctx->agg);
+		state = final(&fcinfo);
+		isnull = fcinfo.isnull;
+	}
+	MemoryContextSwitchTo(oldcontext);
+
+	return isnull ? NULL : (pg_LPfunction *) DatumGetPointer(state);
+}
+
+/* Adds the inputs as the executor evaluates inputs[0] + inputs[1] + ..., passing the result of each "+" to
+ * the next one. Returns the flat result. */
+static pg_LPfunction * bench_chain(pg_LPfunction ** inputs, int count)
+{
+	Datum	result = PointerGetDatum(inputs[0]);
+	int		i;
+
+	for (i = 1; i < count; i++)
+		result = DirectFunctionCall2(lp_function_plus, result, PointerGetDatum(inputs[i]));
+
+	return DatumGetLPfunction(result);
+}
+
+/* Unnests the function as a value-per-call set-returning function. Returns a number of rows. */
+static int bench_unnest(pg_LPfunction * func, LPbenchContexts * ctx)
+{
+	FmgrInfo				flinfo;
+	FunctionCallInfoData	fcinfo;
+	ReturnSetInfo			rsinfo;
+	MemoryContext			oldcontext = MemoryContextSwitchTo(ctx->run);
+	int						rows = 0;
+
+	MemSet(&flinfo, 0, sizeof(flinfo));
+	flinfo.fn_addr = lp_function_unnest;
+	flinfo.fn_oid = InvalidOid;
+	flinfo.fn_nargs = 1;
+	flinfo.fn_strict = true;
+	flinfo.fn_retset = true;
+	flinfo.fn_mcxt = ctx->run;
+
+	MemSet(&rsinfo, 0, sizeof(rsinfo));
+	rsinfo.type = T_ReturnSetInfo;
+	rsinfo.econtext = CreateStandaloneExprContext();
+	rsinfo.allowedModes = SFRM_ValuePerCall;
+
+	MemoryContextSwitchTo(ctx->row);
+	for (;;)
+	{
+		InitFunctionCallInfoData(fcinfo, &flinfo, 1, InvalidOid, NULL, (Node *) &rsinfo);
+		fcinfo.arg[0] = PointerGetDatum(func);
+		fcinfo.argnull[0] = false;
+		rsinfo.returnMode = SFRM_ValuePerCall;
+		rsinfo.isDone = ExprSingleResult;
+
+		(void) lp_function_unnest(&fcinfo);
+		if (rsinfo.isDone == ExprEndResult)
+			break;
+		rows++;
+
+		MemoryContextReset(ctx->row);
+	}
+	MemoryContextSwitchTo(oldcontext);
+
+	FreeExprContext(rsinfo.econtext, true);
+	return rows;
+}
+
+/* Runs an operation over the generated terms "loops" times. Outputs (distinct_vars, result_terms, ns_per_term,
+ * peak_bytes), where "ns_per_term" is of the fastest loop. */
+Datum lp_function_bench(PG_FUNCTION_ARGS)
+{
+	char		   *opname = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int32			terms = PG_GETARG_INT32(1);
+	float8			density = PG_GETARG_FLOAT8(2);
+	float8			duplicates = PG_GETARG_FLOAT8(3);
+	bool			ordered = PG_GETARG_BOOL(4);
+	int32			loops = PG_GETARG_INT32(5);
+	int64			seed = PG_GETARG_INT64(6);
+	float8			skew = PG_GETARG_FLOAT8(7);
+	LPbenchOp		op;
+	int				distinct;
+	int			   *vars;
+	pg_LPfunction **inputs = NULL;
+	pg_LPfunction  *whole = NULL, *half1 = NULL, *half2 = NULL;
+	double			best = -1;
+	int64			peak_bytes = 0;
+	int				result_terms = 0;
+	TupleDesc		tupdesc;
+	Datum			values[4];
+	bool			nulls[4] = {false, false, false, false};
+	int				i;
+
+	for (i = 0; i < lengthof(lp_bench_ops); i++)
+		if (strcmp(lp_bench_ops[i].name, opname) == 0)
+			break;
+	if (i == lengthof(lp_bench_ops))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("SolverLP: unknown lp_function operation \"%s\"", opname),
+				 errhint("The operations are sum, sum_hash, sum_sorted, sum_array, +, chain, * and unnest.")));
+	op = lp_bench_ops[i].op;
+
+	if (terms <= 0 || loops <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("SolverLP: \"terms\" and \"loops\" must be positive")));
+	if (density <= 0 || density > 1 || duplicates < 0 || duplicates >= 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("SolverLP: \"density\" must be in (0, 1] and \"duplicates\" in [0, 1)")));
+	if (skew < 0 || skew >= 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("SolverLP: \"skew\" must be in [0, 1)")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "SolverLP: return type must be a row type");
+
+	/* Generate the inputs */
+	distinct = Max((int) (terms * (1 - duplicates) + 0.5), 1);
+	vars = bench_var_numbers(terms, distinct, density, skew, ordered, seed);
+	switch (op)
+	{
+		case LPbenchSum:
+		case LPbenchSumHash:
+		case LPbenchSumSorted:
+		case LPbenchSumArray:
+		case LPbenchChain:
+			inputs = palloc(sizeof(pg_LPfunction *) * terms);
+			for (i = 0; i < terms; i++)
+				inputs[i] = bench_function(vars, i, i + 1);
+			break;
+		case LPbenchPlus:
+			half1 = bench_function(vars, 0, terms / 2);
+			half2 = bench_function(vars, terms / 2, terms);
+			break;
+		default:
+			whole = bench_function(vars, 0, terms);
+	}
+
+	for (i = 0; i < loops; i++)
+	{
+		LPbenchContexts		ctx;
+		MemoryContext		oldcontext;
+		pg_LPfunction	   *result;
+		instr_time			start, duration;
+		int64				peak = 0;
+
+		ctx.run = AllocSetContextCreate(CurrentMemoryContext, "lp_function benchmark", ALLOCSET_DEFAULT_MINSIZE,
+										ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+		ctx.agg = AllocSetContextCreate(ctx.run, "lp_function benchmark aggregate", ALLOCSET_DEFAULT_MINSIZE,
+										ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+		ctx.row = AllocSetContextCreate(ctx.run, "lp_function benchmark row", ALLOCSET_DEFAULT_MINSIZE,
+										ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+
+		INSTR_TIME_SET_CURRENT(start);
+		switch (op)
+		{
+			case LPbenchSum:
+			case LPbenchSumHash:
+			case LPbenchSumSorted:
+			case LPbenchSumArray:
+				result = bench_aggregate(op, inputs, terms, &ctx, &peak);
+				result_terms = result != NULL ? result->numTerms : 0;
+				break;
+			case LPbenchChain:
+				oldcontext = MemoryContextSwitchTo(ctx.run);
+				result = bench_chain(inputs, terms);
+				MemoryContextSwitchTo(oldcontext);
+				result_terms = result->numTerms;
+				break;
+			case LPbenchUnnest:
+				result_terms = bench_unnest(whole, &ctx);
+				break;
+			default:
+				oldcontext = MemoryContextSwitchTo(ctx.run);
+				result = DatumGetLPfunction(op == LPbenchPlus
+											? DirectFunctionCall2(lp_function_plus, PointerGetDatum(half1),
+																  PointerGetDatum(half2))
+											: DirectFunctionCall2(lp_function_fmul, PointerGetDatum(whole),
+																  Float8GetDatum(2.0)));
+				MemoryContextSwitchTo(oldcontext);
+				result_terms = result->numTerms;
+		}
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start);
+
+		if (best < 0 || INSTR_TIME_GET_DOUBLE(duration) < best)
+			best = INSTR_TIME_GET_DOUBLE(duration);
+		peak_bytes = Max(peak, sl_memory_context_size(ctx.run));
+
+		MemoryContextDelete(ctx.run);
+	}
+
+	values[0] = Int32GetDatum(distinct);
+	values[1] = Int32GetDatum(result_terms);
+	values[2] = Float8GetDatum(best * 1e9 / terms);
+	values[3] = Int64GetDatum(peak_bytes);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls)));
+}
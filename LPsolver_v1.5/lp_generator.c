@@ -0,0 +1,580 @@
+/*
+ * lp_generator.c
+ *
+ *  Generators of synthetic LP/MIP problems for testing and benchmarking SolverLP. Each generator
+ *  returns an input relation of SOLVESELECT with the unknown variable in the last column (NULL).
+ *  The data are drawn from pg_erand48 seeded by the "seed" argument, so the relation is the same
+ *  for the same arguments on all platforms. The rows are generated lazily, except for the sparse
+ *  and the block-diagonal problems, whose constraint matrix is built on the first call.
+ */
+
+#include "lp_generator.h"
+#include <math.h>
+#include "funcapi.h"
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/memutils.h"
+#include "utils.h"
+
+/* A state of the random number generator */
+typedef struct LPgenRandom
+{
+	unsigned short	xseed[3];
+} LPgenRandom;
+
+/* The transportation problem: each source supplies and each destination demands an amount
+ * of goods. The total supply exceeds the total demand by 20%. */
+typedef struct LPgenTransportation
+{
+	LPgenRandom		rnd;
+	int				destinations;
+	double		  * supply;			/* Supply of each source */
+	double		  * demand;			/* Demand of each destination */
+} LPgenTransportation;
+
+/* The multiple knapsack problem: each item can be put into at most one knapsack */
+typedef struct LPgenKnapsack
+{
+	int				knapsacks;
+	double		  * weight;			/* Weight of each item */
+	double		  * profit;			/* Profit of each item */
+	double		  * capacity;		/* Capacity of each knapsack */
+} LPgenKnapsack;
+
+/* The set cover problem: each element must be covered by at least one selected set */
+typedef struct LPgenSetCover
+{
+	LPgenRandom		rnd;
+	int				elements;
+	int				sets;
+	int				draws;			/* A number of random elements drawn for each set */
+} LPgenSetCover;
+
+/* A sparse LP problem "maximize cost * x subject to A x <= rhs, 0 <= x <= 1", with the
+ * constraint matrix A stored by the variables (columns) */
+typedef struct LPgenSparse
+{
+	int				block_cols;		/* A number of variables in a block */
+	double		  * cost;			/* Objective coefficient of each variable */
+	int64		  * start;			/* The first term of each variable, and the end of the last one */
+	int32		  * ctr;			/* Constraint number of each term */
+	double		  * coef;			/* Coefficient of each term */
+	double		  * rhs;			/* Right-hand side of each constraint */
+} LPgenSparse;
+
+/* The constraint matrix stored by the constraints (rows), while it is generated */
+typedef struct LPgenRows
+{
+	int64			nnz;			/* A number of terms */
+	int64			capacity;		/* A number of terms allocated */
+	int64		  * start;			/* The first term of each constraint */
+	int32		  * var;			/* Variable number of each term */
+	double		  * coef;			/* Coefficient of each term */
+} LPgenRows;
+
+// Static function list
+static void gen_random_init(LPgenRandom * rnd, int64 seed);
+static int gen_random_int(LPgenRandom * rnd, int lo, int hi);
+static void gen_check_positive(int64 value, const char * name);
+static FuncCallContext * gen_srf_init(FunctionCallInfo fcinfo, int natts, uint64 max_calls);
+static void gen_rows_add(LPgenRows * rows, int32 var, double coef);
+static LPgenSparse * gen_sparse_build(int blocks, int block_rows, int block_cols, int nnz_per_row,
+									  int linking_rows, double linking_density, int64 seed);
+static Datum gen_sparse_srf(FunctionCallInfo fcinfo, int blocks, int block_rows, int block_cols,
+							int nnz_per_row, int linking_rows, double linking_density, int64 seed);
+
+
+/* Seeds the generator, as srand48() does for the lower 32 bits of the seed */
+static void gen_random_init(LPgenRandom * rnd, int64 seed)
+{
+	rnd->xseed[0] = 0x330E ^ (unsigned short) ((uint64) seed >> 32);
+	rnd->xseed[1] = (unsigned short) seed;
+	rnd->xseed[2] = (unsigned short) ((uint64) seed >> 16);
+}
+
+/* Draws an integer from [lo, hi] */
+static int gen_random_int(LPgenRandom * rnd, int lo, int hi)
+{
+	return lo + (int) (pg_erand48(rnd->xseed) * (hi - lo + 1));
+}
+
+static void gen_check_positive(int64 value, const char * name)
+{
+	if (value <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("SolverLP: \"%s\" must be positive", name)));
+}
+
+/* Sets up a set-returning function returning "max_calls" rows of "natts" columns. Called on the first call. */
+static FuncCallContext * gen_srf_init(FunctionCallInfo fcinfo, int natts, uint64 max_calls)
+{
+	FuncCallContext	   *funcctx = SRF_FIRSTCALL_INIT();
+	MemoryContext		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+	TupleDesc			tupdesc;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "SolverLP: return type must be a row type");
+	if (tupdesc->natts != natts)
+		elog(ERROR, "SolverLP: incorrect number of output arguments");
+
+	funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+	funcctx->max_calls = max_calls;
+
+	MemoryContextSwitchTo(oldcontext);
+	return funcctx;
+}
+
+/* Generates the transportation problem. Outputs (src, dst, cost, supply, demand, x) for each route. */
+PG_FUNCTION_INFO_V1(lp_gen_transportation);
+Datum lp_gen_transportation(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		   *funcctx;
+	LPgenTransportation	   *state;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		int32		sources = PG_GETARG_INT32(0);
+		int32		destinations = PG_GETARG_INT32(1);
+		double		total_supply = 0, total_demand = 0;
+		int			i;
+
+		gen_check_positive(sources, "sources");
+		gen_check_positive(destinations, "destinations");
+
+		funcctx = gen_srf_init(fcinfo, 6, (uint64) sources * destinations);
+		state = MemoryContextAllocZero(funcctx->multi_call_memory_ctx, sizeof(LPgenTransportation));
+		state->destinations = destinations;
+		state->supply = MemoryContextAlloc(funcctx->multi_call_memory_ctx, sizeof(double) * sources);
+		state->demand = MemoryContextAlloc(funcctx->multi_call_memory_ctx, sizeof(double) * destinations);
+
+		gen_random_init(&state->rnd, PG_GETARG_INT64(2));
+		for (i = 0; i < destinations; i++)
+			total_demand += state->demand[i] = gen_random_int(&state->rnd, 10, 100);
+		for (i = 0; i < sources; i++)
+			total_supply += state->supply[i] = gen_random_int(&state->rnd, 10, 100);
+		for (i = 0; i < sources; i++)
+			state->supply[i] = ceil(state->supply[i] * 1.2 * total_demand / total_supply);
+
+		funcctx->user_fctx = state;
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (LPgenTransportation *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		int			src = funcctx->call_cntr / state->destinations;
+		int			dst = funcctx->call_cntr % state->destinations;
+		Datum		values[6];
+		bool		nulls[6] = {false, false, false, false, false, true};
+
+		values[0] = Int32GetDatum(src + 1);
+		values[1] = Int32GetDatum(dst + 1);
+		values[2] = Float8GetDatum(gen_random_int(&state->rnd, 1, 100));
+		values[3] = Float8GetDatum(state->supply[src]);
+		values[4] = Float8GetDatum(state->demand[dst]);
+		values[5] = (Datum) 0;
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+	else
+		SRF_RETURN_DONE(funcctx);
+}
+
+/* Generates the assignment problem of n agents to n tasks. Outputs (agent, task, cost, x) for each pair. */
+PG_FUNCTION_INFO_V1(lp_gen_assignment);
+Datum lp_gen_assignment(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		   *funcctx;
+	LPgenRandom			   *rnd;
+	int32					n = PG_GETARG_INT32(0);
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		gen_check_positive(n, "n");
+
+		funcctx = gen_srf_init(fcinfo, 4, (uint64) n * n);
+		rnd = MemoryContextAlloc(funcctx->multi_call_memory_ctx, sizeof(LPgenRandom));
+		gen_random_init(rnd, PG_GETARG_INT64(1));
+
+		funcctx->user_fctx = rnd;
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	rnd = (LPgenRandom *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		Datum		values[4];
+		bool		nulls[4] = {false, false, false, true};
+
+		values[0] = Int32GetDatum(funcctx->call_cntr / n + 1);
+		values[1] = Int32GetDatum(funcctx->call_cntr % n + 1);
+		values[2] = Float8GetDatum(gen_random_int(rnd, 1, 100));
+		values[3] = (Datum) 0;
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+	else
+		SRF_RETURN_DONE(funcctx);
+}
+
+/* Generates the multiple knapsack problem. Outputs (item, knapsack, weight, profit, capacity, x) for each pair.
+ * The capacity of a knapsack is 40-60% of the total weight divided by the number of knapsacks. */
+PG_FUNCTION_INFO_V1(lp_gen_multi_knapsack);
+Datum lp_gen_multi_knapsack(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		   *funcctx;
+	LPgenKnapsack		   *state;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		int32		items = PG_GETARG_INT32(0);
+		int32		knapsacks = PG_GETARG_INT32(1);
+		double		total_weight = 0;
+		LPgenRandom	rnd;
+		int			i;
+
+		gen_check_positive(items, "items");
+		gen_check_positive(knapsacks, "knapsacks");
+
+		funcctx = gen_srf_init(fcinfo, 6, (uint64) items * knapsacks);
+		state = MemoryContextAllocZero(funcctx->multi_call_memory_ctx, sizeof(LPgenKnapsack));
+		state->knapsacks = knapsacks;
+		state->weight = MemoryContextAlloc(funcctx->multi_call_memory_ctx, sizeof(double) * items);
+		state->profit = MemoryContextAlloc(funcctx->multi_call_memory_ctx, sizeof(double) * items);
+		state->capacity = MemoryContextAlloc(funcctx->multi_call_memory_ctx, sizeof(double) * knapsacks);
+
+		gen_random_init(&rnd, PG_GETARG_INT64(2));
+		for (i = 0; i < items; i++)
+		{
+			total_weight += state->weight[i] = gen_random_int(&rnd, 1, 100);
+			state->profit[i] = gen_random_int(&rnd, 1, 100);
+		}
+		for (i = 0; i < knapsacks; i++)
+			state->capacity[i] = floor(total_weight / knapsacks * gen_random_int(&rnd, 40, 60) / 100);
+
+		funcctx->user_fctx = state;
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (LPgenKnapsack *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		int			item = funcctx->call_cntr / state->knapsacks;
+		int			knapsack = funcctx->call_cntr % state->knapsacks;
+		Datum		values[6];
+		bool		nulls[6] = {false, false, false, false, false, true};
+
+		values[0] = Int32GetDatum(item + 1);
+		values[1] = Int32GetDatum(knapsack + 1);
+		values[2] = Float8GetDatum(state->weight[item]);
+		values[3] = Float8GetDatum(state->profit[item]);
+		values[4] = Float8GetDatum(state->capacity[knapsack]);
+		values[5] = (Datum) 0;
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+	else
+		SRF_RETURN_DONE(funcctx);
+}
+
+/* Generates the set cover problem. Outputs (set_id, cost, members, x) for each set. Each set contains
+ * about "density" of all elements, and an element e is always in the set (e - 1) % sets + 1. */
+PG_FUNCTION_INFO_V1(lp_gen_set_cover);
+Datum lp_gen_set_cover(PG_FUNCTION_ARGS)
+{
+	FuncCallContext		   *funcctx;
+	LPgenSetCover		   *state;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		int32		elements = PG_GETARG_INT32(0);
+		int32		sets = PG_GETARG_INT32(1);
+		float8		density = PG_GETARG_FLOAT8(2);
+
+		gen_check_positive(elements, "elements");
+		gen_check_positive(sets, "sets");
+		if (density < 0 || density > 1)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("SolverLP: \"density\" must be between 0 and 1")));
+
+		funcctx = gen_srf_init(fcinfo, 4, sets);
+		state = MemoryContextAllocZero(funcctx->multi_call_memory_ctx, sizeof(LPgenSetCover));
+		state->elements = elements;
+		state->sets = sets;
+		state->draws = (int) (density * elements);
+		gen_random_init(&state->rnd, PG_GETARG_INT64(3));
+
+		funcctx->user_fctx = state;
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (LPgenSetCover *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		int			set = funcctx->call_cntr;
+		int		  * members = palloc(sizeof(int) * (state->draws + state->elements / state->sets + 1));
+		int			count = 0, unique = 0, i;
+		Datum	  * elems;
+		Datum		values[4];
+		bool		nulls[4] = {false, false, false, true};
+
+		for (i = set + 1; i <= state->elements; i += state->sets)
+			members[count++] = i;
+		for (i = 0; i < state->draws; i++)
+			members[count++] = gen_random_int(&state->rnd, 1, state->elements);
+
+		/* Sort and remove the duplicates */
+		qsort(members, count, sizeof(int), compareInts);
+		elems = palloc(sizeof(Datum) * Max(count, 1));
+		for (i = 0; i < count; i++)
+			if (i == 0 || members[i] != members[i - 1])
+				elems[unique++] = Int32GetDatum(members[i]);
+
+		values[0] = Int32GetDatum(set + 1);
+		values[1] = Float8GetDatum(gen_random_int(&state->rnd, 1, 100));
+		values[2] = unique > 0 ? PointerGetDatum(construct_array(elems, unique, INT4OID, sizeof(int32), true, 'i'))
+							   : PointerGetDatum(construct_empty_array(INT4OID));
+		values[3] = (Datum) 0;
+
+		pfree(members);
+		pfree(elems);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+	else
+		SRF_RETURN_DONE(funcctx);
+}
+
+/* Appends a term to the last constraint, growing the arrays when needed */
+static void gen_rows_add(LPgenRows * rows, int32 var, double coef)
+{
+	if (rows->nnz == rows->capacity)
+	{
+		rows->capacity *= 2;
+		rows->var = repalloc_huge(rows->var, sizeof(int32) * rows->capacity);
+		rows->coef = repalloc_huge(rows->coef, sizeof(double) * rows->capacity);
+	}
+	rows->var[rows->nnz] = var;
+	rows->coef[rows->nnz] = coef;
+	rows->nnz++;
+}
+
+/* Builds a block-diagonal problem in the current memory context. Each block has "block_rows" constraints over
+ * its own "block_cols" variables, each constraint having "nnz_per_row" terms. The "linking_rows" constraints
+ * link the blocks, each having a term for a variable with the probability "linking_density".
+ * The coefficients are in [1, 10], and the right-hand side of a constraint is half of its coefficient sum. */
+static LPgenSparse * gen_sparse_build(int blocks, int block_rows, int block_cols, int nnz_per_row,
+									  int linking_rows, double linking_density, int64 seed)
+{
+	LPgenSparse	  * prob = palloc0(sizeof(LPgenSparse));
+	LPgenRows		rows;
+	LPgenRandom		rnd;
+	int				variables = blocks * block_cols;
+	int				constraints = blocks * block_rows + linking_rows;
+	int			  * perm;
+	int64		  * pos;
+	int				b, c, i, v;
+	int64			t;
+
+	gen_random_init(&rnd, seed);
+
+	prob->block_cols = block_cols;
+	prob->cost = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(double) * variables);
+	prob->rhs = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(double) * constraints);
+	for (v = 0; v < variables; v++)
+		prob->cost[v] = gen_random_int(&rnd, 1, 100);
+
+	rows.nnz = 0;
+	rows.capacity = Max((int64) blocks * block_rows * nnz_per_row, 1024);
+	rows.start = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int64) * (constraints + 1));
+	rows.var = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int32) * rows.capacity);
+	rows.coef = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(double) * rows.capacity);
+
+	/* The constraints of the blocks. The variables of a constraint are the first "nnz_per_row"
+	 * elements of a partially shuffled permutation of the block's variables. */
+	perm = palloc(sizeof(int) * block_cols);
+	for (i = 0; i < block_cols; i++)
+		perm[i] = i;
+
+	c = 0;
+	for (b = 0; b < blocks; b++)
+		for (i = 0; i < block_rows; i++, c++)
+		{
+			double	sum = 0;
+			int		j;
+
+			rows.start[c] = rows.nnz;
+			for (j = 0; j < nnz_per_row; j++)
+			{
+				int		k = gen_random_int(&rnd, j, block_cols - 1);
+				int		tmp = perm[j];
+				double	coef = gen_random_int(&rnd, 1, 10);
+
+				perm[j] = perm[k];
+				perm[k] = tmp;
+				gen_rows_add(&rows, b * block_cols + perm[j], coef);
+				sum += coef;
+			}
+			prob->rhs[c] = floor(sum / 2);
+		}
+	pfree(perm);
+
+	/* The linking constraints. The gaps between their variables are drawn from the geometric distribution. */
+	for (i = 0; i < linking_rows; i++, c++)
+	{
+		double	sum = 0;
+		int64	var = -1;
+
+		rows.start[c] = rows.nnz;
+		while (linking_density > 0)
+		{
+			if (linking_density >= 1)
+				var++;
+			else
+				var += 1 + (int64) floor(log(1.0 - pg_erand48(rnd.xseed)) / log(1.0 - linking_density));
+			if (var >= variables)
+				break;
+
+			gen_rows_add(&rows, (int32) var, gen_random_int(&rnd, 1, 10));
+			sum += rows.coef[rows.nnz - 1];
+		}
+		prob->rhs[c] = floor(sum / 2);
+	}
+	rows.start[constraints] = rows.nnz;
+
+	/* Transpose the matrix, keeping the terms of a variable ordered by the constraint */
+	prob->start = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int64) * (variables + 1));
+	prob->ctr = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int32) * Max(rows.nnz, 1));
+	prob->coef = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(double) * Max(rows.nnz, 1));
+	pos = MemoryContextAllocHuge(CurrentMemoryContext, sizeof(int64) * variables);
+
+	MemSet(pos, 0, sizeof(int64) * variables);
+	for (t = 0; t < rows.nnz; t++)
+		pos[rows.var[t]]++;
+	prob->start[0] = 0;
+	for (v = 0; v < variables; v++)
+	{
+		prob->start[v + 1] = prob->start[v] + pos[v];
+		pos[v] = prob->start[v];
+	}
+	for (c = 0; c < constraints; c++)
+		for (t = rows.start[c]; t < rows.start[c + 1]; t++)
+		{
+			int64	p = pos[rows.var[t]]++;
+
+			prob->ctr[p] = c + 1;
+			prob->coef[p] = rows.coef[t];
+		}
+
+	pfree(pos);
+	pfree(rows.start);
+	pfree(rows.var);
+	pfree(rows.coef);
+
+	return prob;
+}
+
+/* Outputs the block-diagonal problem as (var, block, cost, ctrs, coefs, rhs, x) for each variable. "ctrs" are
+ * the constraints the variable appears in, "coefs" its coefficients and "rhs" the right-hand sides of them. */
+static Datum gen_sparse_srf(FunctionCallInfo fcinfo, int blocks, int block_rows, int block_cols,
+							int nnz_per_row, int linking_rows, double linking_density, int64 seed)
+{
+	FuncCallContext		   *funcctx;
+	LPgenSparse			   *prob;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcontext;
+
+		gen_check_positive(blocks, "blocks");
+		gen_check_positive(block_rows, "rows");
+		gen_check_positive(block_cols, "cols");
+		gen_check_positive(nnz_per_row, "nnz_per_row");
+		if (nnz_per_row > block_cols)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("SolverLP: \"nnz_per_row\" must not exceed the number of variables in a block")));
+		if (linking_rows < 0 || linking_density < 0 || linking_density > 1)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("SolverLP: \"linking_rows\" must not be negative and \"linking_density\" must be between 0 and 1")));
+		if ((int64) blocks * block_cols > INT_MAX || (int64) blocks * block_rows + linking_rows > INT_MAX)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("SolverLP: too many variables or constraints requested")));
+
+		funcctx = gen_srf_init(fcinfo, 7, (uint64) blocks * block_cols);
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+		funcctx->user_fctx = gen_sparse_build(blocks, block_rows, block_cols, nnz_per_row,
+											  linking_rows, linking_density, seed);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	prob = (LPgenSparse *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		int			var = funcctx->call_cntr;
+		int64		first = prob->start[var];
+		int			count = prob->start[var + 1] - first;
+		Datum		values[7];
+		bool		nulls[7] = {false, false, false, false, false, false, true};
+
+		values[0] = Int32GetDatum(var + 1);
+		values[1] = Int32GetDatum(var / prob->block_cols + 1);
+		values[2] = Float8GetDatum(prob->cost[var]);
+		if (count > 0)
+		{
+			Datum	  * ctrs = palloc(sizeof(Datum) * count);
+			Datum	  * coefs = palloc(sizeof(Datum) * count);
+			Datum	  * rhs = palloc(sizeof(Datum) * count);
+			int			i;
+
+			for (i = 0; i < count; i++)
+			{
+				ctrs[i] = Int32GetDatum(prob->ctr[first + i]);
+				coefs[i] = Float8GetDatum(prob->coef[first + i]);
+				rhs[i] = Float8GetDatum(prob->rhs[prob->ctr[first + i] - 1]);
+			}
+			values[3] = PointerGetDatum(construct_array(ctrs, count, INT4OID, sizeof(int32), true, 'i'));
+			values[4] = PointerGetDatum(construct_array(coefs, count, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, 'd'));
+			values[5] = PointerGetDatum(construct_array(rhs, count, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, 'd'));
+		}
+		else
+		{
+			values[3] = PointerGetDatum(construct_empty_array(INT4OID));
+			values[4] = PointerGetDatum(construct_empty_array(FLOAT8OID));
+			values[5] = PointerGetDatum(construct_empty_array(FLOAT8OID));
+		}
+		values[6] = (Datum) 0;
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+	}
+	else
+		SRF_RETURN_DONE(funcctx);
+}
+
+/* Generates a block-diagonal LP problem with linking constraints */
+PG_FUNCTION_INFO_V1(lp_gen_block_diagonal);
+Datum lp_gen_block_diagonal(PG_FUNCTION_ARGS)
+{
+	return gen_sparse_srf(fcinfo, PG_GETARG_INT32(0), PG_GETARG_INT32(1), PG_GETARG_INT32(2), PG_GETARG_INT32(3),
+						  PG_GETARG_INT32(4), PG_GETARG_FLOAT8(5), PG_GETARG_INT64(6));
+}
+
+/* Generates a random sparse LP problem, i.e., a single block without linking constraints */
+PG_FUNCTION_INFO_V1(lp_gen_sparse);
+Datum lp_gen_sparse(PG_FUNCTION_ARGS)
+{
+	return gen_sparse_srf(fcinfo, 1, PG_GETARG_INT32(0), PG_GETARG_INT32(1), PG_GETARG_INT32(2),
+						  0, 0, PG_GETARG_INT64(3));
+}
@@ -0,0 +1,21 @@
+/*
+ * lp_generator.h
+ *
+ *  Generators of synthetic LP/MIP problems. Each generator is a set-returning function producing
+ *  an input relation of SOLVESELECT, which is the same for the same arguments and seed.
+ */
+
+#ifndef LP_GENERATOR_H_
+#define LP_GENERATOR_H_
+
+#include "postgres.h"
+#include "fmgr.h"
+
+extern Datum lp_gen_transportation(PG_FUNCTION_ARGS);
+extern Datum lp_gen_assignment(PG_FUNCTION_ARGS);
+extern Datum lp_gen_multi_knapsack(PG_FUNCTION_ARGS);
+extern Datum lp_gen_set_cover(PG_FUNCTION_ARGS);
+extern Datum lp_gen_block_diagonal(PG_FUNCTION_ARGS);
+extern Datum lp_gen_sparse(PG_FUNCTION_ARGS);
+
+#endif /* LP_GENERATOR_H_ */
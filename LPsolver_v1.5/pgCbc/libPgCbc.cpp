@@ -9,6 +9,7 @@
 /* This example shows the use of the "C" interface for CBC. */
 
 #include "libPgCbc.h"
+#include "solvedb_probes.h"
 #include "miscadmin.h"
 #include "utils/elog.h"
 
@@ -160,6 +161,7 @@ extern LPsolverResult * solve_problem_cbc(LPproblem * prob, char * args, int pgL
 		paramData.noPrinting_ = false;
 
 		/* Performance measurements */
+		TRACE_SOLVEDB_CBC_START(model->getNumCols(), model->getNumRows(), (long long) model->solver()->getNumElements());
 		gettimeofday(&start_time, NULL);
 
 		CbcMain0(*model, paramData);
@@ -201,6 +203,7 @@ extern LPsolverResult * solve_problem_cbc(LPproblem * prob, char * args, int pgL
 		CbcMain1((int) argv.size(), &argv[0], *model, callBack, paramData);
 
 		gettimeofday(&end_time, NULL);
+		TRACE_SOLVEDB_CBC_DONE(model->getNumCols(), model->status());
 
 		/* Saves the solution */
 		const double * solution = model->bestSolution();
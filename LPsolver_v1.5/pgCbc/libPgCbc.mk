@@ -13,7 +13,7 @@ cbcSHLIB     = -L$(cbcDIRfull)/lib/ -Wl,-Bstatic -Wl,--start-group -lCbc -lCbcSo
 .PHONY: clean_pgcbc
 
 libPgCbc.so: $(cbcLIBso) $(cbcOBJS)
-	g++ -shared $(CPPFLAGS) -o $@ $(cbcOBJS) $(cbcSHLIB)
+	g++ -shared $(CPPFLAGS) -o $@ $(cbcOBJS) $(cbcPROBES) $(cbcSHLIB)
 
 $(cbcOBJS): $(@:.o=.cpp)
 	$(CC) -c $(CPPFLAGS) $(ECPPFLAGS) $(@:.o=.cpp) -o $@
@@ -6,6 +6,7 @@
  */
 
 #include "prb_partition.h"
+#include "solvedb_probes.h"
 #include "utils/memutils.h"
 
 /* Disjoint-set data structures  */
@@ -82,11 +83,9 @@ extern List * partitionLPproblem(LPproblem * main_prb, int partition_size)
 	int				i;
 	int				grp_size;
 
-	part_context = AllocSetContextCreate(CurrentMemoryContext,
-											   "Problem partitioning context",
-											   ALLOCSET_DEFAULT_MINSIZE,
-											   ALLOCSET_DEFAULT_INITSIZE,
-											   ALLOCSET_DEFAULT_MAXSIZE);
+	TRACE_SOLVEDB_PARTITIONING_START(main_prb->numVariables - 1, list_length(main_prb->ctrs));
+
+	part_context = sl_work_mem_context_create(CurrentMemoryContext, "Problem partitioning context");
 
 	old_context = MemoryContextSwitchTo(part_context);
 
@@ -256,5 +255,7 @@ extern List * partitionLPproblem(LPproblem * main_prb, int partition_size)
 	hash_destroy(hash);
 	MemoryContextDelete(part_context);
 
+	TRACE_SOLVEDB_PARTITIONING_DONE(list_length(result));
+
 	return result;
 }
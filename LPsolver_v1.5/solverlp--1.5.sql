@@ -87,12 +87,12 @@ WHERE (s.sid = m.sid) AND (s.name = 'solverlp') AND (m.name='auto');
 CREATE FUNCTION lp_function_in(cstring)
 RETURNS lp_function
 AS 'MODULE_PATHNAME'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE FUNCTION lp_function_out(lp_function)
 RETURNS cstring
 AS 'MODULE_PATHNAME'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE TYPE lp_function (
 	INTERNALLENGTH = variable,
@@ -105,29 +105,29 @@ COMMENT ON TYPE lp_function IS 'lp_function: Represent the terms of linear funct
 
 CREATE FUNCTION lp_function_make(int8) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_make'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE FUNCTION lp_function_makeCfloat8(float8) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_makeCfloat8'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE CAST (float8 AS lp_function) WITH FUNCTION lp_function_makeCfloat8(float8) AS IMPLICIT;
 
 CREATE FUNCTION lp_function_makeCnum(numeric) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_makeCnum'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE CAST (numeric AS lp_function) WITH FUNCTION lp_function_makeCnum(numeric) AS IMPLICIT;
 
 CREATE FUNCTION lp_function_makeCint4(int4) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_makeCint4'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE CAST (int4 AS lp_function) WITH FUNCTION lp_function_makeCint4(int4) AS IMPLICIT;
 
 CREATE FUNCTION lp_function_makeCbool(boolean) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_makeCbool'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE CAST (boolean AS lp_function) WITH FUNCTION lp_function_makeCbool(boolean) AS IMPLICIT;
 
@@ -135,15 +135,15 @@ CREATE CAST (boolean AS lp_function) WITH FUNCTION lp_function_makeCbool(boolean
 
 CREATE FUNCTION lp_function_fmul(lp_function, float8) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_fmul'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE FUNCTION lp_function_fmul(float8, lp_function) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_fmulC'
-LANGUAGE C IMMUTABLE STRICT;        
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE FUNCTION lp_function_fdiv(lp_function, float8) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_fdiv'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
 CREATE OPERATOR * (
 	LEFTARG = lp_function,
@@ -168,7 +168,7 @@ CREATE OPERATOR / (
 
 CREATE FUNCTION lp_function_plus(lp_function, lp_function) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_plus'
-LANGUAGE C IMMUTABLE CALLED ON NULL INPUT;
+LANGUAGE C IMMUTABLE CALLED ON NULL INPUT PARALLEL SAFE;
 
 CREATE OPERATOR + (
 	LEFTARG = lp_function,
@@ -177,29 +177,70 @@ CREATE OPERATOR + (
 	PROCEDURE = lp_function_plus
 );
 
-CREATE FUNCTION lp_function_sum_trans(bytea, lp_function) RETURNS bytea
+CREATE FUNCTION lp_function_sum_trans(internal, lp_function) RETURNS internal
 AS 'MODULE_PATHNAME', 'lp_function_sum_trans'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
-CREATE FUNCTION lp_function_sum_final(bytea) RETURNS lp_function
+CREATE FUNCTION lp_function_sum_final(internal) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_sum_final'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
--- **** Hash-based aggregation is selected by DEFAULT ***
-CREATE AGGREGATE sum (
+CREATE FUNCTION lp_function_sum_combine(internal, internal) RETURNS internal
+AS 'MODULE_PATHNAME', 'lp_function_sum_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION lp_function_sum_serialize(internal) RETURNS bytea
+AS 'MODULE_PATHNAME', 'lp_function_sum_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION lp_function_sum_deserialize(bytea, internal) RETURNS internal
+AS 'MODULE_PATHNAME', 'lp_function_sum_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE FUNCTION lp_function_msum_trans(internal, lp_function) RETURNS internal
+AS 'MODULE_PATHNAME', 'lp_function_msum_trans'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION lp_function_msum_inv(internal, lp_function) RETURNS internal
+AS 'MODULE_PATHNAME', 'lp_function_msum_inv'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE FUNCTION lp_function_msum_final(internal) RETURNS lp_function
+AS 'MODULE_PATHNAME', 'lp_function_msum_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- **** Adaptive aggregation (a sorted buffer, an array or an open-addressing hash table) is selected by DEFAULT ***
+-- The partial sums of parallel workers are combined, passing their states as lp_function.
+-- In a sliding window frame, the functions leaving the frame are subtracted (the moving-aggregate mode).
+CREATE AGGREGATE sum (lp_function) (
     sfunc = lp_function_sum_trans,
-    stype = bytea,
+    stype = internal,
     finalfunc = lp_function_sum_final,
-    basetype = lp_function
+    combinefunc = lp_function_sum_combine,
+    serialfunc = lp_function_sum_serialize,
+    deserialfunc = lp_function_sum_deserialize,
+    msfunc = lp_function_msum_trans,
+    minvfunc = lp_function_msum_inv,
+    mstype = internal,
+    mfinalfunc = lp_function_msum_final,
+    parallel = safe
 );
 
 -- ***************** EXPERIMENTAL functions ***************************
 
--- Hash-based aggregation 
+-- Aggregation based on the PG hash tables (dynahash), the former default
+CREATE FUNCTION lp_function_sum_hash_trans(bytea, lp_function) RETURNS bytea
+AS 'MODULE_PATHNAME', 'lp_function_sum_hash_trans'
+LANGUAGE C IMMUTABLE;
+
+CREATE FUNCTION lp_function_sum_hash_final(bytea) RETURNS lp_function
+AS 'MODULE_PATHNAME', 'lp_function_sum_hash_final'
+LANGUAGE C IMMUTABLE STRICT;
+
 CREATE AGGREGATE sum_hash (
-    sfunc = lp_function_sum_trans,
+    sfunc = lp_function_sum_hash_trans,
     stype = bytea,
-    finalfunc = lp_function_sum_final,
+    finalfunc = lp_function_sum_hash_final,
     basetype = lp_function
 );
 
@@ -234,7 +275,7 @@ CREATE AGGREGATE sum_array (
 
 CREATE FUNCTION lp_function_minus(lp_function, lp_function) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_minus'
-LANGUAGE C IMMUTABLE CALLED ON NULL INPUT;
+LANGUAGE C IMMUTABLE CALLED ON NULL INPUT PARALLEL SAFE;
 
 CREATE OPERATOR - (
 	LEFTARG = lp_function,
@@ -244,7 +285,7 @@ CREATE OPERATOR - (
 
 CREATE FUNCTION lp_function_minus1(lp_function) RETURNS lp_function
 AS 'MODULE_PATHNAME', 'lp_function_minus1'
-LANGUAGE C IMMUTABLE CALLED ON NULL INPUT;
+LANGUAGE C IMMUTABLE CALLED ON NULL INPUT PARALLEL SAFE;
 
 CREATE OPERATOR - (
 	LEFTARG = lp_function,
@@ -254,7 +295,20 @@ CREATE OPERATOR - (
 
 CREATE FUNCTION lp_function_unnest(lp_function) RETURNS SETOF lp_function
 AS 'MODULE_PATHNAME', 'lp_function_unnest'
-LANGUAGE C IMMUTABLE STRICT;
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Microbenchmark of the lp_function operators and aggregates. Runs an operation (sum, sum_hash, sum_sorted,
+-- sum_array, +, chain, * or unnest) over "terms" generated terms, "loops" times. The terms use about
+-- terms * (1 - duplicates) distinct variables, whose numbers are spread over 1 / density as many numbers.
+-- The terms are shuffled unless "ordered". With "skew" in (0, 1), the terms draw their variables at random
+-- with the probability falling towards the higher numbers, the more the higher the skew. Reports the fastest
+-- loop in nanoseconds per term, and the bytes held at the peak (peak_bytes). See bench/lp_function.sql.
+CREATE FUNCTION lp_function_bench(operation text, terms int, density float8 DEFAULT 1, duplicates float8 DEFAULT 0,
+	ordered boolean DEFAULT false, loops int DEFAULT 5, seed int8 DEFAULT 0, skew float8 DEFAULT 0,
+	OUT distinct_vars int, OUT result_terms int, OUT ns_per_term float8, OUT peak_bytes int8)
+RETURNS record
+AS 'MODULE_PATHNAME', 'lp_function_bench'
+LANGUAGE C VOLATILE STRICT;
 
 -- Operators for constraining instances of "lp_function"
 -- C (op) lp_function
@@ -359,4 +413,81 @@ CREATE OR REPLACE FUNCTION all_diff(exp lp_function) RETURNS SETOF sl_ctr AS $$
     SELECT t1.term <> t2.term 
     FROM terms AS t1, terms AS t2 
     WHERE t1.id < t2.id;
-$$ LANGUAGE SQL STRICT
\ No newline at end of file
+$$ LANGUAGE SQL STRICT;
+
+-- Generators of synthetic problems. Each returns an input relation of SOLVESELECT, with the unknown
+-- variable "x" in the last column. The relation is the same for the same arguments and seed.
+
+-- The transportation problem, a row per route. The total supply exceeds the total demand by 20%:
+--   SOLVESELECT x IN (SELECT * FROM lp_gen_transportation(100, 100)) AS t
+--   MINIMIZE  (SELECT sum(cost * x) FROM t)
+--   SUBJECTTO (SELECT x >= 0 FROM t),
+--             (SELECT sum(x) <= supply FROM t GROUP BY src, supply),
+--             (SELECT sum(x) >= demand FROM t GROUP BY dst, demand)
+--   USING solverlp
+CREATE OR REPLACE FUNCTION lp_gen_transportation(sources int, destinations int, seed int8 DEFAULT 0,
+	OUT src int, OUT dst int, OUT cost float8, OUT supply float8, OUT demand float8, OUT x float8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- The assignment problem of n agents to n tasks, a row per pair:
+--   SOLVESELECT x IN (SELECT * FROM lp_gen_assignment(100)) AS t
+--   MINIMIZE  (SELECT sum(cost * x) FROM t)
+--   SUBJECTTO (SELECT sum(x) = 1 FROM t GROUP BY agent),
+--             (SELECT sum(x) = 1 FROM t GROUP BY task)
+--   USING solverlp
+CREATE OR REPLACE FUNCTION lp_gen_assignment(n int, seed int8 DEFAULT 0,
+	OUT agent int, OUT task int, OUT cost float8, OUT x boolean)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- The multiple knapsack problem, a row per item and knapsack:
+--   SOLVESELECT x IN (SELECT * FROM lp_gen_multi_knapsack(1000, 10)) AS t
+--   MAXIMIZE  (SELECT sum(profit * x) FROM t)
+--   SUBJECTTO (SELECT sum(x) <= 1 FROM t GROUP BY item),
+--             (SELECT sum(weight * x) <= capacity FROM t GROUP BY knapsack, capacity)
+--   USING solverlp
+CREATE OR REPLACE FUNCTION lp_gen_multi_knapsack(items int, knapsacks int, seed int8 DEFAULT 0,
+	OUT item int, OUT knapsack int, OUT weight float8, OUT profit float8, OUT capacity float8, OUT x boolean)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- The set cover problem, a row per set. A set contains about "density" of the elements:
+--   SOLVESELECT x IN (SELECT * FROM lp_gen_set_cover(1000, 100, 0.05)) AS t
+--   MINIMIZE  (SELECT sum(cost * x) FROM t)
+--   SUBJECTTO (SELECT sum(x) >= 1 FROM t, unnest(members) AS e GROUP BY e)
+--   USING solverlp
+CREATE OR REPLACE FUNCTION lp_gen_set_cover(elements int, sets int, density float8, seed int8 DEFAULT 0,
+	OUT set_id int, OUT cost float8, OUT members int[], OUT x boolean)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- A block-diagonal LP, a row per variable. Each of the blocks has "rows" constraints over its own "cols"
+-- variables, each constraint having "nnz_per_row" terms. Each of the "linking_rows" constraints has a term
+-- for a variable with the probability "linking_density". "ctrs" are the constraints of the variable,
+-- "coefs" its coefficients and "rhs" the right-hand sides of the constraints:
+--   SOLVESELECT x IN (SELECT * FROM lp_gen_block_diagonal(10, 100, 100, 5, 1, 0.01)) AS t
+--   MAXIMIZE  (SELECT sum(cost * x) FROM t)
+--   SUBJECTTO (SELECT 0 <= x <= 1 FROM t),
+--             (SELECT sum(c.coef * x) <= c.rhs FROM t, unnest(ctrs, coefs, rhs) AS c(ctr, coef, rhs)
+--              GROUP BY c.ctr, c.rhs)
+--   USING solverlp
+-- Without linking constraints the problem splits into a partition per block. Use "NULL::int AS x" in
+-- the input query for a MIP.
+CREATE OR REPLACE FUNCTION lp_gen_block_diagonal(blocks int, rows int, cols int, nnz_per_row int,
+	linking_rows int DEFAULT 0, linking_density float8 DEFAULT 0, seed int8 DEFAULT 0,
+	OUT var int, OUT block int, OUT cost float8, OUT ctrs int[], OUT coefs float8[], OUT rhs float8[], OUT x float8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- A random sparse LP, i.e., a single block of lp_gen_block_diagonal without linking constraints
+CREATE OR REPLACE FUNCTION lp_gen_sparse(rows int, cols int, nnz_per_row int, seed int8 DEFAULT 0,
+	OUT var int, OUT block int, OUT cost float8, OUT ctrs int[], OUT coefs float8[], OUT rhs float8[], OUT x float8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C IMMUTABLE STRICT;
@@ -21,6 +21,7 @@
 #include "utils/lsyscache.h"
 #include "parser/parse_type.h"
 #include "access/htup_details.h"
+#include "storage/fd.h"
 
 /* For GLPK solving*/
 #include "glpk.h"
@@ -30,6 +31,7 @@
 #include "libPgCbc.h"
 
 #include "prb_partition.h" /* For problem partitioning */
+#include "solvedb_probes.h" /* Static trace probes */
 #include <sys/time.h> /* For performance benchmarking */
 
 
@@ -109,6 +111,8 @@ static void compactLPproblem(LPproblem * prob, int ** varIndices);
 
 static void build_result(LPviewSolution * sol, int * ra_count, int ** ra_parids, Oid ** ra_types, Datum ** ra_values);
 static double time_diff(struct timeval *tod1, struct timeval *tod2);
+static void write_lp_model(LPproblem * prob, bool integral, const char * path);
+static void dump_lp_model(LPproblem * prob, bool integral);
 
 PG_MODULE_MAGIC;
 
@@ -222,15 +226,19 @@ static void lp_problem_solve(LPsolvingMode solvingMode, Datum slarg, int * ra_co
 	/* Main problem and solution */
 	LPproblem				* prob;				/* LP problem in the physical format */
 	LPsolverResult  		* prob_sol;			/* A solution in the physical format */
+	bool					integral;			/* Are the integer and boolean variables kept in the dumped model */
 	/* Transient variables */
 	MemoryContext			solverctx, oldcontext;
 	int						i;
+	ListCell				*c;
+	int64					nonzeros;
+	struct timeval			model_start, model_end;	/* For the solve statistics of SolverAPI */
+	SL_Profile_Mark			mark;
 
-	solverctx =  AllocSetContextCreate(CurrentMemoryContext,
-			   "SolverLP memory context",
-			   ALLOCSET_DEFAULT_MINSIZE,
-			   ALLOCSET_DEFAULT_INITSIZE,
-			   ALLOCSET_DEFAULT_MAXSIZE);
+	gettimeofday(&model_start, NULL);
+
+	/* The model is built in the solver work memory (see "solvedb.solver_work_mem") */
+	solverctx = sl_work_mem_context_create(CurrentMemoryContext, "SolverLP memory context");
 
 	oldcontext = MemoryContextSwitchTo(solverctx);
 
@@ -239,6 +247,7 @@ static void lp_problem_solve(LPsolvingMode solvingMode, Datum slarg, int * ra_co
 	/* Analyze the problem and build a LP problem definition */
 	arg_d = slarg;
 	arg = DatumGetSLSolverArg(slarg);
+	TRACE_SOLVEDB_MODEL_BUILD_START(arg->prb_rowcount, arg->prb_colcount);
 
 	/* Set the parameters */
 	settings.log_level        = sl_param_isset(arg, "log_level")      ? (int)  sl_param_get_as_int(arg, "log_level")      : WARNING;
@@ -297,10 +306,30 @@ static void lp_problem_solve(LPsolvingMode solvingMode, Datum slarg, int * ra_co
 
 	CHECK_FOR_INTERRUPTS();	// Check if someone has interrupted the operation
 
+	/* Report the model to SolverAPI */
+	nonzeros = 0;
+	foreach(c, prob->ctrs)
+		nonzeros += DatumGetLPfunction(sl_ctr_get_x_val((Sl_Ctr *) lfirst(c)))->numTerms;
+	gettimeofday(&model_end, NULL);
+	sl_solve_report()->model_time  = time_diff(&model_end, &model_start) * 1000.0;
+	sl_solve_report()->variables   = prob->numVariables - 1;
+	sl_solve_report()->constraints = list_length(prob->ctrs);
+	sl_solve_report()->nonzeros    = nonzeros;
+	TRACE_SOLVEDB_MODEL_BUILD_DONE(prob->numVariables - 1, list_length(prob->ctrs), nonzeros);
+
+	/*
+	 * Dump the model, if the solve is already slow. Otherwise, it is dumped when the solve ends. A failing
+	 * solve is not dumped, as no file is written while an error (e.g., a cancel or out of memory) is pending.
+	 */
+	integral = settings.solvingMode != LPsolvingBasic;
+	dump_lp_model(prob, integral);
+
 	/* The problem definition is built. Let's solve the problem */
 	prob_sol = solve_main_lp_problem(prob, &settings);
 	CHECK_FOR_INTERRUPTS();	// Check if someone has interrupted the operation
 
+	dump_lp_model(prob, integral);
+
 	MemoryContextSwitchTo(oldcontext);
 
 	/* Build the arrays, required by SolverAPI */
@@ -313,7 +342,9 @@ static void lp_problem_solve(LPsolvingMode solvingMode, Datum slarg, int * ra_co
 		sol_data.varTypes		 	= varTypes;
 		sol_data.prob_sol		 	= prob_sol;
 
+		sl_profile_start(&mark);
 		build_result(&sol_data, ra_count, ra_parids, ra_types, ra_values);
+		sl_profile_end(&mark, solverctx, "result");
 	} else
 		ereport(ERROR,
 				 (errcode(ERRCODE_NO_DATA_FOUND),
@@ -408,16 +439,20 @@ static pg_LPfunction * build_obj_function(Datum arg_d, SL_Solver_Arg * arg)
 	uint32 proc;
 	pg_LPfunction * result = NULL;
 	MemoryContext solver_context;
+	SL_Profile_Mark mark;
 
 	if (arg->problem->obj_dir != SOL_ObjDir_Maximize &&
 		arg->problem->obj_dir != SOL_ObjDir_Minimize)
 		return NULL;
 
+	sl_profile_start(&mark);
 	/* Build a source view to cast all unknown variables to "lp_function" type.
 	 * It uses the "lp_function_make" constructor. */
 	out = sl_build_out_func1subst(arg_d, "lp_function_make");
 	/* Build a destination view SQL for objective function */
 	dst = sl_build_dst_obj(arg_d, out);
+	sl_profile_end(&mark, CurrentMemoryContext, "view SQL");
+	sl_profile_start(&mark);
 	/* Get OID of the lp_function type */
 	lppol_oid = get_lp_function_oid();
 	/* Remember the current memory context */
@@ -489,6 +524,7 @@ static pg_LPfunction * build_obj_function(Datum arg_d, SL_Solver_Arg * arg)
 		elog(ERROR, "SolverLP: SPI_finish returned %d", ret);
 	pfree(dst);
 	pfree(out);
+	sl_profile_end(&mark, CurrentMemoryContext, "objective");
 
 	return result;
 }
@@ -501,10 +537,13 @@ static List * build_ctr_ineq(Datum arg_d, SL_Solver_Arg * arg)
 	Oid				slctr_oid;
 	MemoryContext 	solver_context;
 	List			*result;
+	SL_Profile_Mark	mark;
 
 	/* Build a source view to cast all unknown variables to "lp_function" type.
 	   It uses the "lp_function_make" constructor. */
+	sl_profile_start(&mark);
 	out = sl_build_out_func1subst(arg_d, "lp_function_make");
+	sl_profile_end(&mark, CurrentMemoryContext, "view SQL");
 	/* Get the OID of "lp_function" type. This type is a part of SolverLP. */
 	lppol_oid = get_lp_function_oid();
 	/* Get the OID of "sl_ctr" type. This type is a part of SolverAPI. */
@@ -521,6 +560,7 @@ static List * build_ctr_ineq(Datum arg_d, SL_Solver_Arg * arg)
 		uint32			proc;
 		int				i,j;
 
+		sl_profile_start(&mark);
 		/* Build a viewsql for [Constraint] destination view */
 		dst = sl_build_dst_ctr(arg_d, out, c);
 
@@ -579,6 +619,7 @@ static List * build_ctr_ineq(Datum arg_d, SL_Solver_Arg * arg)
 		if ((ret = SPI_finish()) < 0)
 			elog(ERROR, "SolverLP: SPI_finish returned %d", ret);
 		pfree(dst);
+		sl_profile_end(&mark, CurrentMemoryContext, "constraint %d", c);
 	}
 	pfree(out);
 
@@ -698,6 +739,7 @@ static LPsolverResult * solve_partition_glpk(LPproblem * prob, LPsolverSettings
 	int		 		i,j;
 	int		 		* inds;
 	double 	 		* vals;
+	int64			nonzeros = 0;
 	MemoryContext 	old_context;
 	MemoryContext 	glp_context;
 	struct timeval 	start_time, end_time; /* For performance benchmarking */
@@ -724,11 +766,7 @@ static LPsolverResult * solve_partition_glpk(LPproblem * prob, LPsolverSettings
 	 * Use per-tuple memory context to prevent leak of memory used to read
 	 * rows from the file with Copy routines.
 	 */
-	glp_context = AllocSetContextCreate(CurrentMemoryContext,
-									   "GLPK temporary context",
-									   ALLOCSET_DEFAULT_MINSIZE,
-									   ALLOCSET_DEFAULT_INITSIZE,
-									   ALLOCSET_DEFAULT_MAXSIZE);
+	glp_context = sl_work_mem_context_create(CurrentMemoryContext, "GLPK temporary context");
 	old_context = MemoryContextSwitchTo(glp_context);
 
 	PG_TRY();
@@ -835,6 +873,7 @@ static LPsolverResult * solve_partition_glpk(LPproblem * prob, LPsolverSettings
 		}
 
 		glp_set_mat_row(lp, i+1, j, inds, vals);
+		nonzeros += j;
 
 		i++;
 	}
@@ -844,6 +883,7 @@ static LPsolverResult * solve_partition_glpk(LPproblem * prob, LPsolverSettings
 
 	/* Measure the solving time */
 	glpk_log_printf("Measuring of time started\n");
+	TRACE_SOLVEDB_GLPK_START(result->numVariables, list_length(prob->ctrs), nonzeros);
 	gettimeofday(&start_time, NULL);
 
 	switch (settings->solvingMode) {
@@ -889,6 +929,8 @@ static LPsolverResult * solve_partition_glpk(LPproblem * prob, LPsolverSettings
 	/* Compute and output the solving time*/
 	gettimeofday(&end_time, NULL);
 	result->solvingTime = time_diff(&end_time, &start_time);
+	TRACE_SOLVEDB_GLPK_DONE(result->numVariables,
+							settings->solvingMode == LPsolvingMIP ? glp_mip_status(lp) : glp_get_status(lp));
 
 	glpk_log_printf("Time used in GLPK solving: %.6f secs\n", result->solvingTime);
 
@@ -933,11 +975,7 @@ static LPsolverResult * solve_partition_cbc(LPproblem * prob, LPsolverSettings *
 	LPsolverResult 	* solres = NULL, * result = NULL;
 	int				* varIndices = NULL;
 
-	cbc_context = AllocSetContextCreate(CurrentMemoryContext,
-			"CBC solving context",
-			ALLOCSET_DEFAULT_MINSIZE,
-			ALLOCSET_DEFAULT_INITSIZE,
-			ALLOCSET_DEFAULT_MAXSIZE);
+	cbc_context = sl_work_mem_context_create(CurrentMemoryContext, "CBC solving context");
 
 	old_context = MemoryContextSwitchTo(cbc_context);
 
@@ -991,33 +1029,42 @@ static LPsolverResult * solve_main_lp_problem(LPproblem * prob,	LPsolverSettings
 	ListCell * c;
 	int i, j;
 	struct timeval slv_start, slv_end, part_start, part_end; /* For performance benchmarking */
+	SL_Profile_Mark mark;
 
 	if (settings->partition_size > 0) /* If problem paritioning is requested */
 	{
 		if (settings->log_level <= NOTICE) gettimeofday(&part_start, NULL);
+		sl_profile_start(&mark);
 
 		/* Partitioning */
 		s_prbs = partitionLPproblem(prob, settings->partition_size); /* Partition the main problem */
 
+		sl_profile_end(&mark, CurrentMemoryContext, "partitioning");
 		if (settings->log_level <= NOTICE) gettimeofday(&part_end, NULL);
 	}
 
+	/* Report the number of partitions to SolverAPI */
+	sl_solve_report()->partitions = s_prbs == NULL ? 1 : list_length(s_prbs);
+
 	/* Start measuring solving time */
 	if (settings->log_level <= NOTICE)	gettimeofday(&slv_start, NULL);
 
 	if (s_prbs == NULL || list_length(s_prbs) == 1) /* The problem cannot be partitioned. */
+	{
+		TRACE_SOLVEDB_PARTITION_SOLVE_START(1, list_length(prob->ctrs));
+		sl_profile_start(&mark);
 		result = SOLVE_PARTITION(prob, settings);   /* Solve the main problem. */
+		sl_profile_end(&mark, CurrentMemoryContext, "solve");
+		TRACE_SOLVEDB_PARTITION_SOLVE_DONE(1, result != NULL ? result->numVariables : 0);
+	}
 	else {
 
 		/* OK. The partitioning is possible. Let's solve each problem individually */
-		part_context = AllocSetContextCreate(CurrentMemoryContext,
-				"SolverLP partitioned problem solving context",
-				ALLOCSET_DEFAULT_MINSIZE,
-				ALLOCSET_DEFAULT_INITSIZE,
-				ALLOCSET_DEFAULT_MAXSIZE);
+		part_context = sl_work_mem_context_create(CurrentMemoryContext, "SolverLP partitioned problem solving context");
 		old_context = MemoryContextSwitchTo(part_context);
 
 		/* Solve each problem */
+		i = 0;
 		foreach(c, s_prbs)
 		{
 			LPproblem * sprob = (LPproblem *) lfirst(c);
@@ -1028,7 +1075,11 @@ static LPsolverResult * solve_main_lp_problem(LPproblem * prob,	LPsolverSettings
 				gettimeofday(&pstart, NULL);
 
 			/* Solve the partition */
+			TRACE_SOLVEDB_PARTITION_SOLVE_START(i + 1, list_length(sprob->ctrs));
+			sl_profile_start(&mark);
 			sprob_sol = SOLVE_PARTITION(sprob, settings);
+			sl_profile_end(&mark, part_context, "partition %d", ++i);
+			TRACE_SOLVEDB_PARTITION_SOLVE_DONE(i, sprob_sol != NULL ? sprob_sol->numVariables : 0);
 
 			CHECK_FOR_INTERRUPTS();	// Check if someone has interrupted the operation
 
@@ -1166,6 +1217,9 @@ static void build_result(LPviewSolution * sol, int * ra_count, int ** ra_parids,
   static Oid	*lra_types;
   static Datum  *lra_values;
 
+  /* The dense result arrays are built in the caller's context. Check them against the solver work memory. */
+  sl_work_mem_check((Size) sol->arg->prb_varcount * (sizeof(double) + sizeof(Datum) + sizeof(bool)) * 2);
+
   /* Searches for integer/float values */
   found = false;
   /* Initialize the float array */
@@ -1290,3 +1344,107 @@ static inline double time_diff(struct timeval *tod1, struct timeval *tod2)
     t2 = tod2->tv_sec * 1E6 + tod2->tv_usec;
     return ((double)(t1 - t2)) / 1E6;
 }
+
+/* Appends a term of a linear function in the LP format */
+static void write_lp_term(FILE * file, double factor, int varNr, int termNr)
+{
+	fprintf(file, "%s%s %.15g x%d", termNr > 0 && termNr % 8 == 0 ? "\n " : "",
+			factor < 0 ? " -" : " +", fabs(factor), varNr);
+}
+
+/*
+ * Writes the model in the (CPLEX) LP format, which GLPK and CBC can read. The variables are named "x<number>",
+ * as the unknown variables of SolverAPI. Unless "integral", integer and boolean variables are relaxed, as in
+ * the basic LP solving. A failure to write the file does not fail the solve.
+ */
+static void write_lp_model(LPproblem * prob, bool integral, const char * path)
+{
+	FILE		*file;
+	ListCell	*c;
+	int			i, j;
+
+	if ((file = AllocateFile(path, PG_BINARY_W)) == NULL)
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("SolverLP: could not open the model file \"%s\": %m", path)));
+		return;
+	}
+
+	fprintf(file, "\\ SolveDB model: %d variables, %d constraints\n", prob->numVariables - 1, list_length(prob->ctrs));
+	fprintf(file, "%s\n obj:", prob->objDirection == LPobjMaximize ? "Maximize" : "Minimize");
+	if (prob->obj != NULL && prob->obj->numTerms > 0)
+		for (j = 0; j < prob->obj->numTerms; j++)
+			write_lp_term(file, prob->obj->term[j].factor, prob->obj->term[j].varNr, j);
+	else
+		fprintf(file, " 0 x1");
+	if (prob->obj != NULL && prob->obj->factor0 != 0)
+		fprintf(file, " %s %.15g", prob->obj->factor0 < 0 ? "-" : "+", fabs(prob->obj->factor0));
+
+	/* The constraints are "c op f(x)", thus the operator is mirrored when the function is moved to the left */
+	fprintf(file, "\nSubject To\n");
+	i = 0;
+	foreach(c, prob->ctrs)
+	{
+		Sl_Ctr			*ne = lfirst(c);
+		pg_LPfunction	*poly = DatumGetLPfunction(sl_ctr_get_x_val(ne));
+		double			value = ne->c_val - poly->factor0;
+		const char		*op;
+
+		switch (ne->op)
+		{
+			case SL_CtrType_EQ: op = "=";  break;
+			case SL_CtrType_NE: op = "=";  value = 1 - value; break;	/* Boolean negation */
+			case SL_CtrType_LT: op = ">="; value = value + 1; break;	/* Integer only */
+			case SL_CtrType_GT: op = "<="; value = value - 1; break;	/* Integer only */
+			case SL_CtrType_GE: op = "<="; break;
+			default:			op = ">="; break;
+		}
+
+		fprintf(file, " c%d:", ++i);
+		for (j = 0; j < poly->numTerms; j++)
+			write_lp_term(file, poly->term[j].factor, poly->term[j].varNr, j);
+		fprintf(file, " %s %.15g\n", op, value);
+	}
+
+	fprintf(file, "Bounds\n");
+	for (i = 1; i < prob->numVariables; i++)
+		if (!integral || prob->varTypes[i] != LPtypeBool)
+			fprintf(file, " x%d free\n", i);
+
+	if (integral)
+	{
+		fprintf(file, "General\n");
+		for (i = 1; i < prob->numVariables; i++)
+			if (prob->varTypes[i] == LPtypeInteger)
+				fprintf(file, " x%d\n", i);
+
+		fprintf(file, "Binary\n");
+		for (i = 1; i < prob->numVariables; i++)
+			if (prob->varTypes[i] == LPtypeBool)
+				fprintf(file, " x%d\n", i);
+	}
+
+	fprintf(file, "End\n");
+
+	if (FreeFile(file))
+	{
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("SolverLP: could not write the model file \"%s\": %m", path)));
+		return;
+	}
+
+	strlcpy(sl_solve_report()->model_file, path, MAXPGPATH);
+}
+
+/* Dumps the model of a slow solve once, if requested (see "solvedb.log_solve_model") */
+static void dump_lp_model(LPproblem * prob, bool integral)
+{
+	char * model_path;
+
+	if (sl_solve_report()->model_file[0] != '\0')
+		return;
+	if ((model_path = sl_solve_model_path("lp")) != NULL)
+		write_lp_model(prob, integral, model_path);
+}
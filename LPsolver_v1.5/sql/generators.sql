@@ -0,0 +1,66 @@
+-- Checks the synthetic problem generators: the shapes, the reproducibility by seed and solving the problems
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- The transportation problem: a route per source and destination, with enough supply
+select count(*) as routes, count(distinct src) as sources, count(distinct dst) as destinations,
+       bool_and(x is null) as unknown
+from lp_gen_transportation(20, 30, 1);
+
+select (select sum(supply) from (select distinct src, supply from lp_gen_transportation(20, 30, 1)) as s) >=
+       (select sum(demand) from (select distinct dst, demand from lp_gen_transportation(20, 30, 1)) as d) as feasible;
+
+-- The same seed gives the same relation, another seed a different one
+select count(*) as mismatches
+from (select * from lp_gen_transportation(20, 30, 1) except all select * from lp_gen_transportation(20, 30, 1)) as d;
+
+select count(*) > 0 as differs
+from (select * from lp_gen_transportation(20, 30, 1) except all select * from lp_gen_transportation(20, 30, 2)) as d;
+
+-- The multiple knapsack problem
+select count(*) as pairs, count(distinct item) as items, count(distinct knapsack) as knapsacks
+from lp_gen_multi_knapsack(50, 5, 1);
+
+-- The set cover problem: every element is in some set
+select count(*) as sets from lp_gen_set_cover(100, 10, 0.05, 1);
+
+select count(distinct e) as covered from lp_gen_set_cover(100, 10, 0.05, 1), unnest(members) as e;
+
+-- The block-diagonal problem: without linking constraints, no constraint spans two blocks
+select count(*) as variables, count(distinct block) as blocks, sum(array_length(ctrs, 1)) as nonzeros
+from lp_gen_block_diagonal(10, 20, 100, 5, 0, 0, 1);
+
+select count(*) as linking
+from (select c from lp_gen_block_diagonal(10, 20, 100, 5, 0, 0, 1), unnest(ctrs) as c
+      group by c having count(distinct block) > 1) as l;
+
+select count(*) as linking
+from (select c from lp_gen_block_diagonal(10, 20, 100, 5, 2, 1, 1), unnest(ctrs) as c
+      group by c having count(distinct block) = 10) as l;
+
+-- The random sparse problem
+select count(*) as variables from lp_gen_sparse(50, 40, 4, 1);
+
+select count(distinct c) as constraints, count(*) as nonzeros from lp_gen_sparse(50, 40, 4, 1), unnest(ctrs) as c;
+
+-- Invalid arguments
+select * from lp_gen_assignment(0);
+select * from lp_gen_sparse(10, 5, 6);
+
+-- Solving the assignment problem assigns each agent once
+select count(*) filter (where x) as assigned
+from (SOLVESELECT x IN (SELECT * FROM lp_gen_assignment(8, 1)) AS t
+      MINIMIZE  (SELECT sum(cost * x) FROM t)
+      SUBJECTTO (SELECT sum(x) = 1 FROM t GROUP BY agent),
+                (SELECT sum(x) = 1 FROM t GROUP BY task)
+      USING solverlp(log_level:=19)) AS s;
+
+-- Solving the block-diagonal problem keeps the variables within the bounds
+select count(*) as variables, bool_and(x between -1e-9 and 1 + 1e-9) as bounded
+from (SOLVESELECT x IN (SELECT * FROM lp_gen_block_diagonal(4, 10, 20, 3, 1, 0.1, 1)) AS t
+      MAXIMIZE  (SELECT sum(cost * x) FROM t)
+      SUBJECTTO (SELECT 0 <= x <= 1 FROM t),
+                (SELECT sum(c.coef * x) <= c.rhs FROM t, unnest(ctrs, coefs, rhs) AS c(ctr, coef, rhs)
+                 GROUP BY c.ctr, c.rhs)
+      USING solverlp(log_level:=19)) AS s;
@@ -0,0 +1,37 @@
+-- Runs the lp_function microbenchmark on small inputs. The timings vary, so only the shapes of the results are checked.
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- 1000 terms over 250 variables: the aggregates, "+" and chain merge the duplicates, "*" and unnest keep all terms
+select o.operation, b.distinct_vars, b.result_terms, b.ns_per_term >= 0 as timed, b.peak_bytes > 0 as allocated
+from unnest(array['sum', 'sum_hash', 'sum_sorted', 'sum_array', '+', 'chain', '*', 'unnest']) with ordinality as o(operation, n),
+     lateral lp_function_bench(o.operation, 1000, 0.5, 0.75, loops := 1) as b
+order by o.n;
+
+-- Ordered terms
+select o.operation, b.result_terms
+from unnest(array['sum', 'sum_sorted', 'sum_array']) with ordinality as o(operation, n),
+     lateral lp_function_bench(o.operation, 1000, 1, 0.5, ordered := true, loops := 1) as b
+order by o.n;
+
+-- The array-based aggregation allocates for the whole range of the variable numbers
+select (select peak_bytes from lp_function_bench('sum_array', 1000, 0.001, loops := 1)) >
+       (select peak_bytes from lp_function_bench('sum_array', 1000, 1, loops := 1)) as sparse_numbers_cost_more;
+
+-- The adaptive sum gives the same functions as the array-based aggregation on dense, sparse and skewed variable numbers
+select d.distribution, count(distinct v.var) as vars,
+       sum(lp_function_make(v.var) * v.factor)::text = sum_array(lp_function_make(v.var) * v.factor)::text as same
+from (values ('dense', 1), ('sparse', 2), ('skewed', 3)) as d(distribution, n),
+     lateral (select (case d.n when 1 then i % 500 + 1
+                               when 2 then (i % 500) * 1000 + 1
+                               else (i % 500) * (i % 500) / 500 + 1 end)::int8 as var,
+                     (i % 3 + 1)::float8 as factor
+              from generate_series(1, 5000) as i) as v
+group by d.distribution, d.n
+order by d.n;
+
+-- Invalid arguments
+select * from lp_function_bench('max', 10);
+select * from lp_function_bench('sum', 10, 0);
+select * from lp_function_bench('sum', 10, skew := 1);
@@ -0,0 +1,89 @@
+-- Builds long lp_functions with chains of operators, which extend an expanded lp_function in place
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- Evaluates a generated expression over "v", a column of a single row with the value 0
+create function lp_eval(expr text) returns lp_function as $$
+declare
+	result lp_function;
+begin
+	execute 'select ' || expr || ' from generate_series(0, 0) as v' into result;
+	return result;
+end;
+$$ language plpgsql;
+
+-- Adds the terms one by one in PL/pgSQL
+create function lp_accumulate(n int) returns lp_function as $$
+declare
+	f lp_function := 0;
+begin
+	for i in 1 .. n loop
+		f := f + lp_function_make(i % 1000 + 1) * (i % 7 + 1);
+	end loop;
+	return f;
+end;
+$$ language plpgsql;
+
+-- The 40 terms over 4 variables are merged and sorted when the function is returned
+select lp_eval(string_agg(format('lp_function_make(v + %s)', i % 4 + 1), ' + ' order by i))
+from generate_series(1, 40) as i;
+
+-- A chain of 500 terms over 200 variables is the same function as their sum
+select lp_eval(string_agg(format('lp_function_make(v + %s) * %s', i % 200 + 1, i % 7 + 1), ' + ' order by i))::text =
+       (select sum(lp_function_make(i % 200 + 1) * (i % 7 + 1))::text from generate_series(1, 500) as i) as same
+from generate_series(1, 500) as i;
+
+-- Subtractions and scaling
+select lp_eval(string_agg(format('lp_function_make(v + %s) * %s', i, i % 7 + 1), ' - ' order by i))::text =
+       (select (4 * lp_function_make(1) - sum(lp_function_make(i) * (i % 7 + 1)))::text from generate_series(1, 100) as i) as same
+from generate_series(1, 100) as i;
+
+select (f * 2 - f / 4 - f)::text = (f * 0.75)::text as same, (f - null)::text = f::text as same_null
+from (select lp_accumulate(3000) as f) as a;
+
+-- The accumulated function is flattened when stored
+create table lp_stored (f lp_function);
+insert into lp_stored select lp_accumulate(3000);
+
+select f::text = (select sum(lp_function_make(i % 1000 + 1) * (i % 7 + 1))::text from generate_series(1, 3000) as i) as same,
+       (select count(*) from lp_function_unnest(f)) as terms
+from lp_stored;
+
+drop table lp_stored;
+
+-- A read-only function keeps its value after its terms are passed over to a sum, and after the sum is deleted
+create function lp_branch(n int) returns boolean as $$
+declare
+	f lp_function := 0;
+	g lp_function;
+	h lp_function;
+begin
+	for i in 1 .. n loop
+		f := f + lp_function_make(i);
+	end loop;
+	g := f + lp_function_make(n + 1);
+	h := f - lp_function_make(1);
+	g := null;
+	return f::text = (select sum(lp_function_make(i))::text from generate_series(1, n) as i) and
+	       h::text = (select (sum(lp_function_make(i)) - lp_function_make(1))::text from generate_series(1, n) as i);
+end;
+$$ language plpgsql;
+
+select lp_branch(100) as same;
+
+-- A loop of f := f + x in PL/pgSQL takes linear time: 8 times more terms take far less than 64 times as long
+create function lp_accumulate_ms(n int) returns float8 as $$
+declare
+	start timestamptz := clock_timestamp();
+begin
+	perform lp_accumulate(n);
+	return extract(epoch from clock_timestamp() - start) * 1000;
+end;
+$$ language plpgsql;
+
+select lp_accumulate_ms(80000) < 20 * greatest(lp_accumulate_ms(10000), 1) as linear;
+drop function lp_accumulate_ms(int);
+drop function lp_branch(int);
+drop function lp_accumulate(int);
+drop function lp_eval(text);
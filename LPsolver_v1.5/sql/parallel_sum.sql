@@ -0,0 +1,42 @@
+-- Runs sum(lp_function) in parallel workers, and compares the results with the serial aggregation
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- 100000 terms over 7000 variables in 10 groups. The factors are integers, thus the sums are exact in any order.
+create table par_terms (grp int, var int8, factor float8);
+insert into par_terms (grp, var, factor)
+select i % 10, (i * 7919) % 7000 + 1, i % 5 - 2 from generate_series(1, 100000) as i;
+analyze par_terms;
+
+-- The serial results
+set max_parallel_workers_per_gather = 0;
+create temp table par_serial as
+select grp, sum(lp_function_make(var) * factor)::text as f from par_terms group by grp;
+create temp table par_serial_total as
+select sum(lp_function_make(var) * factor)::text as f from par_terms;
+
+-- The parallel plan
+set max_parallel_workers_per_gather = 2;
+set parallel_setup_cost = 0;
+set parallel_tuple_cost = 0;
+set min_parallel_relation_size = 0;
+
+explain (costs off)
+select sum(lp_function_make(var) * factor) from par_terms;
+
+-- The parallel results are identical
+select count(*) as mismatches
+from ((select grp, sum(lp_function_make(var) * factor)::text from par_terms group by grp
+       except all table par_serial) union all
+      (table par_serial
+       except all select grp, sum(lp_function_make(var) * factor)::text from par_terms group by grp)) as d;
+
+select (select sum(lp_function_make(var) * factor)::text from par_terms) = f as same from par_serial_total;
+
+reset max_parallel_workers_per_gather;
+reset parallel_setup_cost;
+reset parallel_tuple_cost;
+reset min_parallel_relation_size;
+
+drop table par_terms;
@@ -0,0 +1,121 @@
+-- The planner estimates of SOLVESELECT (see "solvedb.solve_estimates")
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- The planner hook is installed when SolverAPI loads
+load 'solverapi';
+
+-- The function scans of a query plan, as (rows, startup cost)
+create function est_scans(query text) returns table (rows int, startup float8) as $$
+declare
+	line text;
+begin
+	for line in execute 'explain ' || query loop
+		if line ~ 'Function Scan' then
+			rows := substring(line from 'rows=(\d+)')::int;
+			startup := substring(line from 'cost=([0-9.]+)\.\.')::float8;
+			return next;
+		end if;
+	end loop;
+end
+$$ language plpgsql;
+
+-- Checks if a query is planned with a nested loop
+create function est_nested_loop(query text) returns boolean as $$
+declare
+	line text;
+begin
+	for line in execute 'explain ' || query loop
+		if line ~ 'Nested Loop' then
+			return true;
+		end if;
+	end loop;
+	return false;
+end
+$$ language plpgsql;
+
+-- The knapsack problem (DemoQueries/knapsack.sql) of 5000 items
+create table est_items (
+	id int PRIMARY KEY,
+	weight float8,
+	profit float8,
+	quantity int
+);
+
+insert into est_items (id, weight, profit, quantity)
+select i, 1 + i % 10, 1 + i % 7, NULL from generate_series(1, 5000) as i;
+analyze est_items;
+
+-- The output rows are the input rows of the solve
+select rows from est_scans($q$
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp) AS s
+$q$);
+
+select rows between 1 and 20 as small from est_scans($q$
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items WHERE id <= 10) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp) AS s
+$q$);
+
+-- The cost grows with the constraints
+select (select startup from est_scans($q$
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp) AS s
+$q$)) >
+       (select startup from est_scans($q$
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u)
+USING solverlp) AS s
+$q$)) as grows;
+
+-- A solve of a few items joined back to the items is planned with a nested loop over the index
+select est_nested_loop($q$
+SELECT i.id, s.quantity FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items WHERE id <= 10) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp) AS s JOIN est_items i ON i.id = s.id
+$q$);
+
+-- Without the estimates, the solves are estimated with the ROWS of "sl_solve"
+set solvedb.solve_estimates = off;
+
+select rows from est_scans($q$
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items WHERE id <= 10) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp) AS s
+$q$);
+
+select est_nested_loop($q$
+SELECT i.id, s.quantity FROM (
+SOLVESELECT quantity IN (SELECT * FROM est_items WHERE id <= 10) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp) AS s JOIN est_items i ON i.id = s.id
+$q$);
+
+reset solvedb.solve_estimates;
+
+drop function est_scans(text);
+drop function est_nested_loop(text);
+drop table est_items;
@@ -0,0 +1,238 @@
+-- Compares the native (C) and the PL/pgSQL implementations of the SOLVE function
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- The knapsack problem (DemoQueries/knapsack.sql)
+create table item (
+	item text PRIMARY KEY,
+	weight float8,
+	profit float8,
+	quantity int
+);
+
+insert into item (item, weight, profit, quantity)
+values ('item 1', 10.0, 5.0, NULL),
+       ('item 2',  9.0, 4.5, NULL),
+       ('item 3',  1.5, 2.0, NULL),
+       ('item 4',  7.0, 3.0, NULL);
+
+set solvedb.native_solve = off;
+create temp table knapsack_plpgsql as
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM item) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp(log_level:=19)) AS s;
+
+set solvedb.native_solve = on;
+create temp table knapsack_native as
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM item) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp(log_level:=19)) AS s;
+
+select count(*) as mismatches
+from ((table knapsack_native except all table knapsack_plpgsql) union all
+      (table knapsack_plpgsql except all table knapsack_native)) as d;
+
+select item, quantity from knapsack_native order by item;
+
+-- The input relation kept in memory
+set solvedb.input_mode = tuplestore;
+create temp table knapsack_tuplestore as
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM item) as u
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= 15 FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp(log_level:=19)) AS s;
+
+select count(*) as mismatches
+from ((table knapsack_tuplestore except all table knapsack_plpgsql) union all
+      (table knapsack_plpgsql except all table knapsack_tuplestore)) as d;
+
+reset solvedb.input_mode;
+
+-- The knapsack problem with a common table expression
+set solvedb.native_solve = off;
+create temp table knapsack_cte_plpgsql as
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM item) as u
+WITH (SELECT 15.0::float8 AS cap) AS c
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= (SELECT cap FROM c) FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp.mip(log_level:=19)) AS s;
+
+set solvedb.native_solve = on;
+create temp table knapsack_cte_native as
+SELECT * FROM (
+SOLVESELECT quantity IN (SELECT * FROM item) as u
+WITH (SELECT 15.0::float8 AS cap) AS c
+MAXIMIZE  (SELECT SUM(quantity * profit) FROM u)
+SUBJECTTO (SELECT SUM(quantity * weight) <= (SELECT cap FROM c) FROM u),
+	  (SELECT 0 <= quantity <=1 FROM u)
+USING solverlp.mip(log_level:=19)) AS s;
+
+select count(*) as mismatches
+from ((table knapsack_cte_native except all table knapsack_cte_plpgsql) union all
+      (table knapsack_cte_plpgsql except all table knapsack_cte_native)) as d;
+
+drop table item;
+
+-- The sudoku problem (DemoQueries/sudoku.sql)
+create table sudoku_givens as
+select col, lin, val
+from (values (1,9,5),(1,8,6),(1,6,8),(1,5,4),(1,4,7),
+             (2,9,3),(2,7,9),(2,3,6),
+             (3,7,8),
+             (4,8,1),(4,5,8),(4,2,4),
+             (5,9,7),(5,8,9),(5,6,6),(5,4,2),(5,2,1),(5,1,8),
+             (6,8,5),(6,5,3),(6,2,9),
+             (7,3,2),
+             (8,7,6),(8,3,8),(8,1,7),
+             (9,6,3),(9,5,1),(9,4,6),(9,2,5),(9,1,9)) as g (col, lin, val);
+
+set solvedb.native_solve = off;
+create temp table sudoku_plpgsql as
+SELECT * FROM (
+   SOLVESELECT sel IN (SELECT c.col, l.lin, v.val, (g.val IS NOT NULL) AS giv, NULL::boolean AS sel
+                       FROM generate_series(1,9) AS c (col) CROSS JOIN generate_series(1,9) AS l (lin)
+                            CROSS JOIN generate_series(1,9) AS v (val)
+                            LEFT OUTER JOIN sudoku_givens g ON g.col = c.col AND g.lin = l.lin AND g.val = v.val) as sudoku
+   SUBJECTTO
+          (SELECT sel = giv FROM sudoku WHERE giv),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY lin, col),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY val, lin),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY val, col),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY val, ((col-1) / 3), ((lin-1) / 3))
+   USING solverlp(log_level:=19)) s;
+
+set solvedb.native_solve = on;
+create temp table sudoku_native as
+SELECT * FROM (
+   SOLVESELECT sel IN (SELECT c.col, l.lin, v.val, (g.val IS NOT NULL) AS giv, NULL::boolean AS sel
+                       FROM generate_series(1,9) AS c (col) CROSS JOIN generate_series(1,9) AS l (lin)
+                            CROSS JOIN generate_series(1,9) AS v (val)
+                            LEFT OUTER JOIN sudoku_givens g ON g.col = c.col AND g.lin = l.lin AND g.val = v.val) as sudoku
+   SUBJECTTO
+          (SELECT sel = giv FROM sudoku WHERE giv),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY lin, col),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY val, lin),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY val, col),
+          (SELECT sum(sel)=1 FROM sudoku GROUP BY val, ((col-1) / 3), ((lin-1) / 3))
+   USING solverlp(log_level:=19)) s;
+
+select count(*) as mismatches
+from ((table sudoku_native except all table sudoku_plpgsql) union all
+      (table sudoku_plpgsql except all table sudoku_native)) as d;
+
+select count(*) as selected from sudoku_native where sel;
+
+drop table sudoku_givens;
+
+-- The diet problem (DemoQueries/stigler.sql) over 20 commodities and 9 nutrients, an LP with float values
+create table allowance as
+select nid, (10 * nid)::float8 as value from generate_series(1, 9) as nid;
+create table commodities as
+select cid, (1 + cid % 7)::float8 as price from generate_series(1, 20) as cid;
+create table cnvalues as
+select c.cid, a.nid, ((c.cid * 31 + a.nid * 17) % 100 / 10.0)::float8 as value
+from commodities as c, allowance as a;
+
+set solvedb.native_solve = off;
+create temp table stigler_plpgsql as
+SELECT * FROM (
+ SOLVESELECT exp_daily IN (SELECT cid, price, NULL::float8 AS exp_daily FROM commodities) AS t
+ MINIMIZE (SELECT sum(price * exp_daily) FROM t)
+ SUBJECTTO
+    (SELECT exp_daily >= 0 FROM t),
+    (SELECT sum(v.value * exp_daily) >= (SELECT value FROM allowance a WHERE a.nid = v.nid)
+     FROM t INNER JOIN cnvalues v ON t.cid = v.cid
+     GROUP BY v.nid)
+ USING solverlp(log_level:=19)) AS s;
+
+set solvedb.native_solve = on;
+create temp table stigler_native as
+SELECT * FROM (
+ SOLVESELECT exp_daily IN (SELECT cid, price, NULL::float8 AS exp_daily FROM commodities) AS t
+ MINIMIZE (SELECT sum(price * exp_daily) FROM t)
+ SUBJECTTO
+    (SELECT exp_daily >= 0 FROM t),
+    (SELECT sum(v.value * exp_daily) >= (SELECT value FROM allowance a WHERE a.nid = v.nid)
+     FROM t INNER JOIN cnvalues v ON t.cid = v.cid
+     GROUP BY v.nid)
+ USING solverlp(log_level:=19)) AS s;
+
+-- The optimal cost is the same, and the native diet meets the allowances
+select (select round(sum(price * exp_daily)::numeric, 6) from stigler_native) =
+       (select round(sum(price * exp_daily)::numeric, 6) from stigler_plpgsql) as same_cost,
+       (select count(*) from stigler_native) as commodities,
+       (select bool_and(exp_daily >= -1e-9) from stigler_native) as nonnegative,
+       (select bool_and(d.value >= a.value - 1e-6)
+        from (select v.nid, sum(v.value * s.exp_daily) as value
+              from stigler_native s inner join cnvalues v on s.cid = v.cid group by v.nid) as d
+             inner join allowance a on a.nid = d.nid) as allowances_met;
+
+drop table cnvalues, commodities, allowance;
+
+-- Curve fitting (DemoQueries/curve_fitting.sql) of points on the line y = 1.3x + 1. The black-box objective of
+-- the demo is replaced by the maximum absolute deviation, which makes the fit an LP.
+create table points as
+select id, (id * 2.0)::float8 as x, (1.3 * id * 2.0 + 1)::float8 as y from generate_series(0, 100) as id;
+
+set solvedb.native_solve = off;
+create temp table fit_plpgsql as
+SELECT * FROM (
+ SOLVESELECT a, b, d IN (SELECT NULL::float8 AS a, NULL::float8 AS b, NULL::float8 AS d) AS t
+ MINIMIZE  (SELECT sum(d) FROM t)
+ SUBJECTTO (SELECT d >= y - (a * x + b), d >= a * x + b - y FROM t, points),
+           (SELECT -100 <= a <= 100, -100 <= b <= 100 FROM t)
+ USING solverlp(log_level:=19)) AS s;
+
+set solvedb.native_solve = on;
+create temp table fit_native as
+SELECT * FROM (
+ SOLVESELECT a, b, d IN (SELECT NULL::float8 AS a, NULL::float8 AS b, NULL::float8 AS d) AS t
+ MINIMIZE  (SELECT sum(d) FROM t)
+ SUBJECTTO (SELECT d >= y - (a * x + b), d >= a * x + b - y FROM t, points),
+           (SELECT -100 <= a <= 100, -100 <= b <= 100 FROM t)
+ USING solverlp(log_level:=19)) AS s;
+
+select count(*) as mismatches
+from ((select round(a::numeric, 4), round(b::numeric, 4), round(d::numeric, 4) from fit_native
+       except all select round(a::numeric, 4), round(b::numeric, 4), round(d::numeric, 4) from fit_plpgsql) union all
+      (select round(a::numeric, 4), round(b::numeric, 4), round(d::numeric, 4) from fit_plpgsql
+       except all select round(a::numeric, 4), round(b::numeric, 4), round(d::numeric, 4) from fit_native)) as f;
+
+select round(a::numeric, 4) as a, round(b::numeric, 4) as b, round(d::numeric, 4) as d from fit_native;
+
+drop table points;
+
+-- Invalid parameter values are reported the same way
+SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t
+SUBJECTTO (SELECT x >= 0 FROM t)
+USING solverlp(log_level:='abc');
+
+-- The solver work memory is measured in each phase, and a solve exceeding its budget fails
+select count(*) as solved
+from (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t
+      MINIMIZE (SELECT x FROM t)
+      SUBJECTTO (SELECT x >= 1 FROM t)
+      USING solverlp()) s;
+
+select bool_or(work_mem_peak > 0) as measured from sl_last_solve_profile();
+
+set solvedb.solver_work_mem = 1;
+\set VERBOSITY terse
+select count(*) as solved
+from (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t
+      MINIMIZE (SELECT x FROM t)
+      SUBJECTTO (SELECT x >= 1 FROM t)
+      USING solverlp()) s;
+\set VERBOSITY default
+reset solvedb.solver_work_mem;
@@ -0,0 +1,26 @@
+-- Cumulative statistics of the solves (sl_stat_solves). They are collected only when SolverAPI is loaded
+-- via shared_preload_libraries, thus the test runs on a temporary instance (see solve_stat.conf).
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+select sl_stat_solves_reset();
+
+-- The solves differing in the constants only share an entry
+SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t MINIMIZE (SELECT x FROM t) SUBJECTTO (SELECT x >= 1 FROM t) USING solverlp;
+SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t MINIMIZE (SELECT x FROM t) SUBJECTTO (SELECT x >= 2 FROM t) USING solverlp;
+SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t MINIMIZE (SELECT x FROM t) SUBJECTTO (SELECT x >= 2 FROM t) USING solverlp.basic;
+
+-- The solves of the PL/pgSQL fallback are not counted
+set solvedb.native_solve = off;
+SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t MINIMIZE (SELECT x FROM t) SUBJECTTO (SELECT x >= 3 FROM t) USING solverlp;
+reset solvedb.native_solve;
+
+select solver_name, method_name, calls, rows_in, variables, constraints,
+       min_total_time <= max_total_time as min_le_max, total_total_time >= total_solve_time as total_ge_solve
+from sl_stat_solves
+where dbid = (select oid from pg_database where datname = current_database())
+order by method_name;
+
+select sl_stat_solves_reset();
+select count(*) from sl_stat_solves;
@@ -0,0 +1,34 @@
+-- Aggregates lp_function over sliding window frames (the moving-aggregate mode of sum), and compares the results with explicit sums
+
+create extension if not exists solverapi;
+create extension if not exists solverlp;
+
+-- 10^6 time steps. Two consecutive steps share a variable, and the factors are integers, thus the sums are exact.
+create table win_steps (t int, c float8);
+insert into win_steps (t, c)
+select t, 1 + t % 5 from generate_series(1, 1000000) as t;
+
+-- A constraint over the last 4 steps of each time step
+select count(*) as mismatches
+from (select sum(f) over w4 as s,
+             lag(f, 3) over w + lag(f, 2) over w + lag(f, 1) over w + f as e
+      from (select t, lp_function_make(t / 2) * c + t % 3 as f from win_steps) as v
+      window w as (order by t), w4 as (order by t rows 3 preceding)) as d
+where s::text is distinct from e::text;
+
+-- A centered frame of 24 steps, growing and shrinking the frame at both ends
+select count(*) as mismatches
+from (select t, sum(f) over (order by t rows between 12 preceding and 11 following) as s
+      from (select t, lp_function_make(t / 2) * c as f from win_steps) as v) as d
+join (select g.t, sum(lp_function_make(w.t / 2) * w.c)
+      from generate_series(1, 1000000, 99991) as g (t)
+      join win_steps as w on w.t between g.t - 12 and g.t + 11
+      group by g.t) as e using (t)
+where s::text is distinct from e.sum::text;
+
+-- NULLs are skipped, and a frame of NULLs only is NULL
+select t, sum(f) over (order by t rows 1 preceding)
+from (values (1, null), (2, null), (3, lp_function_make(1)), (4, null), (5, null)) as v (t, f)
+order by t;
+
+drop table win_steps;
@@ -20,28 +20,251 @@
 #include "access/htup_details.h"
 #include "lib/stringinfo.h"
 #include "access/tupmacs.h"
+#include "utils/memutils.h"
+#include "utils/typcache.h"
+#include "utils/hsearch.h"
+#include "utils/guc.h"
+#include "utils/tuplestore.h"
+#include "executor/tstoreReceiver.h"
+#include "tcop/pquery.h"
+#include "miscadmin.h"
+#include "utils/syscache.h"
+#include "utils/inval.h"
+#include "catalog/namespace.h"
+#include "access/xact.h"
+#include "utils/resowner.h"
+#include <sys/time.h>
+#include <sys/resource.h>
 
-/* Function prototypes */
-static Datum sl_exec_sql(const char *sql, int arg_count, Oid *arg_types, Datum * arg_values);
+/*
+ * OIDs of the labels of a SolverAPI enum type, indexed by the values of the corresponding C enum. A map is built on
+ * first use and rebuilt after any type change, so the conversions compare OIDs instead of looking up label strings.
+ */
+typedef struct SL_Enum_Map
+{
+	const char		*typname;		/* A PG name of the type */
+	const char	   **labels;		/* Labels in the order of the C enum values */
+	int				 numLabels;
+	bool			 valid;
+	Oid				 oids[8];		/* OIDs of the labels, or InvalidOid if a label is not defined */
+} SL_Enum_Map;
+
+static const char *sl_attkind_labels[] = {"undefined", "id", "unknown", "known"};
+static const char *sl_objdir_labels[]  = {"undefined", "maximize", "minimize"};
+static const char *sl_ctrtype_labels[] = {"eq", "ne", "lt", "le", "ge", "gt"};
+
+static SL_Enum_Map sl_enum_maps[SL_EnumType_Count] = {
+	{SL_PGNAME_Sl_Attribute_Kind, 	sl_attkind_labels, 	lengthof(sl_attkind_labels), 	false, {InvalidOid}},
+	{SL_PGNAME_Sl_Obj_Dir, 			sl_objdir_labels, 	lengthof(sl_objdir_labels), 	false, {InvalidOid}},
+	{SL_PGNAME_Sl_Ctr_Type, 		sl_ctrtype_labels, 	lengthof(sl_ctrtype_labels), 	false, {InvalidOid}}
+};
+static bool   sl_enum_callback = false;
+static uint32 sl_enum_generation = 0;		/* Incremented on every invalidation */
+
+static void sl_enum_map_invalidate(Datum arg, int cacheid, uint32 hashvalue)
+{
+	int i;
+
+	for (i = 0; i < SL_EnumType_Count; i++)
+		sl_enum_maps[i].valid = false;
+	sl_enum_generation++;
+}
+
+static SL_Enum_Map * sl_enum_map_get(SL_Enum_Type type)
+{
+	SL_Enum_Map *map = &sl_enum_maps[type];
+	Oid			 oids[lengthof(map->oids)];
+	Oid			 typid;
+	uint32		 generation;
+	int			 i;
+
+	if (map->valid)
+		return map;
+
+	if (!sl_enum_callback)
+	{
+		CacheRegisterSyscacheCallback(TYPEOID, sl_enum_map_invalidate, (Datum) 0);
+		sl_enum_callback = true;
+	}
+
+	/* Catalog lookups may process invalidations; the map is kept only if there were none */
+	generation = sl_enum_generation;
+	typid = TypenameGetTypid(map->typname);
+	if (!OidIsValid(typid))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("SolverAPI: type %s does not exist", map->typname)));
+
+	Assert(map->numLabels <= lengthof(map->oids));
+	for (i = 0; i < map->numLabels; i++)
+	{
+		HeapTuple tup = SearchSysCache2(ENUMTYPOIDNAME, ObjectIdGetDatum(typid), CStringGetDatum(map->labels[i]));
+
+		oids[i] = InvalidOid;
+		if (HeapTupleIsValid(tup))
+		{
+			oids[i] = HeapTupleGetOid(tup);
+			ReleaseSysCache(tup);
+		}
+	}
+
+	memcpy(map->oids, oids, sizeof(Oid) * map->numLabels);
+	map->valid = (generation == sl_enum_generation);
+
+	return map;
+}
+
+extern int sl_enum_get_value(SL_Enum_Type type, Oid oid)
+{
+	SL_Enum_Map *map = sl_enum_map_get(type);
+	int			 i;
+
+	for (i = 0; i < map->numLabels; i++)
+		if (map->oids[i] == oid)
+			return i;
+	return 0;
+}
+
+extern Oid sl_enum_get_oid(SL_Enum_Type type, int value)
+{
+	SL_Enum_Map *map = sl_enum_map_get(type);
+
+	if (value < 0 || value >= map->numLabels || !OidIsValid(map->oids[value]))
+		elog(ERROR, "SolverAPI: %d is not a value of the enum %s", value, map->typname);
+
+	return map->oids[value];
+}
+
+/*
+ * Attribute numbers of the fields of a SolverAPI composite type. A map is resolved once per backend
+ * (and again, if the type is recreated), so that a datum is decoded with a single "heap_deform_tuple"
+ * instead of a tuple descriptor lookup and a name scan per field.
+ */
+typedef struct SL_Composite_Map
+{
+	const char		*typname;		/* A PG name of the type */
+	const char	   **fields;		/* Names of the fields to decode */
+	int				 numFields;
+	Oid				 typid;			/* The type the map is resolved for, or InvalidOid */
+	TupleDesc		 tupdesc;		/* A copy of the tuple descriptor of the type */
+	int				*attnums;		/* 0-based attribute numbers of the fields */
+	Datum			*values;		/* Space for the deformed attributes */
+	bool			*nulls;
+} SL_Composite_Map;
+
+#define SL_COMPOSITE_MAP(TYPNAME, FIELDS)	{TYPNAME, FIELDS, lengthof(FIELDS), InvalidOid, NULL, NULL, NULL, NULL}
+
+static const char *sl_attribute_desc_fields[] = {"att_name", "att_type", "att_kind"};
+enum { SL_AD_att_name = 0, SL_AD_att_type, SL_AD_att_kind };
+static SL_Composite_Map sl_attribute_desc_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Attribute_Desc, sl_attribute_desc_fields);
+
+static const char *sl_parameter_value_fields[] = {"param", "value_i", "value_f", "value_t"};
+enum { SL_PV_param = 0, SL_PV_value_i, SL_PV_value_f, SL_PV_value_t };
+static SL_Composite_Map sl_parameter_value_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Parameter_Value, sl_parameter_value_fields);
+
+static const char *sl_problem_fields[] = {"input_sql", "input_alias", "cols_unknown", "obj_dir", "obj_sql", "ctr_sql", "ctes"};
+enum { SL_P_input_sql = 0, SL_P_input_alias, SL_P_cols_unknown, SL_P_obj_dir, SL_P_obj_sql, SL_P_ctr_sql, SL_P_ctes };
+static SL_Composite_Map sl_problem_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Problem, sl_problem_fields);
+
+static const char *sl_cte_relation_fields[] = {"input_sql", "input_alias"};
+enum { SL_CTE_input_sql = 0, SL_CTE_input_alias };
+static SL_Composite_Map sl_cte_relation_map = SL_COMPOSITE_MAP("sl_cte_relation", sl_cte_relation_fields);
+
+static const char *sl_solver_arg_fields[] = {"api_version", "solver_name", "method_name", "params", "problem", "prb_colcount",
+											 "prb_rowcount", "prb_varcount", "tmp_name", "tmp_id", "tmp_attrs"};
+enum { SL_SA_api_version = 0, SL_SA_solver_name, SL_SA_method_name, SL_SA_params, SL_SA_problem, SL_SA_prb_colcount,
+	   SL_SA_prb_rowcount, SL_SA_prb_varcount, SL_SA_tmp_name, SL_SA_tmp_id, SL_SA_tmp_attrs };
+static SL_Composite_Map sl_solver_arg_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Solver_Arg, sl_solver_arg_fields);
+
+static const char *sl_viewsql_fields[] = {"sql"};
+static SL_Composite_Map sl_viewsql_out_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Viewsql_Out, sl_viewsql_fields);
+static SL_Composite_Map sl_viewsql_dst_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Viewsql_Dst, sl_viewsql_fields);
+
+static const char *sl_unkvar_fields[] = {"nr"};
+static SL_Composite_Map sl_unkvar_map = SL_COMPOSITE_MAP(SL_PGNAME_Sl_Unkvar, sl_unkvar_fields);
+
+/* Resolves the attribute numbers of the map fields for the composite type "typid" */
+static void sl_composite_map_build(SL_Composite_Map * map, Oid typid, int32 typmod)
+{
+	MemoryContext	oldcontext;
+	TupleDesc		tupdesc;
+	int				i, j;
+
+	if (map->tupdesc != NULL)
+	{
+		FreeTupleDesc(map->tupdesc);
+		pfree(map->attnums);
+		pfree(map->values);
+		pfree(map->nulls);
+		map->tupdesc = NULL;
+	}
+	map->typid = InvalidOid;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	tupdesc = lookup_rowtype_tupdesc_copy(typid, typmod);
+	map->attnums = palloc(sizeof(int) * map->numFields);
+	map->values = palloc(sizeof(Datum) * tupdesc->natts);
+	map->nulls = palloc(sizeof(bool) * tupdesc->natts);
+	MemoryContextSwitchTo(oldcontext);
+	map->tupdesc = tupdesc;
+
+	for (i = 0; i < map->numFields; i++)
+	{
+		for (j = 0; j < tupdesc->natts; j++)
+			if (!tupdesc->attrs[j]->attisdropped && strcmp(NameStr(tupdesc->attrs[j]->attname), map->fields[i]) == 0)
+				break;
+		if (j == tupdesc->natts)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("SolverAPI: type %s has no attribute \"%s\"", map->typname, map->fields[i])));
+		map->attnums[i] = j;
+	}
+	map->typid = typid;
+}
+
+/*
+ * Decodes a datum of the composite type described by "map". On return, "values" and "nulls"
+ * (of "numFields" elements) hold the fields in the order of the map.
+ */
+static void sl_composite_deform(SL_Composite_Map * map, Datum datum, Datum * values, bool * nulls)
+{
+	HeapTupleHeader	t = (HeapTupleHeader) PG_DETOAST_DATUM(datum);
+	HeapTupleData	tuple;
+	Oid				typid = HeapTupleHeaderGetTypeId(t);
+	int				i;
+
+	if (typid != map->typid || HeapTupleHeaderGetNatts(t) > map->tupdesc->natts)
+		sl_composite_map_build(map, typid, HeapTupleHeaderGetTypMod(t));
+
+	tuple.t_len = HeapTupleHeaderGetDatumLength(t);
+	ItemPointerSetInvalid(&(tuple.t_self));
+	tuple.t_tableOid = InvalidOid;
+	tuple.t_data = t;
+	heap_deform_tuple(&tuple, map->tupdesc, map->values, map->nulls);
+
+	for (i = 0; i < map->numFields; i++)
+	{
+		values[i] = map->values[map->attnums[i]];
+		nulls[i] = map->nulls[map->attnums[i]];
+	}
+}
 
 extern SL_Attribute_Desc * DatumGetSLAttributeDesc(Datum ad_datum)
 {
 	SL_Attribute_Desc * a = palloc0(sizeof(SL_Attribute_Desc));
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(ad_datum);
-	Datum d;
-	bool isnull;
+	Datum	values[lengthof(sl_attribute_desc_fields)];
+	bool	nulls[lengthof(sl_attribute_desc_fields)];
+
+	sl_composite_deform(&sl_attribute_desc_map, ad_datum, values, nulls);
 
-	d = GetAttributeByName(t, "att_name", &isnull);
-	Assert(d); Assert(!isnull);
-	a->att_name = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_AD_att_name]);
+	a->att_name = NameStr(*DatumGetName(values[SL_AD_att_name]));
 
-	d = GetAttributeByName(t, "att_type", &isnull);
-	Assert(d); Assert(!isnull);
-	a->att_type = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_AD_att_type]);
+	a->att_type = NameStr(*DatumGetName(values[SL_AD_att_type]));
 
-	d = GetAttributeByName(t, "att_kind", &isnull);
-	Assert(d); Assert(!isnull);
-	a->att_kind = DatumGetSLAttributeKind(d);
+	Assert(!nulls[SL_AD_att_kind]);
+	a->att_kind = DatumGetSLAttributeKind(values[SL_AD_att_kind]);
 
 	return a;
 }
@@ -49,30 +272,22 @@ extern SL_Attribute_Desc * DatumGetSLAttributeDesc(Datum ad_datum)
 extern SL_Parameter_Value * DatumGetSLParameterValue(Datum pv_datum)
 {
 	SL_Parameter_Value * pv = palloc0(sizeof(SL_Parameter_Value));
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(pv_datum);
-	Datum d;
-	bool isnull;
+	Datum	values[lengthof(sl_parameter_value_fields)];
+	bool	nulls[lengthof(sl_parameter_value_fields)];
 
-	d = GetAttributeByName(t, "param", &isnull);
-	Assert(d); Assert(!isnull);
-	pv->param = NameStr(*DatumGetName(d));
+	sl_composite_deform(&sl_parameter_value_map, pv_datum, values, nulls);
 
-	d = GetAttributeByName(t, "value_i", &isnull);
-	if (!isnull) {
-		pv->value_i = DatumGetInt32(d);
-	}
+	Assert(!nulls[SL_PV_param]);
+	pv->param = NameStr(*DatumGetName(values[SL_PV_param]));
 
-	d = GetAttributeByName(t, "value_f", &isnull);
-	if (!isnull) {
-		Assert(d);
-		pv->value_f = DatumGetFloat8(d);
-	}
+	if (!nulls[SL_PV_value_i])
+		pv->value_i = DatumGetInt32(values[SL_PV_value_i]);
 
-	d = GetAttributeByName(t, "value_t", &isnull);
-	if (!isnull) {
-		Assert(d);
-		pv->value_t = text_to_cstring(DatumGetTextP(d) );
-	}
+	if (!nulls[SL_PV_value_f])
+		pv->value_f = DatumGetFloat8(values[SL_PV_value_f]);
+
+	if (!nulls[SL_PV_value_t])
+		pv->value_t = text_to_cstring(DatumGetTextP(values[SL_PV_value_t]));
 
 	return pv;
 }
@@ -80,43 +295,36 @@ extern SL_Parameter_Value * DatumGetSLParameterValue(Datum pv_datum)
 extern SL_Problem * DatumGetSLProblem(Datum p_datum)
 {
 	SL_Problem * p = palloc(sizeof(SL_Problem));
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(p_datum);
-	Datum d;
-	bool isnull;
+	Datum	values[lengthof(sl_problem_fields)];
+	bool	nulls[lengthof(sl_problem_fields)];
 	List * list;
 	ListCell *c;
 
-	d = GetAttributeByName(t, "input_sql", &isnull);
-	Assert(d); Assert(!isnull);
-	p->input_sql = text_to_cstring(DatumGetTextP(d));
+	sl_composite_deform(&sl_problem_map, p_datum, values, nulls);
+
+	Assert(!nulls[SL_P_input_sql]);
+	p->input_sql = text_to_cstring(DatumGetTextP(values[SL_P_input_sql]));
 
-	d = GetAttributeByName(t, "input_alias", &isnull);
-	Assert(d); Assert(!isnull);
-	p->input_alias = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_P_input_alias]);
+	p->input_alias = NameStr(*DatumGetName(values[SL_P_input_alias]));
 
-	d = GetAttributeByName(t, "cols_unknown", &isnull);
-	Assert(d); Assert(!isnull);
-	list = get_datum_array_contents(DatumGetArrayTypeP(d));
+	Assert(!nulls[SL_P_cols_unknown]);
+	list = get_datum_array_contents(DatumGetArrayTypeP(values[SL_P_cols_unknown]));
 	p->cols_unknown = NIL;
 	foreach(c,list)
 	{
 		p->cols_unknown = lappend(p->cols_unknown, NameStr(*DatumGetName((Datum)lfirst(c))));
 	}
 
-	d = GetAttributeByName(t, "obj_dir", &isnull);
-	Assert(d); Assert(!isnull);
-	p->obj_dir = DatumGetSLObjDir(d);
+	Assert(!nulls[SL_P_obj_dir]);
+	p->obj_dir = DatumGetSLObjDir(values[SL_P_obj_dir]);
 
-	d = GetAttributeByName(t, "obj_sql", &isnull);
-	p->obj_sql = isnull ? NULL : text_to_cstring(DatumGetTextP(d));
+	p->obj_sql = nulls[SL_P_obj_sql] ? NULL : text_to_cstring(DatumGetTextP(values[SL_P_obj_sql]));
 
 	p->ctr_sql = NIL;
-	d = GetAttributeByName(t, "ctr_sql", &isnull);
-	Assert(d);
-	if (!isnull)
+	if (!nulls[SL_P_ctr_sql])
 	{
-		list = get_datum_array_contents(DatumGetArrayTypeP(d));
-		p->ctr_sql = NIL;
+		list = get_datum_array_contents(DatumGetArrayTypeP(values[SL_P_ctr_sql]));
 		foreach(c,list)
 		{
 			p->ctr_sql = lappend(p->ctr_sql, text_to_cstring(DatumGetTextP((Datum)lfirst(c))));
@@ -129,15 +337,15 @@ extern SL_Problem * DatumGetSLProblem(Datum p_datum)
 extern SL_Solver_Arg * DatumGetSLSolverArg(Datum sa_datum)
 {
 	SL_Solver_Arg * sa = palloc0(sizeof(SL_Solver_Arg));
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(sa_datum);
-	Datum d;
-	bool isnull;
+	Datum	values[lengthof(sl_solver_arg_fields)];
+	bool	nulls[lengthof(sl_solver_arg_fields)];
 	List * list;
 	ListCell *c;
 
-	d = GetAttributeByName(t, "api_version", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->api_version = DatumGetInt32(d);
+	sl_composite_deform(&sl_solver_arg_map, sa_datum, values, nulls);
+
+	Assert(!nulls[SL_SA_api_version]);
+	sa->api_version = DatumGetInt32(values[SL_SA_api_version]);
 
 	if (SL_VERSION_MAJOR(sa->api_version) != SL_VERSION_MAJOR(SL_API_VERSION))
         ereport(ERROR,
@@ -146,51 +354,41 @@ extern SL_Solver_Arg * DatumGetSLSolverArg(Datum sa_datum)
                         		 SL_VERSION_MAJOR(sa->api_version), SL_VERSION_MINOR(sa->api_version),
                         		 SL_VERSION_MAJOR(SL_API_VERSION),  SL_VERSION_MINOR(SL_API_VERSION))));
 
-	d = GetAttributeByName(t, "solver_name", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->solver_name = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_SA_solver_name]);
+	sa->solver_name = NameStr(*DatumGetName(values[SL_SA_solver_name]));
 
-	d = GetAttributeByName(t, "method_name", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->method_name = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_SA_method_name]);
+	sa->method_name = NameStr(*DatumGetName(values[SL_SA_method_name]));
 
-	d = GetAttributeByName(t, "params", &isnull);
-	Assert(d); 	Assert(!isnull);
-	list = get_datum_array_contents(DatumGetArrayTypeP(d));
-	sa->params = NIL; //palloc0(sizeof(SL_Parameter_Value) * list_length(list));
+	Assert(!nulls[SL_SA_params]);
+	list = get_datum_array_contents(DatumGetArrayTypeP(values[SL_SA_params]));
+	sa->params = NIL;
 	foreach(c,list)
 	{
 		sa->params = lappend(sa->params, DatumGetSLParameterValue((Datum) lfirst(c)));
 	}
 
-	d = GetAttributeByName(t, "problem", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->problem = DatumGetSLProblem(d);
+	Assert(!nulls[SL_SA_problem]);
+	sa->problem = DatumGetSLProblem(values[SL_SA_problem]);
 
-	d = GetAttributeByName(t, "prb_colcount", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->prb_colcount = DatumGetInt32(d);
+	Assert(!nulls[SL_SA_prb_colcount]);
+	sa->prb_colcount = DatumGetInt32(values[SL_SA_prb_colcount]);
 
-	d = GetAttributeByName(t, "prb_rowcount", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->prb_rowcount = DatumGetInt64(d);
+	Assert(!nulls[SL_SA_prb_rowcount]);
+	sa->prb_rowcount = DatumGetInt64(values[SL_SA_prb_rowcount]);
 
-	d = GetAttributeByName(t, "prb_varcount", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->prb_varcount = DatumGetInt64(d);
+	Assert(!nulls[SL_SA_prb_varcount]);
+	sa->prb_varcount = DatumGetInt64(values[SL_SA_prb_varcount]);
 
-	d = GetAttributeByName(t, "tmp_name", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->tmp_name = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_SA_tmp_name]);
+	sa->tmp_name = NameStr(*DatumGetName(values[SL_SA_tmp_name]));
 
-	d = GetAttributeByName(t, "tmp_id", &isnull);
-	Assert(d); 	Assert(!isnull);
-	sa->tmp_id = NameStr(*DatumGetName(d));
+	Assert(!nulls[SL_SA_tmp_id]);
+	sa->tmp_id = NameStr(*DatumGetName(values[SL_SA_tmp_id]));
 
 	sa->tmp_attrs = NIL;
-	d = GetAttributeByName(t, "tmp_attrs", &isnull);
-	Assert(d); 	Assert(!isnull);
-	list = get_datum_array_contents(DatumGetArrayTypeP(d));
+	Assert(!nulls[SL_SA_tmp_attrs]);
+	list = get_datum_array_contents(DatumGetArrayTypeP(values[SL_SA_tmp_attrs]));
 	foreach(c,list)
 	{
 		sa->tmp_attrs = lappend(sa->tmp_attrs, DatumGetSLAttributeDesc((Datum) lfirst(c)));
@@ -228,20 +426,188 @@ extern SL_Parameter_Value * sl_param_get(SL_Solver_Arg *arg, const char *parname
 	return NULL;
 }
 
+/* An entry of the parameter table */
+typedef struct SL_Param_Entry
+{
+	char				 name[NAMEDATALEN];		/* A lower case name of the parameter, the hash key */
+	bool				 declared;				/* Is the parameter declared by the solver */
+	SL_Param_Type		 type;					/* A type of the declared parameter */
+	bool				 isset;					/* Is the value set, either by the argument or by default */
+	Datum				 value;					/* The value of the declared parameter */
+	SL_Parameter_Value	*pv;					/* The value of an undeclared parameter */
+} SL_Param_Entry;
+
+struct SL_Param_Table
+{
+	HTAB				*htab;
+};
+
+/* Gets a hash key of a parameter name, as the names are case insensitive */
+static void sl_param_key(const char *parname, char *key)
+{
+	int i;
+
+	for (i = 0; i < NAMEDATALEN - 1 && parname[i] != '\0'; i++)
+		key[i] = pg_tolower((unsigned char) parname[i]);
+	key[i] = '\0';
+}
+
+/* Converts a text value to a datum of the parameter type */
+static Datum sl_param_value_from_cstring(SL_Param_Type type, const char *value)
+{
+	switch (type)
+	{
+		case SL_ParamType_Int:		return DirectFunctionCall1(int4in, CStringGetDatum(value));
+		case SL_ParamType_Float:	return DirectFunctionCall1(float8in, CStringGetDatum(value));
+		default:					return CStringGetDatum(pstrdup(value));
+	}
+}
+
+/*
+ * Builds a parameter table of the solver argument. The table (and the values) are allocated in the current
+ * memory context.
+ */
+extern SL_Param_Table * sl_param_table_create(SL_Solver_Arg *arg, const SL_Param_Decl *decls, int numDecls)
+{
+	SL_Param_Table 		*table = palloc(sizeof(SL_Param_Table));
+	HASHCTL				 ctl;
+	char				 key[NAMEDATALEN];
+	ListCell			*c;
+	int					 i;
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = NAMEDATALEN;
+	ctl.entrysize = sizeof(SL_Param_Entry);
+	ctl.hcxt = CurrentMemoryContext;
+	table->htab = hash_create("SolverAPI parameters", Max(numDecls + list_length(arg->params), 8), &ctl,
+							  HASH_ELEM | HASH_CONTEXT);
+
+	for (i = 0; i < numDecls; i++)
+	{
+		SL_Param_Entry *e;
+
+		sl_param_key(decls[i].name, key);
+		e = (SL_Param_Entry *) hash_search(table->htab, key, HASH_ENTER, NULL);
+		e->declared = true;
+		e->type = decls[i].type;
+		e->isset = decls[i].value_default != NULL;
+		e->value = e->isset ? sl_param_value_from_cstring(e->type, decls[i].value_default) : (Datum) 0;
+		e->pv = NULL;
+	}
+
+	foreach(c, arg->params)
+	{
+		SL_Parameter_Value  *pv = lfirst(c);
+		SL_Param_Entry 		*e;
+		bool				 found;
+
+		sl_param_key(pv->param, key);
+		e = (SL_Param_Entry *) hash_search(table->htab, key, HASH_ENTER, &found);
+		if (!found)
+		{
+			e->declared = false;
+			e->type = SL_ParamType_Text;
+		}
+		e->pv = pv;
+		if (!e->declared)
+			e->isset = true;
+		else if (e->type == SL_ParamType_Int)
+		{
+			e->isset = true;
+			e->value = Int32GetDatum(pv->value_i);
+		}
+		else if (e->type == SL_ParamType_Float)
+		{
+			e->isset = true;
+			e->value = Float8GetDatum(pv->value_f);
+		}
+		else if (pv->value_t != NULL)		/* A NULL text keeps the default */
+		{
+			e->isset = true;
+			e->value = CStringGetDatum(pv->value_t);
+		}
+	}
+
+	return table;
+}
+
+/* Looks up a parameter, which must be set */
+static SL_Param_Entry * sl_param_table_lookup(SL_Param_Table *table, const char *parname)
+{
+	char			key[NAMEDATALEN];
+	SL_Param_Entry *e;
+
+	sl_param_key(parname, key);
+	e = (SL_Param_Entry *) hash_search(table->htab, key, HASH_FIND, NULL);
+	if (e == NULL || !e->isset)
+		elog(ERROR, "SolverAPI: Parameter %s is not set", parname);
+	return e;
+}
+
+extern bool sl_param_table_isset(SL_Param_Table *table, const char *parname)
+{
+	char			key[NAMEDATALEN];
+	SL_Param_Entry *e;
+
+	sl_param_key(parname, key);
+	e = (SL_Param_Entry *) hash_search(table->htab, key, HASH_FIND, NULL);
+	return e != NULL && e->isset;
+}
+
+extern bool sl_param_table_isdeclared(SL_Param_Table *table, const char *parname)
+{
+	char			key[NAMEDATALEN];
+	SL_Param_Entry *e;
+
+	sl_param_key(parname, key);
+	e = (SL_Param_Entry *) hash_search(table->htab, key, HASH_FIND, NULL);
+	return e != NULL && e->declared;
+}
+
+extern int32 sl_param_table_get_int(SL_Param_Table *table, const char *parname)
+{
+	SL_Param_Entry *e = sl_param_table_lookup(table, parname);
+
+	if (!e->declared)
+		return e->pv->value_i;
+	if (e->type != SL_ParamType_Int)
+		elog(ERROR, "SolverAPI: Parameter %s is not declared as int", parname);
+	return DatumGetInt32(e->value);
+}
+
+extern float8 sl_param_table_get_float(SL_Param_Table *table, const char *parname)
+{
+	SL_Param_Entry *e = sl_param_table_lookup(table, parname);
+
+	if (!e->declared)
+		return e->pv->value_f;
+	if (e->type != SL_ParamType_Float)
+		elog(ERROR, "SolverAPI: Parameter %s is not declared as float", parname);
+	return DatumGetFloat8(e->value);
+}
+
+extern char * sl_param_table_get_text(SL_Param_Table *table, const char *parname)
+{
+	SL_Param_Entry *e = sl_param_table_lookup(table, parname);
+
+	if (!e->declared)
+		return e->pv->value_t;
+	if (e->type != SL_ParamType_Text)
+		elog(ERROR, "SolverAPI: Parameter %s is not declared as text", parname);
+	return DatumGetCString(e->value);
+}
+
 
 
 extern Sl_Viewsql_Out DatumGetSLViewSQLOut(Datum arg_datum)
 {
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(arg_datum);
-	Sl_Viewsql_Out vs;
 	Datum d;
 	bool isnull;
 
-	d = GetAttributeByName(t, "sql", &isnull);
-	Assert(d); 	Assert(!isnull);
-	vs = text_to_cstring(DatumGetTextP(d));
+	sl_composite_deform(&sl_viewsql_out_map, arg_datum, &d, &isnull);
+	Assert(!isnull);
 
-	return vs;
+	return text_to_cstring(DatumGetTextP(d));
 }
 
 extern Datum SLViewSQLOutGetDatum(Sl_Viewsql_Out out)
@@ -262,15 +628,13 @@ extern Datum SLViewSQLOutGetDatum(Sl_Viewsql_Out out)
 
 extern Sl_Viewsql_Dst DatumGetSLViewSQLDst(Datum arg_datum)
 {
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(arg_datum);
-	Sl_Viewsql_Dst vs;
 	Datum d;
 	bool isnull;
 
-	d = GetAttributeByName(t, "sql", &isnull);
-	Assert(d); 	Assert(!isnull);
-	vs = text_to_cstring(DatumGetTextP(d));
-	return vs;
+	sl_composite_deform(&sl_viewsql_dst_map, arg_datum, &d, &isnull);
+	Assert(!isnull);
+
+	return text_to_cstring(DatumGetTextP(d));
 }
 
 extern Datum SLViewSQLDstGetDatum(Sl_Viewsql_Dst dst)
@@ -278,250 +642,946 @@ extern Datum SLViewSQLDstGetDatum(Sl_Viewsql_Dst dst)
 	TupleDesc       tupdesc;
 	HeapTuple 		tuple;
 	Datum			datums[1];
+	bool			isnull[1] = {false};
 
 	tupdesc = TypeGetTupleDesc(TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Dst), NIL);
 	Assert(tupdesc);
 	datums[0] = CStringGetTextDatum(dst);
-	tuple = heap_form_tuple(tupdesc, datums, false);
+	tuple = heap_form_tuple(tupdesc, datums, isnull);
 
 	return HeapTupleGetDatum(tuple);
 }
 
-static Datum sl_exec_sql(const char *sql, int arg_count, Oid *arg_types, Datum * arg_values)
+/* Gets a setting of the SolverAPI module, or "defval" if the module does not define it */
+static const char * sl_get_setting(const char * name, const char * defval)
 {
-	int				ret;
-	SPIPlanPtr		plan;
-	uint32			proc;
-	SPITupleTable 	* spi_tuptable;
-	HeapTuple       spi_tuple;
-	bool 			is_null;
-	Datum 			result;
-	bool			pushed;
+	const char * value = GetConfigOption(name, true, false);
 
-    /* Now build query */
-	pushed = SPI_push_conditional();
-    if ((ret = SPI_connect()) < 0)
-            elog(ERROR, "SolverAPI: SPI_connect returned %d", ret);
+	return value == NULL ? defval : value;
+}
 
-    plan = SPI_prepare(sql, arg_count, arg_types);
-    if (plan == NULL)
-            elog(ERROR, "SolverAPI: SPI execution failed for query %s", sql);
+extern bool sl_solver_can_materialize(FunctionCallInfo fcinfo)
+{
+	ReturnSetInfo  *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	bool			enabled;
 
-    /* Execute the plan */
-    ret = SPI_execp(plan, arg_values, NULL, 1);
-    if (ret < 0)
-            elog(ERROR, "SolverAPI: SPI_execp returned %d", ret);
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo) || (rsinfo->allowedModes & SFRM_Materialize) == 0)
+		return false;
+	if (!parse_bool(sl_get_setting("solvedb.solver_return_materialize", "on"), &enabled))
+		enabled = true;
 
-    spi_tuptable = SPI_tuptable;
+	return enabled;
+}
 
-    if ((proc = SPI_processed) != 1 || (spi_tuptable->tupdesc->natts != 1))
-        ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                                        errmsg("SolverAPI: Query returned unexpected number of rows or columns."),
-                                        errdetail("Expected a single row and a single column in SPI result, got %d and %d.",
-                                        		proc,
-                                        		spi_tuptable->tupdesc->natts)));
-    spi_tuple = spi_tuptable->vals[0];
-    Assert(spi_tuple!=NULL);
+extern long sl_solver_fetch_size(void)
+{
+	long fetchsize = strtol(sl_get_setting("solvedb.solver_fetch_size", "50"), NULL, 10);
 
-    result = SPI_getbinval(SPI_copytuple(spi_tuple), spi_tuptable->tupdesc, 1, &is_null);
-    if (is_null)
-    	result = 0;
+	return fetchsize > 0 ? fetchsize : 50;
+}
 
-    SPI_finish();
-    SPI_pop_conditional(pushed);
+/*
+ * Runs the solver output query "sql" and returns its result in the materialize mode. The tuples are written by
+ * the executor directly into the tuplestore handed to the caller, so no intermediate SPI tuple table is built.
+ */
+extern void sl_solver_materialize(FunctionCallInfo fcinfo, const char *sql, int nargs, Oid *argtypes, Datum *values)
+{
+	ReturnSetInfo	*rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	MemoryContext	 per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	MemoryContext	 oldcontext;
+	SPIPlanPtr		 plan;
+	Portal			 portal;
+	Tuplestorestate	*tupstore;
+	TupleDesc		 tupdesc;
+	DestReceiver	*dest;
+	SL_Profile_Mark	 mark;
+
+	sl_profile_start(&mark);
+	if (SPI_connect() < 0)
+		elog(ERROR, "SolverAPI: SPI_connect failed");
+	if ((plan = SPI_prepare(sql, nargs, argtypes)) == NULL)
+		elog(ERROR, "SolverAPI: SPI_prepare(\"%s\") failed. Returned %d", sql, SPI_result);
+	if ((portal = SPI_cursor_open(NULL, plan, values, NULL, true)) == NULL)
+		elog(ERROR, "SolverAPI: SPI_cursor_open(\"%s\") failed. Returned %d", sql, SPI_result);
+
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+	tupdesc = CreateTupleDescCopy(portal->tupDesc);
+	tupstore = tuplestore_begin_heap((rsinfo->allowedModes & SFRM_Materialize_Random) != 0, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+
+	dest = CreateDestReceiver(DestTuplestore);
+	SetTuplestoreDestReceiverParams(dest, tupstore, per_query_ctx, false);
+	PortalRunFetch(portal, FETCH_FORWARD, FETCH_ALL, dest);
+	(*dest->rDestroy) (dest);
+
+	SPI_cursor_close(portal);
+	SPI_finish();
+	sl_profile_end(&mark, per_query_ctx, "output");
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+}
 
-    return result;
+/* Gets the milliseconds between two time values */
+static double sl_timeval_diff_ms(const struct timeval *end, const struct timeval *start)
+{
+	return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_usec - start->tv_usec) / 1000.0;
 }
 
-/* Source level view SQL generators */
-Sl_Viewsql_Out sl_build_out(Datum sa_datum)
+/*
+ * Gets the measures of the running solve. Each module links its own copy of this library, thus the report
+ * is kept in a rendezvous variable shared by all SolverAPI modules of the backend.
+ */
+extern SL_Solve_Report * sl_solve_report(void)
 {
-	Oid            arg_types[1];
-	Datum		   arg_values[1];
+	void **report = find_rendezvous_variable("SolverAPI solve report");
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_values[0] =  sa_datum;
+	if (*report == NULL)
+	{
+		*report = MemoryContextAlloc(TopMemoryContext, sizeof(SL_Solve_Report));
+		sl_solve_report_reset();
+	}
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out($1)", 1, arg_types, arg_values));
+	return (SL_Solve_Report *) *report;
 }
 
-Sl_Viewsql_Out sl_build_out_userdefined(Datum sa_datum, const char * user_sql)
+extern void sl_solve_report_reset(void)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
+	SL_Solve_Report *report = sl_solve_report();
+
+	report->model_time = -1;
+	report->variables = -1;
+	report->constraints = -1;
+	report->nonzeros = -1;
+	report->partitions = -1;
+	report->model_file[0] = '\0';
+	gettimeofday(&report->start, NULL);
+}
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TEXTOID;
-	arg_values[0] = sa_datum;
-	arg_values[1] = CStringGetTextDatum(user_sql);
+extern char * sl_solve_model_path(const char *extension)
+{
+	static int		dump_nr = 0;
+	const char	   *directory = sl_get_setting("solvedb.solve_model_directory", "");
+	long			min_duration = strtol(sl_get_setting("solvedb.log_min_solve_duration", "-1"), NULL, 10);
+	bool			enabled;
+	struct timeval	now;
+
+	if (!parse_bool(sl_get_setting("solvedb.log_solve_model", "off"), &enabled))
+		enabled = false;
+	if (!enabled || directory[0] == '\0' || min_duration < 0)
+		return NULL;
+
+	gettimeofday(&now, NULL);
+	if (sl_timeval_diff_ms(&now, &sl_solve_report()->start) < min_duration)
+		return NULL;
+
+	return psprintf("%s/solve_%d_%ld_%d.%s", directory, MyProcPid, (long) now.tv_sec, ++dump_nr, extension);
+}
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_userdefined($1, $2)", 2, arg_types, arg_values));
+/*
+ * Like the solve report, the work memory accounting is kept in a rendezvous variable shared by all SolverAPI
+ * modules. Each module caches the pointer, as it is used on every allocation in the tracked contexts.
+ */
+static SL_Work_Mem *sl_work_mem_state = NULL;
+
+extern SL_Work_Mem * sl_work_mem(void)
+{
+	if (sl_work_mem_state == NULL)
+	{
+		void **state = find_rendezvous_variable("SolverAPI work memory");
+
+		if (*state == NULL)
+		{
+			SL_Work_Mem *wm = MemoryContextAllocZero(TopMemoryContext, sizeof(SL_Work_Mem));
+
+			wm->limit = -1;
+			*state = wm;
+		}
+		sl_work_mem_state = (SL_Work_Mem *) *state;
+	}
+
+	return sl_work_mem_state;
 }
 
-Sl_Viewsql_Out sl_build_out_vars(Datum sa_datum)
+/* Reads the budget of the solver work memory (see "solvedb.solver_work_mem", in kB) */
+static int64 sl_work_mem_limit(void)
 {
-	Oid            arg_types[1];
-	Datum		   arg_values[1];
+	long limit = strtol(sl_get_setting("solvedb.solver_work_mem", "-1"), NULL, 10);
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_values[0] = sa_datum;
+	return limit < 0 ? -1 : (int64) limit * 1024;
+}
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_vars($1)", 1, arg_types, arg_values));
+extern void sl_work_mem_reset(void)
+{
+	SL_Work_Mem *wm = sl_work_mem();
+
+	wm->peak = wm->used;
+	wm->phase_peak = wm->used;
+	wm->limit = sl_work_mem_limit();
 }
 
-Sl_Viewsql_Out sl_build_out_funcNmap(Datum sa_datum, Sl_Viewsql_Out base, const char ** funcs, const int numFuncs)
+/* The methods of a tracked context, i.e., the methods of the context with the accounting wrapped around */
+typedef struct SL_Work_Mem_Methods
 {
-	Oid            arg_types[3];
-	Datum		   arg_values[3];
-	Datum		   *r_datums;
-	int i;
+	MemoryContextMethods	methods;	/* The wrapping methods (must be first, as the context points to them) */
+	MemoryContextMethods   *base;		/* The methods of the context */
+	int64					used;		/* Bytes allocated in the context, counted as the chunk space */
+	MemoryContext			firstchild;	/* The first child, when the children were tracked last */
+} SL_Work_Mem_Methods;
+
+#define SL_WORK_MEM_METHODS(context)	((SL_Work_Mem_Methods *) (context)->methods)
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Out);
-	arg_types [2] = TEXTARRAYOID;
-	arg_values[0] = sa_datum;
-	arg_values[1] = SLViewSQLOutGetDatum(base);
+/* Fails, if allocating "request" more bytes would exceed the budget */
+static void sl_work_mem_reserve(MemoryContext context, Size request)
+{
+	SL_Work_Mem *wm = sl_work_mem_state;
 
-	r_datums = palloc(sizeof(Datum) * numFuncs);
-	for(i=0; i < numFuncs; i++)
-		r_datums[i] = CStringGetTextDatum(funcs[i]);
+	if (wm->limit >= 0 && wm->used + (int64) request > wm->limit)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("SolverAPI: The solver work memory of " INT64_FORMAT " kB is exhausted", wm->limit / 1024),
+				 context != NULL ?
+				 errdetail("Failed on request of size %zu in memory context \"%s\", with " INT64_FORMAT " kB in use.",
+						   request, context->name, (wm->used + 1023) / 1024) :
+				 errdetail("Failed on request of size %zu, with " INT64_FORMAT " kB in use.",
+						   request, (wm->used + 1023) / 1024),
+				 errhint("Increase \"solvedb.solver_work_mem\", or split the problem into smaller ones.")));
+}
 
-	arg_values[2] =  (Datum) construct_array(r_datums, numFuncs, TEXTOID, -1, false, 'i');
+static void sl_work_mem_count(SL_Work_Mem_Methods * wmm, int64 delta)
+{
+	SL_Work_Mem *wm = sl_work_mem_state;
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_funcNmap($1, $2, $3)", 3, arg_types, arg_values));
+	wmm->used += delta;
+	wm->used += delta;
+	if (wm->used > wm->phase_peak)
+	{
+		wm->phase_peak = wm->used;
+		if (wm->used > wm->peak)
+			wm->peak = wm->used;
+	}
 }
 
-Sl_Viewsql_Out sl_build_out_funcNsubst(Datum sa_datum, const char ** funcs, const int numFuncs)
+static void sl_work_mem_track_children(MemoryContext context);
+
+/*
+ * Tracks the contexts created in the tracked contexts since the last allocation, e.g., the context of a hash
+ * table. PostgreSQL has no hook for creating a context; a new child is the first one of its parent.
+ */
+static void sl_work_mem_track_new(void)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
-	Datum		   *r_datums;
-	int i;
+	ListCell *c;
+
+	foreach(c, sl_work_mem_state->contexts)
+	{
+		MemoryContext context = (MemoryContext) lfirst(c);
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TEXTARRAYOID;
-	arg_values[0] = sa_datum;
+		if (context->firstchild != SL_WORK_MEM_METHODS(context)->firstchild)
+			sl_work_mem_track_children(context);
+	}
+}
 
-	r_datums = palloc(sizeof(Datum) * numFuncs);
-	for(i=0; i < numFuncs; i++)
-		r_datums[i] = CStringGetTextDatum(funcs[i]);
+static void * sl_work_mem_alloc(MemoryContext context, Size size)
+{
+	SL_Work_Mem_Methods *wmm = SL_WORK_MEM_METHODS(context);
+	void				*pointer;
 
-	arg_values[1] = (Datum) construct_array(r_datums, numFuncs, TEXTOID, -1, false, 'i');;
+	sl_work_mem_track_new();
+	sl_work_mem_reserve(context, size);
+	pointer = wmm->base->alloc(context, size);
+	if (pointer != NULL)
+		sl_work_mem_count(wmm, wmm->base->get_chunk_space(context, pointer));
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_funcNsubst($1, $2)", 2, arg_types, arg_values));
+	return pointer;
 }
 
-Sl_Viewsql_Out sl_build_out_func1subst(Datum sa_datum, const char * func)
+static void sl_work_mem_free(MemoryContext context, void *pointer)
+{
+	SL_Work_Mem_Methods *wmm = SL_WORK_MEM_METHODS(context);
+
+	sl_work_mem_count(wmm, -(int64) wmm->base->get_chunk_space(context, pointer));
+	wmm->base->free_p(context, pointer);
+}
+
+static void * sl_work_mem_realloc(MemoryContext context, void *pointer, Size size)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
+	SL_Work_Mem_Methods *wmm = SL_WORK_MEM_METHODS(context);
+	Size				 oldspace = wmm->base->get_chunk_space(context, pointer);
+	void				*newpointer;
+
+	sl_work_mem_track_new();
+	if (size > oldspace)
+		sl_work_mem_reserve(context, size - oldspace);
+	newpointer = wmm->base->realloc(context, pointer, size);
+	if (newpointer != NULL)
+		sl_work_mem_count(wmm, (int64) wmm->base->get_chunk_space(context, newpointer) - (int64) oldspace);
+
+	return newpointer;
+}
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TEXTOID;
-	arg_values[0] = sa_datum;
-	arg_values[1] = CStringGetTextDatum(func);
+static void sl_work_mem_reset_context(MemoryContext context)
+{
+	SL_Work_Mem_Methods *wmm = SL_WORK_MEM_METHODS(context);
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_func1subst($1, $2)", 2, arg_types, arg_values));
+	wmm->base->reset(context);
+	sl_work_mem_count(wmm, -wmm->used);
+	wmm->firstchild = context->firstchild;
 }
 
-Sl_Viewsql_Out sl_build_out_arrayNsubst(Datum sa_datum, const int * par_pos, const int numPars)
+static void sl_work_mem_delete_context(MemoryContext context)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
-	Datum		   *r_datums;
-	int i;
+	SL_Work_Mem_Methods *wmm = SL_WORK_MEM_METHODS(context);
+	ListCell			*c;
+
+	wmm->base->delete_context(context);
+	sl_work_mem_count(wmm, -wmm->used);
+	context->methods = wmm->base;
+	sl_work_mem_state->contexts = list_delete_ptr(sl_work_mem_state->contexts, context);
+	pfree(wmm);
+
+	/* A new context may get the address of this one */
+	foreach(c, sl_work_mem_state->contexts)
+		if (SL_WORK_MEM_METHODS((MemoryContext) lfirst(c))->firstchild == context)
+			SL_WORK_MEM_METHODS((MemoryContext) lfirst(c))->firstchild = NULL;
+}
+
+/*
+ * Returns the bytes an AllocSet block takes besides its chunks. The stats of a context count the blocks, and
+ * the chunks allocated before a context is tracked are counted as the space of its blocks less this overhead,
+ * i.e., as the chunk space (see "GetMemoryChunkSpace"), which the tracked allocations are counted in too.
+ */
+static int64 sl_work_mem_block_overhead(void)
+{
+	static int64			block_overhead = -1;
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = INT4ARRAYOID;
-	arg_values[0] = sa_datum;
+	if (block_overhead < 0)
+	{
+		MemoryContext			context;
+		MemoryContextCounters	totals;
+		void				   *chunk;
+
+		context = AllocSetContextCreate(TopMemoryContext,
+										"SolverAPI block overhead",
+										ALLOCSET_SMALL_MINSIZE,
+										ALLOCSET_SMALL_INITSIZE,
+										ALLOCSET_SMALL_MAXSIZE);
+		chunk = MemoryContextAlloc(context, 1);
+		memset(&totals, 0, sizeof(totals));
+		(*context->methods->stats) (context, 0, false, &totals);
+		block_overhead = (int64) (totals.totalspace - totals.freespace - GetMemoryChunkSpace(chunk)) / Max(totals.nblocks, 1);
+		MemoryContextDelete(context);
+	}
+
+	return block_overhead;
+}
+
+/* Tracks the children of a tracked context */
+static void sl_work_mem_track_children(MemoryContext context)
+{
+	MemoryContext child;
+
+	for (child = context->firstchild; child != NULL; child = child->nextchild)
+		sl_work_mem_track(child);
+	SL_WORK_MEM_METHODS(context)->firstchild = context->firstchild;
+}
+
+/*
+ * Wraps the methods of a context with the accounting. The wrapped contexts are listed in the shared state,
+ * as each module has its own wrapping functions: comparing the methods with those of this module would
+ * wrap a context tracked by another module once more, and count its chunks twice.
+ */
+extern void sl_work_mem_track(MemoryContext context)
+{
+	SL_Work_Mem				*wm = sl_work_mem();
+	SL_Work_Mem_Methods		*wmm;
+	MemoryContextCounters	 totals;
+	MemoryContext			 oldcontext;
+
+	wm->limit = sl_work_mem_limit();
+
+	if (!list_member_ptr(wm->contexts, context))
+	{
+		oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+		wm->contexts = lappend(wm->contexts, context);
+		MemoryContextSwitchTo(oldcontext);
+
+		wmm = MemoryContextAlloc(TopMemoryContext, sizeof(SL_Work_Mem_Methods));
+		wmm->methods = *context->methods;
+		wmm->methods.alloc = sl_work_mem_alloc;
+		wmm->methods.free_p = sl_work_mem_free;
+		wmm->methods.realloc = sl_work_mem_realloc;
+		wmm->methods.reset = sl_work_mem_reset_context;
+		wmm->methods.delete_context = sl_work_mem_delete_context;
+		wmm->base = context->methods;
+		wmm->used = 0;
+		wmm->firstchild = NULL;
+		context->methods = &wmm->methods;
+
+		/* Count the chunks allocated before, in the chunk space */
+		memset(&totals, 0, sizeof(totals));
+		(*wmm->base->stats) (context, 0, false, &totals);
+		sl_work_mem_count(wmm, (int64) (totals.totalspace - totals.freespace) -
+							   (int64) totals.nblocks * sl_work_mem_block_overhead());
+	}
+
+	sl_work_mem_track_children(context);
+}
+
+extern MemoryContext sl_work_mem_context_create(MemoryContext parent, const char *name)
+{
+	MemoryContext context = AllocSetContextCreate(parent,
+												  name,
+												  ALLOCSET_DEFAULT_MINSIZE,
+												  ALLOCSET_DEFAULT_INITSIZE,
+												  ALLOCSET_DEFAULT_MAXSIZE);
+
+	sl_work_mem_track(context);
+
+	return context;
+}
+
+extern void sl_work_mem_check(Size request)
+{
+	sl_work_mem();
+	sl_work_mem_reserve(NULL, request);
+}
+
+/* Like the solve report, the profile is kept in a rendezvous variable shared by all SolverAPI modules */
+extern SL_Profile * sl_solve_profile(void)
+{
+	void **profile = find_rendezvous_variable("SolverAPI solve profile");
+
+	if (*profile == NULL)
+	{
+		SL_Profile *p = MemoryContextAllocZero(TopMemoryContext, sizeof(SL_Profile));
+
+		p->context = AllocSetContextCreate(TopMemoryContext,
+										   "SolverAPI solve profile",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_SMALL_MAXSIZE);
+		*profile = p;
+	}
+
+	return (SL_Profile *) *profile;
+}
+
+extern void sl_profile_reset(void)
+{
+	SL_Profile *p = sl_solve_profile();
+
+	MemoryContextReset(p->context);
+	p->numPhases = 0;
+	p->maxPhases = 0;
+	p->phases = NULL;
+}
+
+/* Reads the wall and CPU clocks */
+static void sl_profile_clock(SL_Profile_Mark *mark)
+{
+	struct rusage ru;
+
+	gettimeofday(&mark->wall, NULL);
+	getrusage(RUSAGE_SELF, &ru);
+	mark->user = ru.ru_utime;
+	mark->sys = ru.ru_stime;
+}
+
+extern void sl_profile_start(SL_Profile_Mark *mark)
+{
+	SL_Work_Mem *wm = sl_work_mem();
+
+	sl_profile_clock(mark);
+
+	/* Start measuring the work memory peak of the phase, remembering the one of the enclosing phase */
+	mark->work_mem_peak = wm->phase_peak;
+	wm->phase_peak = wm->used;
+}
+
+/* Gets the total space allocated in a memory context and its children */
+extern int64 sl_memory_context_size(MemoryContext context)
+{
+	MemoryContextCounters	totals;
+	MemoryContext			child;
+	int64					size;
+
+	memset(&totals, 0, sizeof(totals));
+	(*context->methods->stats) (context, 0, false, &totals);
+	size = totals.totalspace;
+	for (child = context->firstchild; child != NULL; child = child->nextchild)
+		size += sl_memory_context_size(child);
+
+	return size;
+}
+
+extern void sl_profile_end(const SL_Profile_Mark *mark, MemoryContext context, const char *fmt, ...)
+{
+	SL_Profile		   *p = sl_solve_profile();
+	SL_Profile_Phase   *phase;
+	SL_Profile_Mark		now;
+	MemoryContext		oldcontext;
+	StringInfoData		name;
+	SL_Work_Mem		   *wm = sl_work_mem();
+	int64				work_mem_peak = wm->phase_peak;
+
+	/* The peak of the enclosing phase includes the peak of this one */
+	wm->phase_peak = Max(mark->work_mem_peak, work_mem_peak);
 
-	r_datums = palloc(sizeof(Datum) * numPars);
-	for(i=0; i < numPars; i++)
-		r_datums[i] = Int32GetDatum(par_pos[i]);
+	if (p->numPhases >= SL_PROFILE_MAX_PHASES)
+		return;
 
-	arg_values[1] = (Datum) construct_array(r_datums, numPars, INT4OID, sizeof(int32), true, 'i');;
+	sl_profile_clock(&now);
+
+	oldcontext = MemoryContextSwitchTo(p->context);
+	if (p->numPhases >= p->maxPhases)
+	{
+		p->maxPhases = p->maxPhases == 0 ? 16 : p->maxPhases * 2;
+		p->phases = p->phases == NULL ? palloc(sizeof(SL_Profile_Phase) * p->maxPhases)
+									  : repalloc(p->phases, sizeof(SL_Profile_Phase) * p->maxPhases);
+	}
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_arrayNsubst($1, $2)", 2, arg_types, arg_values));
+	initStringInfo(&name);
+	for (;;)
+	{
+		va_list		args;
+		int			needed;
+
+		va_start(args, fmt);
+		needed = appendStringInfoVA(&name, fmt, args);
+		va_end(args);
+		if (needed == 0)
+			break;
+		enlargeStringInfo(&name, needed);
+	}
+	MemoryContextSwitchTo(oldcontext);
+
+	phase = &p->phases[p->numPhases++];
+	phase->name = name.data;
+	phase->wall_time = sl_timeval_diff_ms(&now.wall, &mark->wall);
+	phase->cpu_time = sl_timeval_diff_ms(&now.user, &mark->user) + sl_timeval_diff_ms(&now.sys, &mark->sys);
+	phase->end_mem = context != NULL ? sl_memory_context_size(context) : 0;
+	phase->work_mem_peak = work_mem_peak;
+}
+
+/* Like the solve profile, the captured queries are kept in a rendezvous variable shared by all SolverAPI modules */
+extern SL_Explain * sl_explain(void)
+{
+	void **explain = find_rendezvous_variable("SolverAPI explain");
+
+	if (*explain == NULL)
+	{
+		SL_Explain *e = MemoryContextAllocZero(TopMemoryContext, sizeof(SL_Explain));
+
+		e->context = AllocSetContextCreate(TopMemoryContext,
+										   "SolverAPI explain",
+										   ALLOCSET_SMALL_MINSIZE,
+										   ALLOCSET_SMALL_INITSIZE,
+										   ALLOCSET_SMALL_MAXSIZE);
+		*explain = e;
+	}
+
+	return (SL_Explain *) *explain;
+}
+
+extern void sl_explain_capture_start(bool costs)
+{
+	SL_Explain *e = sl_explain();
+
+	MemoryContextReset(e->context);
+	e->queries = NIL;
+	e->costs = costs;
+	e->active = true;
+}
+
+extern void sl_explain_capture_stop(void)
+{
+	sl_explain()->active = false;
+}
+
+/*
+ * Records a generated query, if a solve is being explained. The query is planned right away, as it
+ * references the input relation of the solve, which is dropped when the solve ends. The planning runs
+ * in a subtransaction: a query that cannot be planned alone (e.g., one referencing the parameters of
+ * the solver, such as "$1[1]") is recorded with the reason, and does not abort the explained solve.
+ * Only the errors of analyzing the query (SQLSTATE class 42) are absorbed; the others, e.g., a query
+ * cancel or running out of memory, are re-thrown as PL/pgSQL does for the unhandled errors.
+ */
+static void sl_explain_capture(const char *sql, bool plan, const char *fmt, ...) pg_attribute_printf(3, 4);
+
+static void sl_explain_capture(const char *sql, bool plan, const char *fmt, ...)
+{
+	SL_Explain		   *e = sl_explain();
+	SL_Explain_Query   *q;
+	MemoryContext		oldcontext;
+	StringInfoData		buf;
+
+	if (!e->active || sql == NULL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(e->context);
+	q = palloc0(sizeof(SL_Explain_Query));
+	initStringInfo(&buf);
+	for (;;)
+	{
+		va_list		args;
+		int			needed;
+
+		va_start(args, fmt);
+		needed = appendStringInfoVA(&buf, fmt, args);
+		va_end(args);
+		if (needed == 0)
+			break;
+		enlargeStringInfo(&buf, needed);
+	}
+	q->name = buf.data;
+	q->sql = pstrdup(sql);
+	MemoryContextSwitchTo(oldcontext);
+
+	if (plan)
+	{
+		ResourceOwner	oldowner = CurrentResourceOwner;
+
+		oldcontext = CurrentMemoryContext;
+		BeginInternalSubTransaction(NULL);
+		MemoryContextSwitchTo(oldcontext);
+
+		PG_TRY();
+		{
+			uint64	i;
+
+			if (SPI_connect() < 0)
+				elog(ERROR, "SolverAPI: SPI_connect failed");
+			if (SPI_execute(psprintf("EXPLAIN (COSTS %s) %s", e->costs ? "ON" : "OFF", sql), false, 0) != SPI_OK_UTILITY)
+				elog(ERROR, "SolverAPI: Cannot explain the query \"%s\"", sql);
+
+			MemoryContextSwitchTo(e->context);
+			initStringInfo(&buf);
+			for (i = 0; i < SPI_processed; i++)
+				appendStringInfo(&buf, "%s%s", i > 0 ? "\n" : "", SPI_getvalue(SPI_tuptable->vals[i], SPI_tuptable->tupdesc, 1));
+			q->plan = buf.data;
+			MemoryContextSwitchTo(oldcontext);
+
+			SPI_finish();
+
+			ReleaseCurrentSubTransaction();
+			MemoryContextSwitchTo(oldcontext);
+			CurrentResourceOwner = oldowner;
+		}
+		PG_CATCH();
+		{
+			ErrorData  *edata;
+
+			MemoryContextSwitchTo(oldcontext);
+			edata = CopyErrorData();
+			FlushErrorState();
+
+			/* Also disconnects the SPI connection of the subtransaction */
+			RollbackAndReleaseCurrentSubTransaction();
+			MemoryContextSwitchTo(oldcontext);
+			CurrentResourceOwner = oldowner;
+
+			if (ERRCODE_TO_CATEGORY(edata->sqlerrcode) != ERRCODE_SYNTAX_ERROR_OR_ACCESS_RULE_VIOLATION)
+				ReThrowError(edata);
+
+			q->plan = MemoryContextStrdup(e->context, psprintf("Plan unavailable: %s", edata->message));
+			FreeErrorData(edata);
+		}
+		PG_END_TRY();
+	}
+
+	oldcontext = MemoryContextSwitchTo(e->context);
+	e->queries = lappend(e->queries, q);
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/* Kinds of unknown-variable column substitutions made by the source level view SQL generators */
+typedef enum { SL_Subst_Vars = 0, SL_Subst_Func, SL_Subst_Array } SL_Subst_Kind;
+
+/*
+ * Appends a column list of substituted unknown-variable columns, followed by the known columns.
+ * The unknown-variable columns are numbered in the order of "tmp_attrs", starting from 1.
+ * It produces the same output as "array_to_string(ARRAY[<unknown list>, <known list>], ',')"
+ * in the SQL generators.
+ */
+static void sl_append_subst_cols(StringInfo buf, SL_Solver_Arg * sa, SL_Subst_Kind kind,
+								 const char ** funcs, int numFuncs, const int * par_pos, int numPars)
+{
+	ListCell 	*c;
+	int64		 att_nr = 0;
+	bool		 first_known = true;
+
+	foreach(c, sa->tmp_attrs)
+	{
+		SL_Attribute_Desc * a = (SL_Attribute_Desc *) lfirst(c);
+
+		if (a->att_kind != SL_AttKind_Unknown)
+			continue;
+
+		if (att_nr++ > 0)
+			appendStringInfoChar(buf, ',');
+
+		switch (kind)
+		{
+			case SL_Subst_Vars:
+				appendStringInfo(buf, "(%s + (" INT64_FORMAT " * %ld)) AS %s",
+								 sa->tmp_id, att_nr - 1, sa->prb_rowcount, a->att_name);
+				break;
+			case SL_Subst_Func:
+				appendStringInfo(buf, "%s(%s) AS %s",
+								 (att_nr <= numFuncs && funcs[att_nr - 1] != NULL) ? funcs[att_nr - 1] : "",
+								 a->att_name, a->att_name);
+				break;
+			case SL_Subst_Array:
+				appendStringInfoString(buf, "($");
+				if (att_nr <= numPars)
+					appendStringInfo(buf, "%d", par_pos[att_nr - 1]);
+				appendStringInfo(buf, "[%s + (" INT64_FORMAT " * %ld)])::%s AS %s",
+								 sa->tmp_id, att_nr - 1, sa->prb_rowcount, a->att_type, a->att_name);
+				break;
+		}
+	}
+
+	foreach(c, sa->tmp_attrs)
+	{
+		SL_Attribute_Desc * a = (SL_Attribute_Desc *) lfirst(c);
+
+		if (a->att_kind != SL_AttKind_Known)
+			continue;
+
+		if (!first_known || att_nr > 0)
+			appendStringInfoChar(buf, ',');
+		appendStringInfoString(buf, a->att_name);
+		first_known = false;
+	}
+}
+
+/* Appends the WITH clause for the destination (model) views, i.e., the input relation and all CTEs (see "sl_get_dst_prequery") */
+static void sl_append_dst_prequery(StringInfo buf, Datum sa_datum, SL_Problem * problem, Sl_Viewsql_Out vsout)
+{
+	Datum		sa_values[lengthof(sl_solver_arg_fields)];
+	bool		sa_nulls[lengthof(sl_solver_arg_fields)];
+	Datum		p_values[lengthof(sl_problem_fields)];
+	bool		p_nulls[lengthof(sl_problem_fields)];
+
+	appendStringInfo(buf, "WITH %s AS (%s)", quote_identifier(problem->input_alias), vsout);
+
+	sl_composite_deform(&sl_solver_arg_map, sa_datum, sa_values, sa_nulls);
+	Assert(!sa_nulls[SL_SA_problem]);
+	sl_composite_deform(&sl_problem_map, sa_values[SL_SA_problem], p_values, p_nulls);
+	if (!p_nulls[SL_P_ctes])
+	{
+		ListCell *c;
+
+		foreach(c, get_datum_array_contents(DatumGetArrayTypeP(p_values[SL_P_ctes])))
+		{
+			Datum			cte_values[lengthof(sl_cte_relation_fields)];
+			bool			cte_nulls[lengthof(sl_cte_relation_fields)];
+
+			if (lfirst(c) == NULL)
+				continue;
+			sl_composite_deform(&sl_cte_relation_map, (Datum) lfirst(c), cte_values, cte_nulls);
+			appendStringInfo(buf, ", %s AS (%s)",
+							 cte_nulls[SL_CTE_input_alias] ? "" : quote_identifier(NameStr(*DatumGetName(cte_values[SL_CTE_input_alias]))),
+							 cte_nulls[SL_CTE_input_sql] ? "" : text_to_cstring(DatumGetTextP(cte_values[SL_CTE_input_sql])));
+		}
+	}
+}
+
+/* Source level view SQL generators. They build the same SQL as their SQL counterparts in solverapi--1.2.sql,
+ * but without SPI round-trips. */
+Sl_Viewsql_Out sl_build_out(Datum sa_datum)
+{
+	SL_Solver_Arg *sa = DatumGetSLSolverArg(sa_datum);
+
+	return psprintf("SELECT * FROM %s", sa->tmp_name);
+}
+
+Sl_Viewsql_Out sl_build_out_userdefined(Datum sa_datum, const char * user_sql)
+{
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+	ListCell		*c;
+
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, "SELECT ");
+	foreach(c, sa->tmp_attrs)
+		appendStringInfo(&buf, "%s%s", c == list_head(sa->tmp_attrs) ? "" : ",",
+						 quote_identifier(((SL_Attribute_Desc *) lfirst(c))->att_name));
+	appendStringInfo(&buf, " FROM (%s) AS s", user_sql);
+
+	return buf.data;
+}
+
+Sl_Viewsql_Out sl_build_out_vars(Datum sa_datum)
+{
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "SELECT %s, ", sa->tmp_id);
+	sl_append_subst_cols(&buf, sa, SL_Subst_Vars, NULL, 0, NULL, 0);
+	appendStringInfo(&buf, " FROM %s", sa->tmp_name);
+
+	return buf.data;
+}
+
+Sl_Viewsql_Out sl_build_out_funcNmap(Datum sa_datum, Sl_Viewsql_Out base, const char ** funcs, const int numFuncs)
+{
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "SELECT %s, ", sa->tmp_id);
+	sl_append_subst_cols(&buf, sa, SL_Subst_Func, funcs, numFuncs, NULL, 0);
+	appendStringInfo(&buf, " FROM (%s) AS s", base);
+
+	return buf.data;
+}
+
+Sl_Viewsql_Out sl_build_out_funcNsubst(Datum sa_datum, const char ** funcs, const int numFuncs)
+{
+	return sl_build_out_funcNmap(sa_datum, sl_build_out_vars(sa_datum), funcs, numFuncs);
+}
+
+Sl_Viewsql_Out sl_build_out_func1subst(Datum sa_datum, const char * func)
+{
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	const char		**funcs;
+	int				 i;
+
+	funcs = palloc(sizeof(char *) * (sa->prb_colcount + 1));
+	for (i = 0; i < sa->prb_colcount; i++)
+		funcs[i] = func;
+
+	return sl_build_out_funcNsubst(sa_datum, funcs, sa->prb_colcount);
+}
+
+Sl_Viewsql_Out sl_build_out_arrayNsubst(Datum sa_datum, const int * par_pos, const int numPars)
+{
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "SELECT %s, ", sa->tmp_id);
+	sl_append_subst_cols(&buf, sa, SL_Subst_Array, NULL, 0, par_pos, numPars);
+	appendStringInfo(&buf, " FROM %s", sa->tmp_name);
+
+	return buf.data;
 }
 
 Sl_Viewsql_Out sl_build_out_array1subst(Datum sa_datum, const int  par_nr)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	int				*par_pos;
+	int				 i;
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = INT4OID;
-	arg_values[0] = sa_datum;
-	arg_values[1] = Int32GetDatum(par_nr);
+	par_pos = palloc(sizeof(int) * (sa->prb_colcount + 1));
+	for (i = 0; i < sa->prb_colcount; i++)
+		par_pos[i] = par_nr;
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_out_array1subst($1, $2)", 2, arg_types, arg_values));
+	return sl_build_out_arrayNsubst(sa_datum, par_pos, sa->prb_colcount);
 }
 
+/* Destination level view SQL generators */
+
+/* Returns NULL, if there are no unknown-variable columns */
 Sl_Viewsql_Dst sl_build_dst_values(Datum sa_datum, Sl_Viewsql_Out out, char * cast_to)
 {
-	Oid            arg_types[3];
-	Datum		   arg_values[3];
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+	ListCell		*c;
+	int64			 att_nr = 0;
+
+	initStringInfo(&buf);
+	foreach(c, sa->tmp_attrs)
+	{
+		SL_Attribute_Desc * a = (SL_Attribute_Desc *) lfirst(c);
+
+		if (a->att_kind != SL_AttKind_Unknown)
+			continue;
+
+		if (att_nr > 0)
+			appendStringInfoString(&buf, " UNION ALL ");
+		appendStringInfo(&buf, "SELECT %s + (" INT64_FORMAT " * %ld)::int AS var_nr, (%s)::%s AS value FROM (%s) AS S",
+						 sa->tmp_id, att_nr, sa->prb_rowcount, a->att_name, quote_identifier(cast_to), out);
+		att_nr++;
+	}
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Out);
-	arg_types [2] = TEXTOID;
-	arg_values[0] = sa_datum;
-	arg_values[1] = SLViewSQLOutGetDatum(out);
-	arg_values[2] = CStringGetTextDatum(cast_to);
+	if (att_nr == 0)
+	{
+		pfree(buf.data);
+		return NULL;
+	}
+	sl_explain_capture(buf.data, true, "Values Query");
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_dst_values($1, $2, $3)", 3, arg_types, arg_values));
+	return buf.data;
 }
 
 Sl_Viewsql_Dst sl_build_dst_obj(Datum sa_datum, Sl_Viewsql_Out out)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Out);
-	arg_values[0] = sa_datum;
-	arg_values[1] = SLViewSQLOutGetDatum(out);
+	initStringInfo(&buf);
+	sl_append_dst_prequery(&buf, sa_datum, sa->problem, out);
+	appendStringInfo(&buf, " SELECT * FROM (%s) AS S", sa->problem->obj_sql == NULL ? "" : sa->problem->obj_sql);
+	sl_explain_capture(buf.data, true, "Objective Query");
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_dst_obj($1, $2)", 2, arg_types, arg_values));
+	return buf.data;
 }
 
 Sl_Viewsql_Dst sl_build_dst_ctr(Datum sa_datum, Sl_Viewsql_Out out, int ctr_nr)
 {
-	Oid            arg_types[3];
-	Datum		   arg_values[3];
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+	const char		*ctr_sql = NULL;
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Out);
-	arg_types [2] = INT4OID;
-	arg_values[0] = sa_datum;
-	arg_values[1] = SLViewSQLOutGetDatum(out);
-	arg_values[2] = Int32GetDatum(ctr_nr);
+	/* Constraints are numbered from 1, as the elements of "ctr_sql" */
+	if (ctr_nr >= 1 && ctr_nr <= list_length(sa->problem->ctr_sql))
+		ctr_sql = (const char *) list_nth(sa->problem->ctr_sql, ctr_nr - 1);
 
-	return DatumGetSLViewSQLOut(sl_exec_sql("SELECT sl_build_dst_ctr($1, $2, $3)", 3, arg_types, arg_values));
+	initStringInfo(&buf);
+	sl_append_dst_prequery(&buf, sa_datum, sa->problem, out);
+	appendStringInfo(&buf, " SELECT * FROM (%s) AS S", ctr_sql == NULL ? "" : ctr_sql);
+	sl_explain_capture(buf.data, true, "Constraint Query %d", ctr_nr);
+
+	return buf.data;
 }
 
 char * sl_return(Datum sa_datum, Sl_Viewsql_Out vsout)
 {
-	Oid            arg_types[2];
-	Datum		   arg_values[2];
+	SL_Solver_Arg 	*sa = DatumGetSLSolverArg(sa_datum);
+	StringInfoData	 buf;
+	ListCell		*c;
+	bool			 first = true;
 
-	arg_types [0] = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
-	arg_types [1] = TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Out);
-	arg_values[0] = sa_datum;
-	arg_values[1] = SLViewSQLOutGetDatum(vsout);
+	initStringInfo(&buf);
+	appendStringInfoString(&buf, "SELECT ");
+	foreach(c, sa->tmp_attrs)
+	{
+		SL_Attribute_Desc * a = (SL_Attribute_Desc *) lfirst(c);
+
+		if (a->att_kind == SL_AttKind_Id)
+			continue;
+		appendStringInfo(&buf, "%s%s::%s", first ? "" : ",", quote_identifier(a->att_name), a->att_type);
+		first = false;
+	}
+	appendStringInfo(&buf, " FROM (%s) AS s", vsout);
+	/* The output query may take parameters, thus it is not planned */
+	sl_explain_capture(buf.data, false, "Output Query");
 
-	return text_to_cstring(DatumGetTextP(sl_exec_sql("SELECT sl_return($1, $2)", 2, arg_types, arg_values)));
+	return buf.data;
 }
 
 /* Constraint processing functions */
 extern Sl_Unkvar DatumGetSLUnkvar(Datum unkvar_datum)
 {
-	HeapTupleHeader t = (HeapTupleHeader) PG_DETOAST_DATUM(unkvar_datum);
 	Datum d;
 	bool isnull;
 
-	d = GetAttributeByName(t, "nr", &isnull);
-	Assert(d); 	Assert(!isnull);
+	sl_composite_deform(&sl_unkvar_map, unkvar_datum, &d, &isnull);
+	Assert(!isnull);
 	return DatumGetInt64(d);
 }
 
@@ -530,11 +1590,12 @@ extern Datum SLUnkvarGetDatum(Sl_Unkvar unkvar)
 	TupleDesc       tupdesc;
 	HeapTuple 		tuple;
 	Datum			datums[1];
+	bool			isnull[1] = {false};
 
 	tupdesc = TypeGetTupleDesc(TypenameGetTypid(SL_PGNAME_Sl_Unkvar), NIL);
 	Assert(tupdesc);
 	datums[0] = Int64GetDatum(unkvar);
-	tuple = heap_form_tuple(tupdesc, datums, false);
+	tuple = heap_form_tuple(tupdesc, datums, isnull);
 
 	return HeapTupleGetDatum(tuple);
 }
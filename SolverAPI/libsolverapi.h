@@ -15,12 +15,24 @@
 #include "utils/portal.h"
 #include "executor/spi.h"
 #include "funcapi.h"
+#include <sys/time.h>
 /* ******************** SolverAPI main types ******************* */
 
 #define SL_API_VERSION 110	/* The release 1.10 */
 #define SL_VERSION_MAJOR(X) (X / 100)
 #define SL_VERSION_MINOR(X) (X % 100)
 
+/* SolverAPI enum types, whose values are converted to C enums through a per-backend map of the enum OIDs */
+typedef enum  { SL_EnumType_AttKind = 0,	/* "sl_attribute_kind" */
+				SL_EnumType_ObjDir,			/* "sl_obj_dir" */
+				SL_EnumType_CtrType,		/* "sl_ctr_type" */
+				SL_EnumType_Count
+			  } SL_Enum_Type;
+/* Gets a C enum value of the enum OID (or 0, if the OID is not a label of the type) */
+extern int sl_enum_get_value(SL_Enum_Type type, Oid oid);
+/* Gets an enum OID of the C enum value */
+extern Oid sl_enum_get_oid(SL_Enum_Type type, int value);
+
 /* A C correspondence of the "sl_attribute_kind" */
 #define SL_PGNAME_Sl_Attribute_Kind "sl_attribute_kind"
 typedef enum  { SL_AttKind_Undefined = 0,  /* An attribute kind is not yet specified */
@@ -37,9 +49,8 @@ typedef enum  { SL_AttKind_Undefined = 0,  /* An attribute kind is not yet speci
 											     (strcmp(V, "unknown")==0)  ? SL_AttKind_Unknown : \
 											     (strcmp(V, "known")==0)    ? SL_AttKind_Known : \
 			  	  	  	  	  	  	  	  	  	  	  	  	  	  	  	  	  SL_AttKind_Undefined)
-#define DatumGetSLAttributeKind(D)				(SL_ATTKIND_FROM_PG_ENUMVALUE(sl_get_enumLabelFromOid(DatumGetObjectId(D))))
-#define SLAttributeKindGetDatum(A)				(ObjectIdGetDatum(sl_get_enumOidFromLabel(SL_PGNAME_Sl_Attribute_Kind, \
-			  	  	  	  	  	  	  	  	  	  	  	  	  	  SL_ATTKIND_TO_PG_ENUMVALUE(A))))
+#define DatumGetSLAttributeKind(D)				((SL_Attribute_Kind) sl_enum_get_value(SL_EnumType_AttKind, DatumGetObjectId(D)))
+#define SLAttributeKindGetDatum(A)				(ObjectIdGetDatum(sl_enum_get_oid(SL_EnumType_AttKind, (int) (A))))
 
 
 /* A C correspondence of the "sl_attribute_desc" */
@@ -66,9 +77,8 @@ typedef enum {
 											     (strcmp(V, "minimize")==0) ? SOL_ObjDir_Minimize : \
 																			  SOL_ObjDir_Undefined)
 
-#define DatumGetSLObjDir(D)						(SL_OBJDIR_FROM_PG_ENUMVALUE(sl_get_enumLabelFromOid(DatumGetObjectId(D))))
-#define SLObjDirGetDatum(O)						(ObjectIdGetDatum(sl_get_enumOidFromLabel(SL_PGNAME_Sl_Obj_Dir, \
-																  SL_OBJDIR_TO_PG_ENUMVALUE(O))))
+#define DatumGetSLObjDir(D)						((SL_Obj_Dir) sl_enum_get_value(SL_EnumType_ObjDir, DatumGetObjectId(D)))
+#define SLObjDirGetDatum(O)						(ObjectIdGetDatum(sl_enum_get_oid(SL_EnumType_ObjDir, (int) (O))))
 
 
 /* A C correspondence of the "sl_problem" */
@@ -124,6 +134,28 @@ extern SL_Parameter_Value * sl_param_get(SL_Solver_Arg *arg, const char *parname
 #define sl_param_get_as_float(ARG, PARNAME) (sl_param_get(ARG, PARNAME)->value_f)
 #define sl_param_get_as_text(ARG, PARNAME) 	(sl_param_get(ARG, PARNAME)->value_t)
 
+/* A type of a parameter declared by a solver */
+typedef enum { SL_ParamType_Int = 0, SL_ParamType_Float, SL_ParamType_Text } SL_Param_Type;
+
+/* A declaration of a solver parameter */
+typedef struct SL_Param_Decl
+{
+	const char				*name;					/* A name of the parameter (case insensitive) */
+	SL_Param_Type			 type;					/* A type of the parameter */
+	const char				*value_default;			/* A default value as text used if the parameter is not set, or NULL */
+} SL_Param_Decl;
+
+/* A hash table of solver/method parameter values. The declared parameters are coerced to their types once,
+ * when the table is created. Other parameters of the solver argument are looked up as they are. */
+typedef struct SL_Param_Table SL_Param_Table;
+
+extern SL_Param_Table *		sl_param_table_create(SL_Solver_Arg *arg, const SL_Param_Decl *decls, int numDecls);
+extern bool 				sl_param_table_isset(SL_Param_Table *table, const char *parname);
+extern bool 				sl_param_table_isdeclared(SL_Param_Table *table, const char *parname);
+extern int32 				sl_param_table_get_int(SL_Param_Table *table, const char *parname);
+extern float8 				sl_param_table_get_float(SL_Param_Table *table, const char *parname);
+extern char *				sl_param_table_get_text(SL_Param_Table *table, const char *parname);
+
 /* Types and methods for a 2 level view system on top of the input relation */
 
 /* A C correspondence of the "sl_viewsql_out" */
@@ -175,6 +207,8 @@ char * sl_return(Datum sa_datum, Sl_Viewsql_Out vsout);
  *	SL_SOLVER_END
  * }
  *
+ * If the caller accepts it, SL_SOLVER_RETURN writes the output straight into the caller's tuplestore
+ * (the materialize mode) and returns. Otherwise, the output is returned tuple by tuple through a cursor.
  * */
 typedef struct SL_SolverCallContext
 {
@@ -183,8 +217,126 @@ typedef struct SL_SolverCallContext
    SPITupleTable   *tupletable;/* A tuple table to read a result from*/
    uint32		   tuplecount;/* Tuple count in a tuple table */
    uint32		   tuplenr;	  /* A number of a tuple to be read next */
+   long			   fetchsize; /* A number of tuples to fetch at once */
 } SL_SolverCallContext;
 
+/* Checks if the solver output can be returned in the materialize mode (see "solvedb.solver_return_materialize") */
+extern bool sl_solver_can_materialize(FunctionCallInfo fcinfo);
+/* Runs the output query and stores its result directly into the tuplestore returned to the caller */
+extern void sl_solver_materialize(FunctionCallInfo fcinfo, const char *sql, int nargs, Oid *argtypes, Datum *values);
+/* Gets a number of tuples to fetch at once in the value-per-call mode (see "solvedb.solver_fetch_size") */
+extern long sl_solver_fetch_size(void);
+
+/* Measures of the model a solver reports to SolverAPI for the solve statistics. Negative, if not reported. */
+typedef struct SL_Solve_Report
+{
+	struct timeval	start;			/* When the solve started (set by SolverAPI) */
+	double			model_time;		/* Time spent building the model, in milliseconds */
+	int64			variables;		/* A number of variables of the model */
+	int64			constraints;	/* A number of constraints of the model */
+	int64			nonzeros;		/* A number of non-zero constraint coefficients */
+	int64			partitions;		/* A number of partitions the model is solved in */
+	char			model_file[MAXPGPATH]; /* A file the model was dumped to, or empty */
+} SL_Solve_Report;
+
+/* Gets the report of the running solve. SolverAPI resets it when a solve starts. */
+extern SL_Solve_Report * sl_solve_report(void);
+extern void sl_solve_report_reset(void);
+/* Gets a path of a file to dump the model of the running solve to, or NULL if a dump is not requested, i.e.,
+ * unless "solvedb.log_solve_model" is on, "solvedb.solve_model_directory" is set and the solve already
+ * takes "solvedb.log_min_solve_duration" */
+extern char * sl_solve_model_path(const char *extension);
+
+/* A phase of the most recent solve of the session (see "sl_last_solve_profile") */
+typedef struct SL_Profile_Phase
+{
+	char		   *name;			/* A name of the phase */
+	double			wall_time;		/* Elapsed time, in milliseconds */
+	double			cpu_time;		/* User and system CPU time, in milliseconds */
+	int64			end_mem;		/* Bytes allocated in the memory context of the phase at its end (the peak is
+									 * "work_mem_peak") */
+	int64			work_mem_peak;	/* The peak of the solver work memory during the phase (see "SL_Work_Mem") */
+} SL_Profile_Phase;
+
+/* The profile of the most recent solve, shared by all SolverAPI modules of the backend */
+typedef struct SL_Profile
+{
+	MemoryContext	context;		/* Holds the phases */
+	int				numPhases;
+	int				maxPhases;
+	SL_Profile_Phase *phases;
+} SL_Profile;
+
+/* At most this many phases are recorded per solve, e.g., with many partitions */
+#define SL_PROFILE_MAX_PHASES	10000
+
+/* A start of a profiled phase */
+typedef struct SL_Profile_Mark
+{
+	struct timeval	wall;
+	struct timeval	user;
+	struct timeval	sys;
+	int64			work_mem_peak;	/* The work memory peak of the enclosing phase, restored at the end */
+} SL_Profile_Mark;
+
+extern SL_Profile * sl_solve_profile(void);
+/* Discards the phases of the previous solve. SolverAPI calls it when a solve starts. */
+extern void sl_profile_reset(void);
+extern void sl_profile_start(SL_Profile_Mark *mark);
+/* Records a phase started at "mark". Its memory is measured in "context" (including the child contexts). */
+extern void sl_profile_end(const SL_Profile_Mark *mark, MemoryContext context, const char *fmt, ...) pg_attribute_printf(3, 4);
+/* Gets the total space allocated in a memory context and its children */
+extern int64 sl_memory_context_size(MemoryContext context);
+
+/*
+ * The solver work memory of the running solve, shared by all SolverAPI modules of the backend. The chunks
+ * allocated in the tracked memory contexts count against "solvedb.solver_work_mem", and an allocation
+ * exceeding it fails with an error. Solvers build their models in such contexts, and so do the libraries
+ * allocating with palloc (GLPK, SwarmOps) while such a context is current.
+ */
+typedef struct SL_Work_Mem
+{
+	int64			used;			/* Bytes allocated in the tracked contexts */
+	int64			peak;			/* The peak of "used" since the solve started */
+	int64			phase_peak;		/* The peak of "used" in the innermost profiled phase */
+	int64			limit;			/* The budget in bytes, or -1 if unlimited */
+	List		   *contexts;		/* The tracked contexts, so that each module recognizes them */
+} SL_Work_Mem;
+
+extern SL_Work_Mem * sl_work_mem(void);
+/* Restarts the peak measurement and reads the budget. SolverAPI calls it when a solve starts. */
+extern void sl_work_mem_reset(void);
+/* Creates an AllocSet context, which is tracked */
+extern MemoryContext sl_work_mem_context_create(MemoryContext parent, const char *name);
+/* Tracks an existing context of the solver and its children. The contexts tracked already, by any module, are
+ * counted once. The contexts created later in a tracked context (e.g., the context of a hash table) are tracked
+ * on the next allocation in a tracked context. */
+extern void sl_work_mem_track(MemoryContext context);
+/* Fails, if allocating "request" more bytes outside the tracked contexts would exceed the budget */
+extern void sl_work_mem_check(Size request);
+
+/* A query generated by the view SQL builders during "EXPLAIN ANALYZE SOLVESELECT" */
+typedef struct SL_Explain_Query
+{
+	char		   *name;			/* E.g., "Objective Query" or "Constraint Query 1" */
+	char		   *sql;			/* The generated SQL */
+	char		   *plan;			/* The text of its plan, or NULL if not planned */
+} SL_Explain_Query;
+
+/* The queries captured while explaining a solve, shared by all SolverAPI modules of the backend */
+typedef struct SL_Explain
+{
+	bool			active;			/* Should the builders capture the queries */
+	MemoryContext	context;		/* Holds the queries */
+	List		   *queries;		/* A list of "SL_Explain_Query" */
+	bool			costs;			/* Show the estimated costs in the plans (EXPLAIN COSTS) */
+} SL_Explain;
+
+extern SL_Explain * sl_explain(void);
+/* Starts (discarding the queries of the previous explain) or stops capturing the generated queries */
+extern void sl_explain_capture_start(bool costs);
+extern void sl_explain_capture_stop(void);
+
 #define SL_SOLVER_BEGIN \
 		FuncCallContext *funcctx; \
 		if (SRF_IS_FIRSTCALL()) { \
@@ -197,14 +349,22 @@ typedef struct SL_SolverCallContext
 #define SL_SOLVER_RETURN(OUT, NUMPARAMS, PARAMTYPES, PARAMVALUES) \
 				do { \
 					char *					outsql = sl_return(PG_GETARG_SLSOLVERARGDATUM(0), (Sl_Viewsql_Out)OUT);\
-					SL_SolverCallContext 	*sctx  = palloc(sizeof(SL_SolverCallContext)); \
+					SL_SolverCallContext 	*sctx; \
+					if (sl_solver_can_materialize(fcinfo)) { \
+						sl_solver_materialize(fcinfo, outsql, (int)NUMPARAMS, (Oid *)PARAMTYPES, (Datum*)PARAMVALUES); \
+						MemoryContextSwitchTo(oldcontext); \
+						end_MultiFuncCall(fcinfo, funcctx); \
+						return (Datum) 0; \
+					} \
+					sctx = palloc(sizeof(SL_SolverCallContext)); \
+					sctx->fetchsize = sl_solver_fetch_size(); \
 			        if (SPI_connect() < 0)\
 				         elog(ERROR, "SolverAPI: SPI_connect failed"); \
 					if ((sctx->plan = SPI_prepare(outsql, (int)NUMPARAMS, (Oid *)PARAMTYPES)) == NULL) \
 						elog(ERROR, "SolverAPI: SPI_prepare(\"%s\") failed. Returned %d", outsql, SPI_result); \
 					if ((sctx->portal = SPI_cursor_open(NULL, sctx->plan, (Datum*)PARAMVALUES, NULL, true)) == NULL) \
 						elog(ERROR, "SolverAPI: SPI_cursor_open(\"%s\") failed. Returned %d", outsql, SPI_result); \
-					SPI_cursor_fetch(sctx->portal, true, 50);\
+					SPI_cursor_fetch(sctx->portal, true, sctx->fetchsize);\
 					if (SPI_tuptable == NULL)\
 						elog(ERROR, "SolverAPI: SPI_cursor_fetch(\"%s\") failed. Returned %d", outsql, SPI_result);\
 					sctx->tupletable = SPI_tuptable;\
@@ -227,7 +387,7 @@ typedef struct SL_SolverCallContext
 			if (sctx->tuplenr >= sctx->tuplecount) {\
 				MemoryContext oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);\
 				SPI_freetuptable(sctx->tupletable);\
-				SPI_cursor_fetch(sctx->portal, true, 50);\
+				SPI_cursor_fetch(sctx->portal, true, sctx->fetchsize);\
 				if (SPI_processed <= 0) {\
 					SPI_cursor_close(sctx->portal);\
 					SPI_finish();\
@@ -284,9 +444,8 @@ typedef enum  { SL_CtrType_EQ = 0,
 											     (strcmp(V, "le")==0)       ? SL_CtrType_LE : \
 			  	  	  	  	  	  	  	  	     (strcmp(V, "ge")==0)       ? SL_CtrType_GE : \
 			  	  	  	  	  	  	  	  	     (strcmp(V, "gt")==0)       ? SL_CtrType_GT : SL_CtrType_EQ)
-#define DatumGetSLCtrType(D)				    (SL_CTRTYPE_FROM_PG_ENUMVALUE(sl_get_enumLabelFromOid(DatumGetObjectId(D))))
-#define Sl_CtrTypeGetDatum(A)					(ObjectIdGetDatum(sl_get_enumOidFromLabel(SL_PGNAME_Sl_Ctr_Type, \
-																  SL_CTRTYPE_TO_PG_ENUMVALUE(A))))
+#define DatumGetSLCtrType(D)				    ((SL_Ctr_Type) sl_enum_get_value(SL_EnumType_CtrType, DatumGetObjectId(D)))
+#define Sl_CtrTypeGetDatum(A)					(ObjectIdGetDatum(sl_enum_get_oid(SL_EnumType_CtrType, (int) (A))))
 #define PG_GETARG_SLCtrType(x)					DatumGetSLCtrType(PG_GETARG_DATUM(x))
 
 /* A C correspondence/implementation of the "sl_ctr" */
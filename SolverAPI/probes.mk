@@ -0,0 +1,33 @@
+# Static trace probes of SolveDB (see solvedb_probes.d), included by the extension Makefiles after PGXS.
+#
+# When PostgreSQL is configured with --enable-dtrace, the probe header is generated with "dtrace -h",
+# and every shared library firing probes links a probe object generated with "dtrace -G". Otherwise,
+# solvedb_probes.h defines the probes as no-ops, and nothing is generated.
+
+SOLVEDB_PROBES_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
+SOLVEDB_PROBES_D    = $(SOLVEDB_PROBES_DIR)solvedb_probes.d
+SOLVEDB_PROBES_H    = $(SOLVEDB_PROBES_DIR)solvedb_probes_dtrace.h
+
+ifeq ($(enable_dtrace), yes)
+
+$(SOLVEDB_PROBES_H): $(SOLVEDB_PROBES_D)
+	$(DTRACE) -C -h -s $< -o $@.tmp
+	sed -e 's/SOLVEDB_/TRACE_SOLVEDB_/g' $@.tmp >$@
+	rm $@.tmp
+
+$(filter %.o,$(OBJS)): $(SOLVEDB_PROBES_H)
+
+EXTRA_CLEAN += $(SOLVEDB_PROBES_H)
+
+# The probe object of the extension module (not needed on macOS, as for PostgreSQL itself)
+ifneq ($(PORTNAME), darwin)
+solvedb_probes.o: $(SOLVEDB_PROBES_D) $(filter %.o,$(OBJS))
+	$(DTRACE) $(DTRACEFLAGS) -C -G -s $^ -o $@
+
+SHLIB_LINK += solvedb_probes.o
+$(shlib): solvedb_probes.o
+
+EXTRA_CLEAN += solvedb_probes.o
+endif
+
+endif
@@ -0,0 +1,51 @@
+/*
+ * solvedb_probes.h
+ *
+ *  Static trace probes of SolveDB (see solvedb_probes.d). When PostgreSQL is configured with
+ *  --enable-dtrace, the probes are defined by the header generated with "dtrace -h" (see probes.mk).
+ *  Otherwise, the probes compile to nothing.
+ */
+
+#ifndef SOLVEDB_PROBES_H_
+#define SOLVEDB_PROBES_H_
+
+#include "pg_config.h"
+
+#ifdef ENABLE_DTRACE
+
+#include "solvedb_probes_dtrace.h"
+
+#else
+
+#define TRACE_SOLVEDB_SOLVE_START(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_SOLVE_START_ENABLED() (0)
+#define TRACE_SOLVEDB_SOLVE_DONE(INT1, INT2, INT3, INT4, INT5, INT6) do {} while (0)
+#define TRACE_SOLVEDB_SOLVE_DONE_ENABLED() (0)
+#define TRACE_SOLVEDB_MODEL_BUILD_START(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_MODEL_BUILD_START_ENABLED() (0)
+#define TRACE_SOLVEDB_MODEL_BUILD_DONE(INT1, INT2, INT3) do {} while (0)
+#define TRACE_SOLVEDB_MODEL_BUILD_DONE_ENABLED() (0)
+#define TRACE_SOLVEDB_PARTITIONING_START(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_PARTITIONING_START_ENABLED() (0)
+#define TRACE_SOLVEDB_PARTITIONING_DONE(INT1) do {} while (0)
+#define TRACE_SOLVEDB_PARTITIONING_DONE_ENABLED() (0)
+#define TRACE_SOLVEDB_PARTITION_SOLVE_START(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_PARTITION_SOLVE_START_ENABLED() (0)
+#define TRACE_SOLVEDB_PARTITION_SOLVE_DONE(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_PARTITION_SOLVE_DONE_ENABLED() (0)
+#define TRACE_SOLVEDB_GLPK_START(INT1, INT2, INT3) do {} while (0)
+#define TRACE_SOLVEDB_GLPK_START_ENABLED() (0)
+#define TRACE_SOLVEDB_GLPK_DONE(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_GLPK_DONE_ENABLED() (0)
+#define TRACE_SOLVEDB_CBC_START(INT1, INT2, INT3) do {} while (0)
+#define TRACE_SOLVEDB_CBC_START_ENABLED() (0)
+#define TRACE_SOLVEDB_CBC_DONE(INT1, INT2) do {} while (0)
+#define TRACE_SOLVEDB_CBC_DONE_ENABLED() (0)
+#define TRACE_SOLVEDB_SWARM_FITNESS_START(INT1) do {} while (0)
+#define TRACE_SOLVEDB_SWARM_FITNESS_START_ENABLED() (0)
+#define TRACE_SOLVEDB_SWARM_FITNESS_DONE(INT1) do {} while (0)
+#define TRACE_SOLVEDB_SWARM_FITNESS_DONE_ENABLED() (0)
+
+#endif /* ENABLE_DTRACE */
+
+#endif /* SOLVEDB_PROBES_H_ */
@@ -162,6 +162,20 @@ CREATE TABLE sl_solver_method_param
     FOREIGN KEY (pid) REFERENCES sl_parameter (pid) ON UPDATE CASCADE ON DELETE CASCADE
 );
 
+-- Invalidates backend-local caches of the SolverAPI catalogs, when the catalogs are modified
+CREATE FUNCTION sl_catalog_invalidate() RETURNS trigger AS 'MODULE_PATHNAME' LANGUAGE C;
+
+CREATE TRIGGER sl_solver_invalidate AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sl_solver
+    FOR EACH STATEMENT EXECUTE PROCEDURE sl_catalog_invalidate();
+CREATE TRIGGER sl_solver_method_invalidate AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sl_solver_method
+    FOR EACH STATEMENT EXECUTE PROCEDURE sl_catalog_invalidate();
+CREATE TRIGGER sl_parameter_invalidate AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sl_parameter
+    FOR EACH STATEMENT EXECUTE PROCEDURE sl_catalog_invalidate();
+CREATE TRIGGER sl_solver_param_invalidate AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sl_solver_param
+    FOR EACH STATEMENT EXECUTE PROCEDURE sl_catalog_invalidate();
+CREATE TRIGGER sl_solver_method_param_invalidate AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON sl_solver_method_param
+    FOR EACH STATEMENT EXECUTE PROCEDURE sl_catalog_invalidate();
+
 -- A sequence for generating unique solver-related column names
 DROP SEQUENCE IF EXISTS sl_colname_seq;
 CREATE SEQUENCE sl_colname_seq CYCLE;
@@ -190,16 +204,102 @@ CREATE OR REPLACE FUNCTION sl_get_attributes_from_sql(text) RETURNS SETOF sl_att
 AS 'MODULE_PATHNAME'
 LANGUAGE C STABLE STRICT;
 
+-- Reports the hit and miss counters of the per-transaction query analysis cache of this backend,
+-- and the number of queries cached in the current transaction. Each solver module links its own copy
+-- of libsolverapi.a, thus has its own cache: the counters are those of the solverapi module only, i.e.,
+-- of the SOLVE function and "sl_get_attributes_from_sql", not of the calls made by the solvers.
+CREATE OR REPLACE FUNCTION sl_get_query_cache_stats(OUT hits bigint, OUT misses bigint, OUT entries int)
+AS 'MODULE_PATHNAME', 'sl_query_cache_stats'
+LANGUAGE C VOLATILE STRICT;
+
 -- A dummy "non-solving" solver written in C to test the SolverAPI routines
 CREATE OR REPLACE FUNCTION sl_dummy_solve(sl_solver_arg) RETURNS SETOF record
 AS 'MODULE_PATHNAME'
 LANGUAGE C STABLE STRICT;
 
+-- A microbenchmark decoding a "sl_unkvar" or "sl_attribute_desc" datum (kind = 'unkvar' | 'attribute') n times.
+-- If by_name is true, the fields are fetched by name (the former decoding). Returns a checksum.
+CREATE OR REPLACE FUNCTION sl_bench_decode(kind text, n int, by_name boolean DEFAULT false) RETURNS bigint
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE STRICT;
+
+-- Converts a value of a SolverAPI enum type (sl_attribute_kind, sl_obj_dir or sl_ctr_type) to its C value and back
+CREATE OR REPLACE FUNCTION sl_enum_roundtrip(anyenum) RETURNS anyenum
+AS 'MODULE_PATHNAME'
+LANGUAGE C STABLE STRICT;
+
+-- Cumulative statistics of the solves, per user, database, solver, method and problem fingerprint.
+-- The phases are: input (materializing the input relation), model (building the model, as reported
+-- by the solver), solve (the rest of the solver call) and total. The times are in milliseconds.
+-- Requires SolverAPI to be loaded via "shared_preload_libraries". Only the natively processed solves are
+-- counted, i.e., not those run with "solvedb.native_solve" off.
+CREATE OR REPLACE FUNCTION sl_stat_solves(
+	OUT userid oid,
+	OUT dbid oid,
+	OUT solver_name name,
+	OUT method_name name,
+	OUT fingerprint bigint,
+	OUT calls bigint,
+	OUT total_input_time float8,
+	OUT min_input_time float8,
+	OUT max_input_time float8,
+	OUT mean_input_time float8,
+	OUT stddev_input_time float8,
+	OUT total_model_time float8,
+	OUT min_model_time float8,
+	OUT max_model_time float8,
+	OUT mean_model_time float8,
+	OUT stddev_model_time float8,
+	OUT total_solve_time float8,
+	OUT min_solve_time float8,
+	OUT max_solve_time float8,
+	OUT mean_solve_time float8,
+	OUT stddev_solve_time float8,
+	OUT total_total_time float8,
+	OUT min_total_time float8,
+	OUT max_total_time float8,
+	OUT mean_total_time float8,
+	OUT stddev_total_time float8,
+	OUT rows_in bigint,
+	OUT variables bigint,
+	OUT constraints bigint,
+	OUT nonzeros bigint,
+	OUT partitions bigint)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE STRICT;
+
+CREATE OR REPLACE VIEW sl_stat_solves AS SELECT * FROM sl_stat_solves();
+COMMENT ON VIEW sl_stat_solves IS 'Cumulative statistics of the natively processed solves (solvedb.native_solve = on).';
+
+-- Discards the cumulative statistics of the solves
+CREATE OR REPLACE FUNCTION sl_stat_solves_reset() RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE;
+
+REVOKE ALL ON FUNCTION sl_stat_solves_reset() FROM PUBLIC;
+
+-- Reports the phases of the most recent solve of the session: the catalog resolution, the input materialization,
+-- and the phases reported by the solver (e.g., the view SQL generation, the objective and each constraint query,
+-- the partitioning, each partition, the result and the output). The times are in milliseconds, "end_mem" is
+-- the space allocated in the memory context of the phase at its end, and "work_mem_peak" is the peak of the
+-- solver work memory during the phase, in bytes (see "solvedb.solver_work_mem").
+CREATE OR REPLACE FUNCTION sl_last_solve_profile(OUT seq int, OUT phase text, OUT wall_time float8,
+												 OUT cpu_time float8, OUT end_mem bigint, OUT work_mem_peak bigint)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE;
+
 -- A function to create a temporal table in security-restricted environment (of PostgreSQL 9.3.1)
 CREATE OR REPLACE FUNCTION sl_createtmptable_unrestricted(text, text) RETURNS int8
 AS 'MODULE_PATHNAME'
 LANGUAGE C STABLE STRICT;
 
+-- Scans an input relation kept in memory by the native SOLVE function (see the GUC "solvedb.input_mode")
+CREATE OR REPLACE FUNCTION sl_input_scan(name) RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE STRICT;
+
 -- Checks if a table exists
 CREATE OR REPLACE FUNCTION sl_is_table_created(tbl_name name) RETURNS boolean AS $$
  SELECT count(*)>0
@@ -325,9 +425,9 @@ CREATE CAST (sl_viewsql_dst AS text) WITH FUNCTION sl_viewsql_to_text(sl_viewsql
 
 -- []
 -- Builds a view sql on the input relation (original temp. table). 
-CREATE OR REPLACE FUNCTION sl_build_out(arg sl_solver_arg) RETURNS sl_viewsql_out AS $$
-	SELECT ROW(format('SELECT * FROM %s', arg.tmp_name))::sl_viewsql_out;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out(arg sl_solver_arg) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out'
+LANGUAGE C IMMUTABLE STRICT;
 
 -- [Default value columns] 
 -- Builds a view sql on the input relation (original temp. table), additionally adding (or overriding) specified columns with their default values. 
@@ -360,12 +460,9 @@ $$ LANGUAGE SQL IMMUTABLE;
 -- [User-defined] 
 -- Builds a view sql on the input relation (original temp. table). 
 -- The user sql must yield a relation with the same columns as the input relation (including id column).
-CREATE OR REPLACE FUNCTION sl_build_out_userdefined(arg sl_solver_arg, user_sql text) RETURNS sl_viewsql_out AS $$
-	SELECT ROW(format('SELECT %s FROM (%s) AS s', 
-		(SELECT string_agg(quote_ident(arg.tmp_attrs[i].att_name), ',')
-	         FROM generate_subscripts(arg.tmp_attrs, 1) AS i), 
-	         user_sql))::sl_viewsql_out;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_userdefined(arg sl_solver_arg, user_sql text) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_userdefined'
+LANGUAGE C IMMUTABLE STRICT;
 
 
 -- [Variable]
@@ -378,27 +475,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --           3,  3,  n+3, 2n+3, a13, a23,
 --        ........................
 --        n,   2n, 3n,   a1n, a2n
-CREATE OR REPLACE FUNCTION sl_build_out_vars(arg sl_solver_arg) RETURNS sl_viewsql_out AS $$
-	SELECT ROW(format('SELECT %s, %s FROM %s',
-		  arg.tmp_id,
-		  array_to_string(
-		  ARRAY[
-		     -- Build substitution for unknown variables
-	             (SELECT string_agg(format('(%s + (%s * %s)) AS %s', 
-			                      arg.tmp_id, 
-					     (att_nr - 1)::text, 
-					      arg.prb_rowcount::text,
-					      att_name), ',')
-	              FROM (SELECT (row_number() OVER ()) AS att_nr, att_name, att_type 
-	                    FROM sl_get_attributes(arg) AS A
-	                    WHERE A.att_kind = 'unknown') AS S),
-	              -- Simply list all rest attributes
-	             (SELECT string_agg(att_name, ',') 
-	              FROM sl_get_attributes(arg) AS A
-	              WHERE A.att_kind = 'known')
-	                ], ','),
-		      arg.tmp_name))::sl_viewsql_out;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_vars(arg sl_solver_arg) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_vars'
+LANGUAGE C IMMUTABLE STRICT;
 
 
 -- [Function Map] Build a view SQL on where values of unknown-variable columns are computed by applying user-suplied 
@@ -414,26 +493,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --           3, f1(a_13), f5(a_23), f9(a_33), a_43, a_53,
 --           ...........................................
 --           n, f1(a_1n), f5(a_2n), f9(a_3n), a_4n, a_5n
-CREATE OR REPLACE FUNCTION sl_build_out_funcNmap(arg sl_solver_arg, base sl_viewsql_out, funcs text[]) RETURNS sl_viewsql_out AS $$
-	SELECT ROW(format('SELECT %s, %s FROM (%s) AS s',
-		  arg.tmp_id,
-		  array_to_string(
-		  ARRAY[
-		     -- Build substitution for unknown variables
-	             (SELECT string_agg(format('%s(%s) AS %2$s', 
-					      funcs[att_nr]::text,
-					      att_name), ','
-				       )
-	              FROM (SELECT (row_number() OVER ()) AS att_nr, att_name, att_type 
-	                    FROM sl_get_attributes(arg) AS A
-	                    WHERE A.att_kind = 'unknown') AS S),
-	              -- Simply list all rest attributes
-	             (SELECT string_agg(att_name, ',') 
-	              FROM sl_get_attributes(arg) AS A
-	              WHERE A.att_kind = 'known')
-	                ], ','),
-		      base.sql))::sl_viewsql_out;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_funcNmap(arg sl_solver_arg, base sl_viewsql_out, funcs text[]) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_funcNmap'
+LANGUAGE C IMMUTABLE STRICT;
 
 -- [Function Substitution] Build a view SQL where values of unknown-variable columns are computed using user-suplied 
 -- functions f1, f2, ..., fN, where N is a number of unknown-variable columns. Each function takes a variable 
@@ -448,9 +510,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --           3, f1(3), f5(n+3), f9(2n+3), a13, a23,
 --           .....................................
 --           n, f1(n), f5(2n),  f9(3n),   a1n, a2n
-CREATE OR REPLACE FUNCTION sl_build_out_funcNsubst(arg sl_solver_arg, funcs text[]) RETURNS sl_viewsql_out AS $$
-	SELECT sl_build_out_funcNmap(arg, sl_build_out_vars(arg),funcs)
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_funcNsubst(arg sl_solver_arg, funcs text[]) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_funcNsubst'
+LANGUAGE C IMMUTABLE STRICT;
 
 -- [Function Substitution] Build a view SQL where values of unknown-variable columns are computed using a user-suplied 
 -- function "func". The function takes a variable number as input and returns a value of an arbitrary type.
@@ -463,9 +525,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --           3, f1(3), f1(n+3), f1(2n+3), a13, a23,
 --           ......................................
 --           n, f1(n), f1(2n),  f1(3n),   a1n, a2n
-CREATE OR REPLACE FUNCTION sl_build_out_func1subst(arg sl_solver_arg, func text) RETURNS sl_viewsql_out AS $$
-	SELECT sl_build_out_funcNsubst(arg, array_fill(func, ARRAY[arg.prb_colcount]));
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_func1subst(arg sl_solver_arg, func text) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_func1subst'
+LANGUAGE C IMMUTABLE STRICT;
 
 
 -- [Array Substitution] Build a parametrized view SQL where values in unknown-variable columns are substituted with values from
@@ -480,30 +542,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --           3, $3[3], $6[n+3], $8[2n+3], a13, a23,
 --           .....................................
 --           n, $3[n], $6[2n],  $8[3n],   a1n, a2n
-CREATE OR REPLACE FUNCTION sl_build_out_arrayNsubst(arg sl_solver_arg, par_pos int[]) RETURNS sl_viewsql_out AS $$
-	SELECT ROW(format('SELECT %s, %s FROM %s',
-		  arg.tmp_id,
-		  array_to_string(
-		  ARRAY[
-		     -- Build substitution for unknown variables
-	             (SELECT string_agg(format('($%s[%s + (%s * %s)])::%s AS %s', 
-					      par_pos[att_nr]::text,
-			                      arg.tmp_id, 
-					     (att_nr - 1)::text, 
-					      arg.prb_rowcount::text,
-					      att_type,
-					      att_name), ','
-				       )
-	              FROM (SELECT (row_number() OVER ()) AS att_nr, att_name, att_type 
-	                    FROM sl_get_attributes(arg) AS A
-	                    WHERE A.att_kind = 'unknown') AS S),
-	              -- Simply list all rest attributes
-	             (SELECT string_agg(att_name, ',') 
-	              FROM sl_get_attributes(arg) AS A
-	              WHERE A.att_kind = 'known')
-	                ], ','),
-		      arg.tmp_name))::sl_viewsql_out;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_arrayNsubst(arg sl_solver_arg, par_pos int[]) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_arrayNsubst'
+LANGUAGE C IMMUTABLE STRICT;
 
 -- [Array Substitution] Build a parametrized view SQL where values in unknown-variable columns are substituted with values from a 
 -- user defined array. The array must be suplied as the "par_nr"-th parameter during the execution.
@@ -516,9 +557,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --           3,  $1[3], $1[n+3], $1[2n+3], a13, a23,
 --           ......................................
 --           n,  $1[n], $1[2n],  $1[3n],   a1n, a2n
-CREATE OR REPLACE FUNCTION sl_build_out_array1subst(arg sl_solver_arg, par_nr int DEFAULT 1) RETURNS sl_viewsql_out AS $$
-	SELECT sl_build_out_arrayNsubst(arg, array_fill(par_nr, ARRAY[arg.prb_colcount]));
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_out_array1subst(arg sl_solver_arg, par_nr int DEFAULT 1) RETURNS sl_viewsql_out
+AS 'MODULE_PATHNAME', 'sl_sql_build_out_array1subst'
+LANGUAGE C IMMUTABLE STRICT;
 
 -- [Rename] Build a view SQL where names of id, unknown-variable, and remaining attribute columns are renamed.
 -- 
@@ -615,6 +656,8 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 
 -- ************************************ Destination LEVEL views *********************************
 
+-- The destination level builders and "sl_return" are VOLATILE: under EXPLAIN ANALYZE, they record (and plan) the
+-- generated queries, thus the calls may be neither folded nor reordered.
 -- [Value] Build an unknown variable table with values
 -- E.g., when cast_to is 'text', then
 -- 	 var_nr(int), value(text)
@@ -623,15 +666,9 @@ $$ LANGUAGE SQL IMMUTABLE STRICT;
 --	 3,	      'val3'
 --	 4,	      '12.3' 
 --       .................
-CREATE OR REPLACE FUNCTION sl_build_dst_values(arg sl_solver_arg, vsout sl_viewsql_out, cast_to text DEFAULT 'text') RETURNS sl_viewsql_dst AS $$
-	SELECT ROW((SELECT string_agg(
-			      format('SELECT %s + (%s * %s)::int AS var_nr, (%s)::%s AS value FROM (%s) AS S',
-				     (arg).tmp_id, (att_nr-1)::text, arg.prb_rowcount,att_name, quote_ident(cast_to), vsout.sql), ' UNION ALL ')
-			     FROM (SELECT (row_number() OVER ()) AS att_nr, att_name
-	                           FROM sl_get_attributes(arg) AS A
-	                           WHERE A.att_kind = 'unknown') AS S)
-		  )::sl_viewsql_dst;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_dst_values(arg sl_solver_arg, vsout sl_viewsql_out, cast_to text DEFAULT 'text') RETURNS sl_viewsql_dst
+AS 'MODULE_PATHNAME', 'sl_sql_build_dst_values'
+LANGUAGE C VOLATILE STRICT;
 
 
 
@@ -643,15 +680,15 @@ $$ LANGUAGE sql;
 
 
 -- [Objective] Build a view SQL to represent objective function aplied on a source view
-CREATE OR REPLACE FUNCTION sl_build_dst_obj(arg sl_solver_arg, vsout sl_viewsql_out) RETURNS sl_viewsql_dst AS $$
-	SELECT ROW(format('%s SELECT * FROM (%s) AS S', sl_get_dst_prequery(arg.problem, vsout), (arg.problem).obj_sql))::sl_viewsql_dst;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_dst_obj(arg sl_solver_arg, vsout sl_viewsql_out) RETURNS sl_viewsql_dst
+AS 'MODULE_PATHNAME', 'sl_sql_build_dst_obj'
+LANGUAGE C VOLATILE STRICT;
 
 -- [Constraint] Build a view SQL to represent objective function aplied on a source view
 -- "ctr_nr" - defines a constraint number
-CREATE OR REPLACE FUNCTION sl_build_dst_ctr(arg sl_solver_arg, vsout sl_viewsql_out, ctr_nr int) RETURNS sl_viewsql_dst AS $$
-	SELECT ROW(format('%s SELECT * FROM (%s) AS S', sl_get_dst_prequery(arg.problem, vsout), (arg.problem).ctr_sql[ctr_nr]))::sl_viewsql_dst;
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_build_dst_ctr(arg sl_solver_arg, vsout sl_viewsql_out, ctr_nr int) RETURNS sl_viewsql_dst
+AS 'MODULE_PATHNAME', 'sl_sql_build_dst_ctr'
+LANGUAGE C VOLATILE STRICT;
 
 -- [Constraint Union] Build a view SQL as a union of the same-type constraints aplied on a source view
 CREATE OR REPLACE FUNCTION sl_build_dst_ctr_union(arg sl_solver_arg, vsout sl_viewsql_out, ctr_type text) RETURNS sl_viewsql_dst AS $$
@@ -672,13 +709,9 @@ $$ LANGUAGE SQL STABLE STRICT;
 
 -- This is the main solver output routine. It uses output-level view SQL and it generates an 
 -- SQL statement to provide a correct output when returning data from a solver
-CREATE OR REPLACE FUNCTION sl_return(arg sl_solver_arg, vsout sl_viewsql_out) RETURNS text AS $$
-	SELECT format('SELECT %s FROM (%s) AS s',
-	    (SELECT string_agg(format('%s::%s',quote_ident((arg.tmp_attrs[i]).att_name),
-							   (arg.tmp_attrs[i]).att_type), ',')
-	     FROM generate_subscripts(arg.tmp_attrs, 1) AS i
-	     WHERE (arg.tmp_attrs[i]).att_kind != 'id'::sl_attribute_kind), vsout.sql);
-$$ LANGUAGE SQL IMMUTABLE STRICT;
+CREATE OR REPLACE FUNCTION sl_return(arg sl_solver_arg, vsout sl_viewsql_out) RETURNS text
+AS 'MODULE_PATHNAME', 'sl_sql_return'
+LANGUAGE C VOLATILE STRICT;
 
 
 -- Create a fixed view using a destination view SQL. It works only if the view SQL does not require any parameters
@@ -991,9 +1024,10 @@ CREATE OR REPLACE FUNCTION sl_rework_CTEs(problem sl_problem) RETURNS sl_problem
 $$ LANGUAGE plpgsql VOLATILE;
 
 
--- A main exterance to the solving routines, the SOLVE function. 
--- It finds a solver method, generates the solver_params and call the solver
-CREATE OR REPLACE FUNCTION sl_solve(query sl_solve_query, par_val_pairs text[][]) RETURNS setof record AS $$
+-- A main exterance to the solving routines, the SOLVE function (PL/pgSQL implementation).
+-- It finds a solver method, generates the solver_params and call the solver.
+-- The native "sl_solve" falls back to this function when "solvedb.native_solve" is off.
+CREATE OR REPLACE FUNCTION sl_solve_plpgsql(query sl_solve_query, par_val_pairs text[][]) RETURNS setof record AS $$
 DECLARE
  s_row       sl_solver%ROWTYPE;
  m_row       sl_solver_method%ROWTYPE;
@@ -1247,6 +1281,13 @@ BEGIN
 	 EXECUTE format('DROP TABLE %s RESTRICT',sarg.tmp_name);
 END;
 $$ LANGUAGE plpgsql VOLATILE;
+COMMENT ON FUNCTION sl_solve_plpgsql(sl_solve_query, text[][]) IS 'The PL/pgSQL implementation of the main entrance method to execute solve queries.';
+
+-- A main exterance to the solving routines, the SOLVE function (native implementation).
+-- It performs the same steps as "sl_solve_plpgsql", but without dynamic SQL and PL/pgSQL overhead.
+CREATE OR REPLACE FUNCTION sl_solve(query sl_solve_query, par_val_pairs text[][]) RETURNS setof record
+AS 'MODULE_PATHNAME'
+LANGUAGE C VOLATILE;
 COMMENT ON FUNCTION sl_solve(sl_solve_query, text[][]) IS 'The main entrance method to execute solve queries.';
 
 
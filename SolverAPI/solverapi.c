@@ -7,12 +7,29 @@
 
 #include "solverapi.h"
 #include "solverapi_utils.h"
+#include "solverapi_catalog.h"
+#include "solverapi_stat.h"
+#include "solverapi_explain.h"
+#include "solverapi_planner.h"
+#include "solvedb_probes.h"
 #include "utils/builtins.h"
 #include "access/htup_details.h"
 // For PostgreSQL 9.3.1 security
 #include "miscadmin.h"
 #include "lib/stringinfo.h"
 #include "utils/guc.h"
+#include "utils/array.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+#include "utils/tuplestore.h"
+#include "utils/memutils.h"
+#include "executor/executor.h"
+#include "executor/tuptable.h"
+#include "executor/tstoreReceiver.h"
+#include "tcop/pquery.h"
+#include "catalog/namespace.h"
+#include "portability/instr_time.h"
+#include <limits.h>
 
 
 #ifdef PG_MODULE_MAGIC
@@ -100,6 +117,32 @@ Datum sl_get_attributes_from_sql(PG_FUNCTION_ARGS) {
 	return 0; /* To make a compiler quiet*/
 }
 
+/*
+ * Reports the counters of the query analysis cache used by "sl_get_attributes_from_sql" and
+ * the SOLVE function of this backend. The solver modules have their own copies of the cache
+ * (see libsolverapi.a), which are not reported.
+ */
+PG_FUNCTION_INFO_V1(sl_query_cache_stats);
+Datum sl_query_cache_stats(PG_FUNCTION_ARGS) {
+	TupleDesc	tupdesc;
+	Datum		values[3];
+	bool		nulls[3] = {false, false, false};
+	uint64		hits, misses;
+	long		entries;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED), errmsg("function returning record called in context "
+				"that cannot accept type record")));
+
+	sl_get_query_cache_stats(&hits, &misses, &entries);
+	values[0] = Int64GetDatum((int64) hits);
+	values[1] = Int64GetDatum((int64) misses);
+	values[2] = Int32GetDatum((int32) entries);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls)));
+}
+
 /*
  * A solver method to test the solver API routines. It does not solve anything, just
  * outputs the unchanged input relation.
@@ -116,13 +159,239 @@ Datum sl_dummy_solve(PG_FUNCTION_ARGS) {
 	SL_SOLVER_END;
 }
 
-/* The function is used to create TMP table in security-restricted environment in PostgreSQL 9.3.1.
- * Hope this will not be needed in later DBMS editions */
-PG_FUNCTION_INFO_V1(sl_createtmptable_unrestricted);
-Datum sl_createtmptable_unrestricted(PG_FUNCTION_ARGS)
+/*
+ * A microbenchmark of the composite datum decoders. It decodes a "sl_unkvar" or a "sl_attribute_desc"
+ * datum (argument 0 is 'unkvar' or 'attribute') N times (argument 1). If argument 2 is true, the fields are
+ * fetched by name with "GetAttributeByName", as the decoders did before. Returns a checksum of the decoded values.
+ */
+PG_FUNCTION_INFO_V1(sl_bench_decode);
+Datum sl_bench_decode(PG_FUNCTION_ARGS) {
+	char		 *kind = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int32		  n = PG_GETARG_INT32(1);
+	bool		  by_name = PG_GETARG_BOOL(2);
+	MemoryContext loopcontext, oldcontext;
+	Datum		  datum;
+	int64		  checksum = 0;
+	int32		  i;
+
+	if (strcmp(kind, "unkvar") == 0)
+		datum = SLUnkvarGetDatum(42);
+	else if (strcmp(kind, "attribute") == 0)
+	{
+		TupleDesc	tupdesc = TypeGetTupleDesc(TypenameGetTypid(SL_PGNAME_Sl_Attribute_Desc), NIL);
+		Datum		values[3];
+		bool		nulls[3] = {false, false, false};
+
+		values[0] = DirectFunctionCall1(namein, CStringGetDatum("x"));
+		values[1] = DirectFunctionCall1(namein, CStringGetDatum("float8"));
+		values[2] = SLAttributeKindGetDatum(SL_AttKind_Unknown);
+		datum = HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc), values, nulls));
+	}
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("SolverAPI: unknown datum kind \"%s\", expected 'unkvar' or 'attribute'", kind)));
+
+	loopcontext = AllocSetContextCreate(CurrentMemoryContext,
+										"sl_bench_decode",
+										ALLOCSET_DEFAULT_MINSIZE,
+										ALLOCSET_DEFAULT_INITSIZE,
+										ALLOCSET_DEFAULT_MAXSIZE);
+	oldcontext = MemoryContextSwitchTo(loopcontext);
+	for (i = 0; i < n; i++)
+	{
+		HeapTupleHeader t = DatumGetHeapTupleHeader(datum);
+		bool			isnull;
+
+		CHECK_FOR_INTERRUPTS();
+		if (kind[0] == 'u')
+			checksum += by_name ? DatumGetInt64(GetAttributeByName(t, "nr", &isnull)) : DatumGetSLUnkvar(datum);
+		else if (by_name)
+		{
+			checksum += strlen(NameStr(*DatumGetName(GetAttributeByName(t, "att_name", &isnull))));
+			checksum += strlen(NameStr(*DatumGetName(GetAttributeByName(t, "att_type", &isnull))));
+			checksum += DatumGetSLAttributeKind(GetAttributeByName(t, "att_kind", &isnull));
+		}
+		else
+		{
+			SL_Attribute_Desc *a = DatumGetSLAttributeDesc(datum);
+
+			checksum += strlen(a->att_name) + strlen(a->att_type) + a->att_kind;
+		}
+		if (i % 1024 == 0)
+			MemoryContextReset(loopcontext);
+	}
+	MemoryContextSwitchTo(oldcontext);
+	MemoryContextDelete(loopcontext);
+
+	PG_RETURN_INT64(checksum);
+}
+
+/*
+ * Converts a value of a SolverAPI enum type to its C enum value and back. It checks the enum OID maps
+ * in the regression tests.
+ */
+PG_FUNCTION_INFO_V1(sl_enum_roundtrip);
+Datum sl_enum_roundtrip(PG_FUNCTION_ARGS) {
+	static const char * typnames[SL_EnumType_Count] = {SL_PGNAME_Sl_Attribute_Kind, SL_PGNAME_Sl_Obj_Dir, SL_PGNAME_Sl_Ctr_Type};
+	Oid		typid = get_fn_expr_argtype(fcinfo->flinfo, 0);
+	int		i;
+
+	for (i = 0; i < SL_EnumType_Count; i++)
+		if (TypenameGetTypid(typnames[i]) == typid)
+			PG_RETURN_OID(sl_enum_get_oid((SL_Enum_Type) i, sl_enum_get_value((SL_Enum_Type) i, PG_GETARG_OID(0))));
+
+	ereport(ERROR,
+			(errcode(ERRCODE_DATATYPE_MISMATCH),
+			 errmsg("SolverAPI: %s is not a SolverAPI enum type", format_type_be(typid))));
+	PG_RETURN_NULL(); /* To make a compiler quiet*/
+}
+
+/* ******************** SQL-callable view SQL generators ******************** */
+/* The generators are implemented in libsolverapi. The wrappers keep the SQL API of the generators. */
+
+/* Gets the elements of a one-dimensional array as C strings */
+static const char ** sl_get_cstring_array(ArrayType * array, int * numElems)
+{
+	Datum	    *elems;
+	bool	    *nulls;
+	const char **result;
+	int			 i;
+
+	deconstruct_array(array, TEXTOID, -1, false, 'i', &elems, &nulls, numElems);
+	result = palloc(sizeof(char *) * (*numElems + 1));
+	for (i = 0; i < *numElems; i++)
+		result[i] = nulls[i] ? NULL : TextDatumGetCString(elems[i]);
+
+	return result;
+}
+
+/* Gets the elements of a one-dimensional array of integers */
+static int * sl_get_int_array(ArrayType * array, int * numElems)
+{
+	Datum	    *elems;
+	bool	    *nulls;
+	int 		*result;
+	int			 i;
+
+	deconstruct_array(array, INT4OID, sizeof(int32), true, 'i', &elems, &nulls, numElems);
+	result = palloc(sizeof(int) * (*numElems + 1));
+	for (i = 0; i < *numElems; i++)
+	{
+		if (nulls[i])
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("SolverAPI: array of parameter positions must not contain nulls")));
+		result[i] = DatumGetInt32(elems[i]);
+	}
+
+	return result;
+}
+
+#define PG_GETARG_SLVIEWSQLOUT(x)	DatumGetSLViewSQLOut(PG_GETARG_DATUM(x))
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out);
+Datum sl_sql_build_out(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out(PG_GETARG_SLSOLVERARGDATUM(0))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_userdefined);
+Datum sl_sql_build_out_userdefined(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_userdefined(PG_GETARG_SLSOLVERARGDATUM(0),
+																  text_to_cstring(PG_GETARG_TEXT_PP(1)))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_vars);
+Datum sl_sql_build_out_vars(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_vars(PG_GETARG_SLSOLVERARGDATUM(0))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_funcNmap);
+Datum sl_sql_build_out_funcNmap(PG_FUNCTION_ARGS)
+{
+	int			 numFuncs;
+	const char **funcs = sl_get_cstring_array(PG_GETARG_ARRAYTYPE_P(2), &numFuncs);
+
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_funcNmap(PG_GETARG_SLSOLVERARGDATUM(0),
+															   PG_GETARG_SLVIEWSQLOUT(1), funcs, numFuncs)));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_funcNsubst);
+Datum sl_sql_build_out_funcNsubst(PG_FUNCTION_ARGS)
+{
+	int			 numFuncs;
+	const char **funcs = sl_get_cstring_array(PG_GETARG_ARRAYTYPE_P(1), &numFuncs);
+
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_funcNsubst(PG_GETARG_SLSOLVERARGDATUM(0), funcs, numFuncs)));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_func1subst);
+Datum sl_sql_build_out_func1subst(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_func1subst(PG_GETARG_SLSOLVERARGDATUM(0),
+																 text_to_cstring(PG_GETARG_TEXT_PP(1)))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_arrayNsubst);
+Datum sl_sql_build_out_arrayNsubst(PG_FUNCTION_ARGS)
+{
+	int			 numPars;
+	int			*par_pos = sl_get_int_array(PG_GETARG_ARRAYTYPE_P(1), &numPars);
+
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_arrayNsubst(PG_GETARG_SLSOLVERARGDATUM(0), par_pos, numPars)));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_out_array1subst);
+Datum sl_sql_build_out_array1subst(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLOutGetDatum(sl_build_out_array1subst(PG_GETARG_SLSOLVERARGDATUM(0), PG_GETARG_INT32(1))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_dst_values);
+Datum sl_sql_build_dst_values(PG_FUNCTION_ARGS)
+{
+	Sl_Viewsql_Dst dst = sl_build_dst_values(PG_GETARG_SLSOLVERARGDATUM(0), PG_GETARG_SLVIEWSQLOUT(1),
+											 text_to_cstring(PG_GETARG_TEXT_PP(2)));
+
+	/* No unknown-variable columns, i.e., a row with the NULL sql */
+	if (dst == NULL)
+	{
+		TupleDesc	tupdesc = TypeGetTupleDesc(TypenameGetTypid(SL_PGNAME_Sl_Viewsql_Dst), NIL);
+		Datum		values[1] = {(Datum) 0};
+		bool		nulls[1] = {true};
+
+		PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+	}
+
+	PG_RETURN_DATUM(SLViewSQLDstGetDatum(dst));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_dst_obj);
+Datum sl_sql_build_dst_obj(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLDstGetDatum(sl_build_dst_obj(PG_GETARG_SLSOLVERARGDATUM(0), PG_GETARG_SLVIEWSQLOUT(1))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_build_dst_ctr);
+Datum sl_sql_build_dst_ctr(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_DATUM(SLViewSQLDstGetDatum(sl_build_dst_ctr(PG_GETARG_SLSOLVERARGDATUM(0), PG_GETARG_SLVIEWSQLOUT(1),
+														  PG_GETARG_INT32(2))));
+}
+
+PG_FUNCTION_INFO_V1(sl_sql_return);
+Datum sl_sql_return(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_TEXT_P(cstring_to_text(sl_return(PG_GETARG_SLSOLVERARGDATUM(0), PG_GETARG_SLVIEWSQLOUT(1))));
+}
+
+/* Creates a TMP relation (of the kind "relkind", i.e., TABLE or VIEW) "tmptable_name" as "sql", also in
+ * security-restricted environment. The caller must be connected to SPI. Returns the number of rows inserted. */
+static int64 sl_create_tmprelation(const char * relkind, const char * tmptable_name, const char * sql)
 {
-	char 		   * tmptable_name = text_to_cstring(PG_GETARG_TEXT_PP(0));
-	char 		   * sql 		   = text_to_cstring(PG_GETARG_TEXT_PP(1));
 	StringInfoData query_buf;
 	int 		   ret;
 	int64		   num_rows;
@@ -141,38 +410,1330 @@ Datum sl_createtmptable_unrestricted(PG_FUNCTION_ARGS)
 		save_nestlevel = NewGUCNestLevel();
 	}
 
-	/* Connect to SPI manager */
-	if ((ret = SPI_connect()) < 0) {
-		elog(ERROR, "SolveDB: SPI_connect returned %d", ret); 		/* internal error */
-	}
-
 	/* Build a create temporal table SQL */
 	initStringInfo(&query_buf);
 
 	/* Build an create temp table sql statement */
-	appendStringInfo(&query_buf, "CREATE TEMP TABLE %s AS (%s)", tmptable_name, sql);
+	appendStringInfo(&query_buf, "CREATE TEMP %s %s AS (%s)", relkind, tmptable_name, sql);
 
 	if ((ret = SPI_exec(query_buf.data, 0)) != SPI_OK_UTILITY)
-			elog(ERROR, "SolveDB: Cannot create a temporal table %s. SPI error code: %d", tmptable_name, ret);
+			elog(ERROR, "SolveDB: Cannot create a temporal %s %s. SPI error code: %d", relkind, tmptable_name, ret);
 
 	num_rows = SPI_processed;
 
 	resetStringInfo(&query_buf);
 	pfree(query_buf.data);
 
-	/* release SPI related resources (and return to caller's context) */
-	SPI_finish();
-
 	if (restr_operation) {
 		/* Roll back any GUC changes */
 		AtEOXact_GUC(false, save_nestlevel);
 		/* Restore userid and security context */
 		SetUserIdAndSecContext(save_userid, save_sec_context);
 	}
+	return num_rows;
+}
+
+/* The function is used to create TMP table in security-restricted environment in PostgreSQL 9.3.1.
+ * Hope this will not be needed in later DBMS editions */
+PG_FUNCTION_INFO_V1(sl_createtmptable_unrestricted);
+Datum sl_createtmptable_unrestricted(PG_FUNCTION_ARGS)
+{
+	char 		   * tmptable_name = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	char 		   * sql 		   = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	int 		   ret;
+	int64		   num_rows;
+
+	/* Connect to SPI manager */
+	if ((ret = SPI_connect()) < 0) {
+		elog(ERROR, "SolveDB: SPI_connect returned %d", ret); 		/* internal error */
+	}
+
+	num_rows = sl_create_tmprelation("TABLE", tmptable_name, sql);
+
+	/* release SPI related resources (and return to caller's context) */
+	SPI_finish();
+
 	/* Return the number of rows processed */
 	PG_RETURN_INT64(num_rows);
 }
 
+/* ******************** The native implementation of the SOLVE function ******************** */
+
+/* GUC: when false, sl_solve falls back to the PL/pgSQL implementation "sl_solve_plpgsql" */
+static bool sl_native_solve = true;
+
+/* GUC: how the native SOLVE function materializes the input relation */
+typedef enum { SL_InputMode_Table = 0, SL_InputMode_Tuplestore } SL_Input_Mode;
+
+static const struct config_enum_entry sl_input_mode_options[] = {
+	{"table", SL_InputMode_Table, false},
+	{"tuplestore", SL_InputMode_Tuplestore, false},
+	{NULL, 0, false}
+};
+
+static int sl_input_mode = SL_InputMode_Table;
+
+/* GUCs: how solvers return their output (see "SL_SOLVER_RETURN") */
+static bool sl_solver_return_materialize = true;
+static int sl_solver_fetch_size_guc = 50;
+
+/* GUC: when true, the native SOLVE function calls a solver directly, if its output needs no further processing */
+static bool sl_solve_direct = true;
+
+/* GUCs: logging of slow solves. The model settings are read by name in the solver modules (see "sl_solve_model_path") */
+static int sl_log_min_solve_duration = -1;
+static bool sl_log_solve_model = false;
+static char *sl_solve_model_directory = NULL;
+/* GUC: the solver work memory, in kB. It is read by name in the solver modules (see "sl_work_mem_reset") */
+static int sl_solver_work_mem = -1;
+
+void _PG_init(void);
+
+/* Module load callback */
+void _PG_init(void)
+{
+	DefineCustomBoolVariable("solvedb.native_solve",
+							 "Use the native (C) implementation of the SOLVESELECT processing pipeline.",
+							 "When off, solve queries are processed by the PL/pgSQL function sl_solve_plpgsql.",
+							 &sl_native_solve,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomEnumVariable("solvedb.input_mode",
+							 "Sets how the native SOLVE function materializes the input relation.",
+							 "\"table\" copies the input into an indexed temporary table, "
+							 "\"tuplestore\" keeps it in backend memory and exposes it through a temporary view.",
+							 &sl_input_mode,
+							 SL_InputMode_Table,
+							 sl_input_mode_options,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("solvedb.solve_direct_call",
+							 "Call a solver directly, when the SOLVE function returns the solver output unchanged.",
+							 "The output of the solver is then handed to the SOLVESELECT consumer without further copying.",
+							 &sl_solve_direct,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	/* The solver output settings are read by name in the solver modules (see "sl_solver_can_materialize") */
+	DefineCustomBoolVariable("solvedb.solver_return_materialize",
+							 "Return the solver output in the materialize mode, when the caller accepts it.",
+							 "When off, the output is returned tuple by tuple through a cursor.",
+							 &sl_solver_return_materialize,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("solvedb.solver_fetch_size",
+							"Sets the number of tuples a solver fetches at once when returning the output tuple by tuple.",
+							NULL,
+							&sl_solver_fetch_size_guc,
+							50,
+							1,
+							INT_MAX,
+							PGC_USERSET,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable("solvedb.log_min_solve_duration",
+							"Sets the minimum execution time above which solves will be logged.",
+							"Zero logs all solves. -1 turns this feature off.",
+							&sl_log_min_solve_duration,
+							-1,
+							-1,
+							INT_MAX,
+							PGC_SUSET,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomBoolVariable("solvedb.log_solve_model",
+							 "Logs the model of the slow solves.",
+							 "The model size is logged, and the solvers dump the model into \"solvedb.solve_model_directory\", if set.",
+							 &sl_log_solve_model,
+							 false,
+							 PGC_SUSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomStringVariable("solvedb.solve_model_directory",
+							   "Sets the directory the models of the slow solves are written to.",
+							   "A relative path is relative to the data directory. When empty, the models are not written.",
+							   &sl_solve_model_directory,
+							   "",
+							   PGC_SUSET,
+							   0,
+							   NULL,
+							   NULL,
+							   NULL);
+
+	DefineCustomIntVariable("solvedb.solver_work_mem",
+							"Sets the maximum memory a solver may use to build and solve the model of a solve.",
+							"It counts the memory contexts of the solver, including the GLPK and SwarmOPS allocations, "
+							"and the solve fails when it is exceeded. -1 means no limit.",
+							&sl_solver_work_mem,
+							-1,
+							-1,
+							MAX_KILOBYTES,
+							PGC_USERSET,
+							GUC_UNIT_KB,
+							NULL,
+							NULL,
+							NULL);
+
+	sl_catalog_init();
+	sl_stat_init();
+	sl_explain_init();
+	sl_planner_init();
+}
+
+/* Gets a number of an attribute, provided its name. Returns InvalidAttrNumber if not found. */
+static AttrNumber sl_get_attnum(TupleDesc tupdesc, const char * attname)
+{
+	int i;
+
+	for (i = 0; i < tupdesc->natts; i++)
+		if (!tupdesc->attrs[i]->attisdropped &&
+			strcmp(NameStr(tupdesc->attrs[i]->attname), attname) == 0)
+			return (AttrNumber) (i + 1);
+
+	elog(ERROR, "SolverAPI: Attribute \"%s\" is not found", attname);
+	return InvalidAttrNumber;
+}
+
+/* Builds an array of names from a list of C strings */
+static Datum sl_build_name_array(List * names)
+{
+	Datum 	 *elems;
+	ListCell *c;
+	int		  i = 0;
+
+	if (names == NIL)
+		return PointerGetDatum(construct_empty_array(NAMEOID));
+
+	elems = palloc(sizeof(Datum) * list_length(names));
+	foreach(c, names)
+		elems[i++] = DirectFunctionCall1(namein, CStringGetDatum((char *) lfirst(c)));
+
+	return PointerGetDatum(construct_array(elems, i, NAMEOID, NAMEDATALEN, false, 'c'));
+}
+
+/* Builds an array of composite values of the type "typoid" */
+static Datum sl_build_composite_array(Datum * elems, int numElems, Oid typoid)
+{
+	int16 	typlen;
+	bool 	typbyval;
+	char 	typalign;
+
+	if (numElems == 0)
+		return PointerGetDatum(construct_empty_array(typoid));
+
+	get_typlenbyvalalign(typoid, &typlen, &typbyval, &typalign);
+	return PointerGetDatum(construct_array(elems, numElems, typoid, typlen, typbyval, typalign));
+}
+
+/* Gets a help string about a solver/method. It is used only when reporting errors. */
+static char * sl_solve_get_help(const char * solver_name, const char * method_name)
+{
+	Oid			argtypes[2] = {NAMEOID, NAMEOID};
+	Datum		values[2];
+	char		nulls[2] = {' ', ' '};
+	char	   *help;
+
+	values[0] = solver_name == NULL ? (Datum) 0 : DirectFunctionCall1(namein, CStringGetDatum(solver_name));
+	values[1] = method_name == NULL ? (Datum) 0 : DirectFunctionCall1(namein, CStringGetDatum(method_name));
+	if (solver_name == NULL) nulls[0] = 'n';
+	if (method_name == NULL) nulls[1] = 'n';
+
+	if (SPI_execute_with_args("SELECT sl_get_solverhelp($1, $2)", 2, argtypes, values, nulls, true, 1) != SPI_OK_SELECT ||
+		SPI_processed != 1)
+		elog(ERROR, "SolverAPI: Cannot build the help string");
+
+	help = SPI_getvalue(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1);
+	return help == NULL ? "" : help;
+}
+
+/* Resolves the solver and the method (or the default method) of the solver */
+static SL_Solve_Method * sl_solve_resolve_method(const char * solver_name, const char * method_name)
+{
+	SL_Solve_Method	*m;
+	bool			 no_method = (method_name == NULL) || (method_name[0] == '\0');
+
+	switch (sl_catalog_get_method(solver_name, no_method ? "" : method_name, &m))
+	{
+		case SL_Catalog_NoSolver:
+			ereport(ERROR,
+					(errcode(ERRCODE_RAISE_EXCEPTION),
+					 errmsg("Solver \"%s\" cannot be found.\r\n%s", solver_name,
+							 sl_solve_get_help(solver_name, method_name))));
+			break;
+		case SL_Catalog_NoMethod:
+			if (no_method)
+				ereport(ERROR,
+						(errcode(ERRCODE_RAISE_EXCEPTION),
+						 errmsg("Method name is not specified and the solver \"%s\" has no default method.\r\n%s",
+								 solver_name, sl_solve_get_help(solver_name, method_name))));
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_RAISE_EXCEPTION),
+						 errmsg("The solver \"%s\" has no method \"%s\".\r\n%s",
+								 solver_name, method_name, sl_solve_get_help(solver_name, method_name))));
+			break;
+		default:
+			break;
+	}
+
+	return m;
+}
+
+/* Checks the value of a numeric parameter against its bounds */
+static void sl_solve_check_param_bounds(SL_Solve_ParamValue * pv, SL_Solve_Param * par,
+										const char * solver_name, const char * method_name)
+{
+	float8	v;
+
+	if (pv->isnull || pv->type == SL_ParType_Text)
+		return;
+
+	v = pv->type == SL_ParType_Int ? (float8) pv->value_i : pv->value_f;
+
+	if (par->value_min != NULL && v < par->min)
+		ereport(ERROR,
+				(errcode(ERRCODE_RAISE_EXCEPTION),
+				 errmsg("The value (%s) of the parameter \"%s\" is lower than the allowed value (%s).\r\n%s",
+						 DatumGetCString(DirectFunctionCall1(float8out, Float8GetDatum(v))),
+						 pv->param, par->value_min,
+						 sl_solve_get_help(solver_name, method_name))));
+
+	if (par->value_max != NULL && v > par->max)
+		ereport(ERROR,
+				(errcode(ERRCODE_RAISE_EXCEPTION),
+				 errmsg("The value (%s) of the parameter \"%s\" is higher than the allowed value (%s).\r\n%s",
+						 DatumGetCString(DirectFunctionCall1(float8out, Float8GetDatum(v))),
+						 pv->param, par->value_max,
+						 sl_solve_get_help(solver_name, method_name))));
+}
+
+/* Builds the list of parameter-value pairs (SL_Solve_ParamValue) by pushing the default values and
+ * validating the user-supplied values against the parameter catalog */
+static List * sl_solve_build_params(SL_Solve_Method * m, ArrayType * par_val_pairs,
+									const char * solver_name, const char * method_name)
+{
+	List			*result = NIL;
+	SL_Solve_Param	*params = m->params;
+	int				 numParams = m->numParams;
+	int				 i;
+
+	/* Push default parameter values (already converted by the catalog cache), if needed */
+	for (i = 0; i < numParams; i++)
+		if (params[i].push_default)
+			result = lappend(result, &params[i].def);
+
+	/* Build the parameter list */
+	if (par_val_pairs != NULL && ARR_NDIM(par_val_pairs) > 0)
+	{
+		Datum	   *elems;
+		bool	   *nulls;
+		int			numElems;
+		int			width;
+		int			row;
+
+		deconstruct_array(par_val_pairs, TEXTOID, -1, false, 'i', &elems, &nulls, &numElems);
+		width = ARR_NDIM(par_val_pairs) > 1 ? ARR_DIMS(par_val_pairs)[1] : numElems;
+
+		for (row = 0; width > 0 && row < numElems / width; row++)
+		{
+			SL_Solve_ParamValue *pv;
+			SL_Solve_Param		*par = NULL;
+			char				*parname;
+			char				*value;
+			ListCell			*c;
+			MemoryContext		 oldcontext;
+
+			if (nulls[row * width])
+				continue;
+			parname = TextDatumGetCString(elems[row * width]);
+			value = (width > 1 && !nulls[row * width + 1]) ? TextDatumGetCString(elems[row * width + 1]) : NULL;
+
+			/* Checks if it's a valid parameter */
+			for (i = 0; i < numParams && par == NULL; i++)
+				if (pg_strcasecmp(params[i].name, parname) == 0)
+					par = &params[i];
+
+			if (par == NULL)
+				ereport(ERROR,
+						(errcode(ERRCODE_RAISE_EXCEPTION),
+						 errmsg("The solver \"%s\" or the solver method \"%s\" does not support a parameter \"%s\".\r\n%s",
+								 solver_name, method_name == NULL ? "<NULL>" : method_name, parname,
+								 sl_solve_get_help(solver_name, method_name))));
+
+			pv = palloc0(sizeof(SL_Solve_ParamValue));
+			pv->param = parname;
+
+			/* Convert the value, while reporting invalid text representations in the SolveDB way */
+			oldcontext = CurrentMemoryContext;
+			PG_TRY();
+			{
+				sl_catalog_set_param_value(pv, par->type, value);
+			}
+			PG_CATCH();
+			{
+				ErrorData  *edata;
+
+				MemoryContextSwitchTo(oldcontext);
+				edata = CopyErrorData();
+				if (edata->sqlerrcode != ERRCODE_INVALID_TEXT_REPRESENTATION)
+					PG_RE_THROW();
+				FlushErrorState();
+				ereport(ERROR,
+						(errcode(ERRCODE_RAISE_EXCEPTION),
+						 errmsg("Invalid parameter \"%s\" value is specified for the solver method \"%s.%s\".",
+								 parname, solver_name, method_name == NULL ? "<NULL>" : method_name)));
+			}
+			PG_END_TRY();
+
+			sl_solve_check_param_bounds(pv, par, solver_name, method_name);
+
+			/* Override the parameter value, if the parameter was previously set */
+			foreach(c, result)
+			{
+				SL_Solve_ParamValue *p = (SL_Solve_ParamValue *) lfirst(c);
+				if (strcmp(p->param, pv->param) == 0)
+				{
+					lfirst(c) = pv;
+					pv = NULL;
+					break;
+				}
+			}
+			if (pv != NULL)
+				result = lappend(result, pv);
+		}
+	}
+
+	return result;
+}
+
+/* Builds an array of "sl_parameter_value" from a list of SL_Solve_ParamValue */
+static Datum sl_solve_build_param_array(List * params)
+{
+	Oid			typoid = TypenameGetTypid(SL_PGNAME_Sl_Parameter_Value);
+	TupleDesc	tupdesc = TypeGetTupleDesc(typoid, NIL);
+	Datum	   *elems = palloc(sizeof(Datum) * (list_length(params) + 1));
+	ListCell   *c;
+	int			i = 0;
+
+	foreach(c, params)
+	{
+		SL_Solve_ParamValue *pv = (SL_Solve_ParamValue *) lfirst(c);
+		Datum				 values[4];
+		bool				 nulls[4] = {false, true, true, true};
+
+		values[0] = DirectFunctionCall1(namein, CStringGetDatum(pv->param));
+		if (!pv->isnull)
+		{
+			switch (pv->type)
+			{
+				case SL_ParType_Int:
+					values[1] = Int32GetDatum(pv->value_i); nulls[1] = false;
+					break;
+				case SL_ParType_Float:
+					values[2] = Float8GetDatum(pv->value_f); nulls[2] = false;
+					break;
+				default:
+					values[3] = CStringGetTextDatum(pv->value_t); nulls[3] = false;
+					break;
+			}
+		}
+		elems[i++] = HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+	}
+
+	return sl_build_composite_array(elems, i, typoid);
+}
+
+/* Builds a datum of the "sl_attribute_desc" */
+static Datum sl_build_attribute_desc(TupleDesc tupdesc, const char * att_name, const char * att_type, SL_Attribute_Kind att_kind)
+{
+	Datum	values[3];
+	bool	nulls[3] = {false, false, false};
+
+	values[0] = DirectFunctionCall1(namein, CStringGetDatum(att_name));
+	values[1] = DirectFunctionCall1(namein, CStringGetDatum(att_type));
+	values[2] = SLAttributeKindGetDatum(att_kind);
+
+	return HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+}
+
+/* Gets a list of names (as C strings) from an array of "name" */
+static List * sl_get_name_list(Datum array)
+{
+	List 	 *result = NIL;
+	List 	 *elems = get_datum_array_contents(DatumGetArrayTypeP(array));
+	ListCell *c;
+
+	foreach(c, elems)
+		if (lfirst(c) != NULL)
+			result = lappend(result, NameStr(*DatumGetName((Datum) lfirst(c))));
+
+	return result;
+}
+
+/* Copies the problem datum, while replacing the list of unknown columns */
+static Datum sl_problem_set_cols_unknown(Datum problem, List * cols_unknown)
+{
+	HeapTupleHeader	 th = DatumGetHeapTupleHeader(problem);
+	TupleDesc		 tupdesc;
+	HeapTupleData	 tuple;
+	Datum			*values;
+	bool			*nulls;
+	AttrNumber		 attnum;
+	Datum			 result;
+
+	tupdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(th), HeapTupleHeaderGetTypMod(th));
+	tuple.t_len = HeapTupleHeaderGetDatumLength(th);
+	ItemPointerSetInvalid(&(tuple.t_self));
+	tuple.t_tableOid = InvalidOid;
+	tuple.t_data = th;
+
+	values = palloc(sizeof(Datum) * tupdesc->natts);
+	nulls = palloc(sizeof(bool) * tupdesc->natts);
+	heap_deform_tuple(&tuple, tupdesc, values, nulls);
+
+	attnum = sl_get_attnum(tupdesc, "cols_unknown");
+	values[attnum - 1] = sl_build_name_array(cols_unknown);
+	nulls[attnum - 1] = false;
+
+	result = HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls));
+	ReleaseTupleDesc(tupdesc);
+
+	return result;
+}
+
+/* Rewrites the problem to eliminate CTEs with decision variables (see "sl_rework_CTEs") */
+static Datum sl_solve_rework_ctes(Datum problem)
+{
+	Oid		argtypes[1];
+	Datum	values[1];
+	bool	isnull;
+	Datum	result;
+
+	argtypes[0] = TypenameGetTypid(SL_PGNAME_Sl_Problem);
+	values[0] = problem;
+
+	if (SPI_execute_with_args("SELECT sl_rework_CTEs($1)", 1, argtypes, values, NULL, false, 1) != SPI_OK_SELECT ||
+		SPI_processed != 1)
+		elog(ERROR, "SolverAPI: Cannot rework CTEs of the problem");
+
+	result = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1, &isnull);
+	if (isnull)
+		elog(ERROR, "SolverAPI: Cannot rework CTEs of the problem");
+
+	return result;
+}
+
+/* Checks if a problem is correctly defined (see "sl_problem_check") */
+static void sl_solve_check_problem(List * cols_unknown, SL_Attribute_Desc * input_atts, unsigned int numInputAtts)
+{
+	ListCell 	*c;
+	unsigned int i;
+
+	if (cols_unknown == NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_RAISE_EXCEPTION),
+				 errmsg("Error retrieving input query columns")));
+
+	/* Let's do a nested loop to check validity of unknown attributes */
+	foreach(c, cols_unknown)
+	{
+		bool fnd = false;
+
+		for (i = 0; i < numInputAtts && !fnd; i++)
+			fnd = (strcmp((char *) lfirst(c), input_atts[i].att_name) == 0);
+
+		if (!fnd)
+		{
+			StringInfoData buf;
+
+			initStringInfo(&buf);
+			for (i = 0; i < numInputAtts; i++)
+				appendStringInfo(&buf, "%s%s", i > 0 ? "," : "", input_atts[i].att_name);
+
+			ereport(ERROR,
+					(errcode(ERRCODE_RAISE_EXCEPTION),
+					 errmsg("The unknown attribute \"%s\" is not found in the target list (%s)",
+							 (char *) lfirst(c), buf.data)));
+		}
+	}
+}
+
+/* Checks if the solver output (described by "outdesc") is compatible with the result type "tupdesc" */
+static void sl_solve_check_output(TupleDesc outdesc, TupleDesc tupdesc)
+{
+	int a;
+
+	if (outdesc->natts != tupdesc->natts)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("SolverAPI: structure of the solver output does not match the result type"),
+				 errdetail("Returned %d columns, but %d were expected.", outdesc->natts, tupdesc->natts)));
+	for (a = 0; a < tupdesc->natts; a++)
+		if (outdesc->attrs[a]->atttypid != tupdesc->attrs[a]->atttypid)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH),
+					 errmsg("SolverAPI: structure of the solver output does not match the result type"),
+					 errdetail("Returned type %s does not match expected type %s in column %d.",
+							 format_type_be(outdesc->attrs[a]->atttypid),
+							 format_type_be(tupdesc->attrs[a]->atttypid), a + 1)));
+}
+
+/*
+ * Executes the query and stores its output into the tuplestore (allocated in "tupcontext"). The output must be
+ * compatible with "tupdesc". The executor writes the tuples straight into the tuplestore.
+ */
+static void sl_solve_materialize(const char * sql, int nargs, Oid * argtypes, Datum * values, const char * nulls,
+								 Tuplestorestate * tupstore, MemoryContext tupcontext, TupleDesc tupdesc)
+{
+	SPIPlanPtr		plan;
+	Portal			portal;
+	DestReceiver   *dest;
+
+	if ((plan = SPI_prepare(sql, nargs, argtypes)) == NULL)
+		elog(ERROR, "SolverAPI: SPI_prepare(\"%s\") failed. Returned %d", sql, SPI_result);
+
+	if ((portal = SPI_cursor_open(NULL, plan, values, nulls, true)) == NULL)
+		elog(ERROR, "SolverAPI: SPI_cursor_open(\"%s\") failed. Returned %d", sql, SPI_result);
+
+	sl_solve_check_output(portal->tupDesc, tupdesc);
+
+	dest = CreateDestReceiver(DestTuplestore);
+	SetTuplestoreDestReceiverParams(dest, tupstore, tupcontext, false);
+	PortalRunFetch(portal, FETCH_FORWARD, FETCH_ALL, dest);
+	(*dest->rDestroy) (dest);
+
+	SPI_cursor_close(portal);
+	SPI_freeplan(plan);
+}
+
+/*
+ * Calls the solver function directly, i.e., without a wrapping query, when the solver output is returned as is.
+ * If the solver returns a tuplestore (the materialize mode), the tuplestore is handed over to the caller of
+ * the SOLVE function, replacing "*tupstore". Otherwise, the tuples are appended to "*tupstore" one by one.
+ * The FmgrInfo lives in the per-query context, since a value-per-call solver keeps its state in fn_extra and
+ * registers a shutdown callback on the expression context that may run after this function has returned.
+ */
+static void sl_solve_call_direct(Oid func_oid, Datum sarg, ReturnSetInfo * caller_rsinfo,
+								 Tuplestorestate ** tupstore, TupleDesc tupdesc)
+{
+	FmgrInfo			   *flinfo;
+	FunctionCallInfoData	fcinfo;
+	ReturnSetInfo			rsinfo;
+	bool					checked = false;
+
+	flinfo = (FmgrInfo *) MemoryContextAllocZero(caller_rsinfo->econtext->ecxt_per_query_memory, sizeof(FmgrInfo));
+	fmgr_info_cxt(func_oid, flinfo, caller_rsinfo->econtext->ecxt_per_query_memory);
+
+	rsinfo.type = T_ReturnSetInfo;
+	rsinfo.econtext = caller_rsinfo->econtext;
+	rsinfo.expectedDesc = tupdesc;
+	rsinfo.allowedModes = (int) (SFRM_ValuePerCall | SFRM_Materialize |
+								 (caller_rsinfo->allowedModes & SFRM_Materialize_Random));
+	rsinfo.returnMode = SFRM_ValuePerCall;
+	rsinfo.setResult = NULL;
+	rsinfo.setDesc = NULL;
+
+	InitFunctionCallInfoData(fcinfo, flinfo, 1, InvalidOid, NULL, (fmNodePtr) &rsinfo);
+	fcinfo.arg[0] = sarg;
+	fcinfo.argnull[0] = false;
+
+	for (;;)
+	{
+		Datum			result;
+		HeapTupleHeader	th;
+		HeapTupleData	tuple;
+
+		CHECK_FOR_INTERRUPTS();
+
+		fcinfo.isnull = false;
+		rsinfo.isDone = ExprSingleResult;
+		result = FunctionCallInvoke(&fcinfo);
+
+		if (rsinfo.returnMode == SFRM_Materialize)
+		{
+			if (rsinfo.setResult != NULL)
+			{
+				sl_solve_check_output(rsinfo.setDesc, tupdesc);
+				tuplestore_end(*tupstore);
+				*tupstore = rsinfo.setResult;
+			}
+			break;
+		}
+		if (rsinfo.isDone == ExprEndResult)
+			break;
+		if (fcinfo.isnull)
+			ereport(ERROR,
+					(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+					 errmsg("SolverAPI: the solver returned a NULL row")));
+
+		th = DatumGetHeapTupleHeader(result);
+		if (!checked)
+		{
+			TupleDesc outdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(th), HeapTupleHeaderGetTypMod(th));
+
+			sl_solve_check_output(outdesc, tupdesc);
+			ReleaseTupleDesc(outdesc);
+			checked = true;
+		}
+		tuple.t_len = HeapTupleHeaderGetDatumLength(th);
+		ItemPointerSetInvalid(&(tuple.t_self));
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = th;
+		tuplestore_puttuple(*tupstore, &tuple);
+
+		if (rsinfo.isDone != ExprMultipleResult)
+			break;
+	}
+}
+
+/* Processes the solve query using the PL/pgSQL implementation of the SOLVE function */
+static void sl_solve_fallback(Datum query, bool query_isnull, Datum par_val_pairs, bool pairs_isnull,
+							 Tuplestorestate * tupstore, MemoryContext tupcontext, TupleDesc tupdesc)
+{
+	StringInfoData	sql;
+	Oid				argtypes[2];
+	Datum			values[2];
+	char			nulls[2];
+	int				i;
+	char		   *solver_name = "";
+	char		   *method_name = "";
+	SL_Solve_Report *report;
+
+	/* The probes get the names as written in the query, since the method is resolved in PL/pgSQL */
+	if (!query_isnull)
+	{
+		HeapTupleHeader	q = DatumGetHeapTupleHeader(query);
+		bool			isnull;
+		Datum			d;
+
+		d = GetAttributeByName(q, "solver_name", &isnull);
+		if (!isnull)
+			solver_name = pstrdup(NameStr(*DatumGetName(d)));
+		d = GetAttributeByName(q, "method_name", &isnull);
+		if (!isnull)
+			method_name = pstrdup(NameStr(*DatumGetName(d)));
+	}
+	sl_solve_report_reset();
+	TRACE_SOLVEDB_SOLVE_START(solver_name, method_name);
+
+	initStringInfo(&sql);
+	appendStringInfoString(&sql, "SELECT * FROM sl_solve_plpgsql($1, $2) AS (");
+	for (i = 0; i < tupdesc->natts; i++)
+		appendStringInfo(&sql, "%s%s %s", i > 0 ? "," : "",
+						 quote_identifier(NameStr(tupdesc->attrs[i]->attname)),
+						 format_type_with_typemod(tupdesc->attrs[i]->atttypid, tupdesc->attrs[i]->atttypmod));
+	appendStringInfoChar(&sql, ')');
+
+	argtypes[0] = TypenameGetTypid("sl_solve_query");
+	argtypes[1] = TEXTARRAYOID;
+	values[0] = query;
+	values[1] = par_val_pairs;
+	nulls[0] = query_isnull ? 'n' : ' ';
+	nulls[1] = pairs_isnull ? 'n' : ' ';
+
+	sl_solve_materialize(sql.data, 2, argtypes, values, nulls, tupstore, tupcontext, tupdesc);
+
+	/* The input rows are not known here */
+	report = sl_solve_report();
+	TRACE_SOLVEDB_SOLVE_DONE(solver_name, method_name, (int64) -1, report->variables,
+							 Max(report->constraints, 0), Max(report->nonzeros, 0));
+}
+
+/* An input relation materialized into a tuplestore (see "solvedb.input_mode") */
+typedef struct SL_Input_Store
+{
+	char					*name;		/* A name of the temporal view exposing the store */
+	Tuplestorestate			*tupstore;
+	TupleDesc				 tupdesc;
+	int64					 numRows;
+	int						 scan_ptr;	/* The read pointer of the scans, see "sl_input_scan" */
+	MemoryContext			 context;	/* Holds the store. It goes away with the transaction at the latest */
+	MemoryContextCallback	 reset_cb;
+	struct SL_Input_Store	*next;
+} SL_Input_Store;
+
+/* All input stores of the backend */
+static SL_Input_Store * sl_input_stores = NULL;
+
+/* Unlinks a store from the list, when its memory context is deleted */
+static void sl_input_store_unlink(void * arg)
+{
+	SL_Input_Store **st;
+
+	for (st = &sl_input_stores; *st != NULL; st = &(*st)->next)
+		if (*st == (SL_Input_Store *) arg)
+		{
+			*st = (*st)->next;
+			break;
+		}
+}
+
+/* Materializes the output of "sql" into a new input store. The caller must be connected to SPI. */
+static SL_Input_Store * sl_input_store_create(const char * name, const char * sql)
+{
+	SL_Input_Store	*st;
+	MemoryContext	 context;
+	MemoryContext	 oldcontext;
+	SPIPlanPtr		 plan;
+	Portal			 portal;
+	DestReceiver	*dest;
+
+	context = AllocSetContextCreate(TopTransactionContext,
+									"SolverAPI input store",
+									ALLOCSET_DEFAULT_MINSIZE,
+									ALLOCSET_DEFAULT_INITSIZE,
+									ALLOCSET_DEFAULT_MAXSIZE);
+
+	st = MemoryContextAllocZero(context, sizeof(SL_Input_Store));
+	st->context = context;
+	st->name = MemoryContextStrdup(context, name);
+	st->reset_cb.func = sl_input_store_unlink;
+	st->reset_cb.arg = st;
+	MemoryContextRegisterResetCallback(context, &st->reset_cb);
+	st->next = sl_input_stores;
+	sl_input_stores = st;
+
+	if ((plan = SPI_prepare(sql, 0, NULL)) == NULL)
+		elog(ERROR, "SolverAPI: SPI_prepare(\"%s\") failed. Returned %d", sql, SPI_result);
+
+	if ((portal = SPI_cursor_open(NULL, plan, NULL, NULL, true)) == NULL)
+		elog(ERROR, "SolverAPI: SPI_cursor_open(\"%s\") failed. Returned %d", sql, SPI_result);
+
+	oldcontext = MemoryContextSwitchTo(context);
+	st->tupdesc = CreateTupleDescCopy(portal->tupDesc);
+	st->tupstore = tuplestore_begin_heap(false, false, work_mem);
+	st->scan_ptr = tuplestore_alloc_read_pointer(st->tupstore, EXEC_FLAG_REWIND);
+	MemoryContextSwitchTo(oldcontext);
+
+	/* The executor stores the tuples directly, as in "sl_solve_materialize" */
+	dest = CreateDestReceiver(DestTuplestore);
+	SetTuplestoreDestReceiverParams(dest, st->tupstore, context, false);
+	PortalRunFetch(portal, FETCH_FORWARD, FETCH_ALL, dest);
+	(*dest->rDestroy) (dest);
+	st->numRows = (int64) tuplestore_tuple_count(st->tupstore);
+
+	SPI_cursor_close(portal);
+	SPI_freeplan(plan);
+
+	return st;
+}
+
+/* Releases an input store */
+static void sl_input_store_drop(SL_Input_Store * st)
+{
+	tuplestore_end(st->tupstore);
+	MemoryContextDelete(st->context);
+}
+
+/*
+ * Scans the input relation materialized by the native SOLVE function in the "tuplestore" mode.
+ * Solvers reach it through the temporal view named after the input relation.
+ *
+ * The input store itself cannot be returned, as the function scan ends the returned tuplestore when
+ * it is done (or rescanned with other parameters). The store is copied through a read pointer of its
+ * own, which leaves the position of the other readers alone, into a tuplestore with random access if
+ * the caller asks for it.
+ */
+PG_FUNCTION_INFO_V1(sl_input_scan);
+Datum sl_input_scan(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	char			   *name = NameStr(*PG_GETARG_NAME(0));
+	SL_Input_Store	   *st;
+	Tuplestorestate	   *tupstore;
+	TupleDesc			tupdesc;
+	TupleTableSlot	   *slot;
+	MemoryContext		oldcontext;
+
+	/* Check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize) || rsinfo->expectedDesc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	for (st = sl_input_stores; st != NULL; st = st->next)
+		if (strcmp(st->name, name) == 0)
+			break;
+	if (st == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_TABLE),
+				 errmsg("SolverAPI: input relation \"%s\" does not exist", name)));
+	if (st->tupdesc->natts != rsinfo->expectedDesc->natts)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("SolverAPI: structure of the input relation \"%s\" does not match the result type", name)));
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupdesc = CreateTupleDescCopy(rsinfo->expectedDesc);
+	tupstore = tuplestore_begin_heap((rsinfo->allowedModes & SFRM_Materialize_Random) != 0, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+
+	slot = MakeSingleTupleTableSlot(st->tupdesc);
+	tuplestore_select_read_pointer(st->tupstore, st->scan_ptr);
+	tuplestore_rescan(st->tupstore);
+	while (tuplestore_gettupleslot(st->tupstore, true, false, slot))
+		tuplestore_puttupleslot(tupstore, slot);
+	ExecDropSingleTupleTableSlot(slot);
+	tuplestore_select_read_pointer(st->tupstore, 0);
+
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
+/* Gets the time elapsed since "start", in milliseconds */
+static double sl_elapsed_ms(instr_time start)
+{
+	instr_time now;
+
+	INSTR_TIME_SET_CURRENT(now);
+	INSTR_TIME_SUBTRACT(now, start);
+
+	return INSTR_TIME_GET_MILLISEC(now);
+}
+
+/* Logs a slow solve with its phases, and the model if "solvedb.log_solve_model" is on */
+static void sl_solve_log(SL_Solve_Method * m, SL_Stat_Solve * stat, SL_Solve_Report * report)
+{
+	SL_Profile		*profile = sl_solve_profile();
+	StringInfoData	 buf;
+	int				 i;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "Phases: input %.3f ms, model %.3f ms, solve %.3f ms.",
+					 stat->time[SL_StatPhase_Input], stat->time[SL_StatPhase_Model], stat->time[SL_StatPhase_Solve]);
+	for (i = 0; i < profile->numPhases; i++)
+		appendStringInfo(&buf, "%s%s %.3f ms (cpu %.3f ms)", i > 0 ? ", " : " Profile: ",
+						 profile->phases[i].name, profile->phases[i].wall_time, profile->phases[i].cpu_time);
+	if (profile->numPhases > 0)
+		appendStringInfoChar(&buf, '.');
+	appendStringInfo(&buf, " Solver work memory peak: " INT64_FORMAT " kB.", (sl_work_mem()->peak + 1023) / 1024);
+	if (sl_log_solve_model)
+	{
+		appendStringInfo(&buf, " Model: " INT64_FORMAT " rows in, " INT64_FORMAT " variables, " INT64_FORMAT " constraints, "
+						 INT64_FORMAT " nonzeros, " INT64_FORMAT " partitions.",
+						 stat->rows_in, stat->variables, stat->constraints, stat->nonzeros, stat->partitions);
+		if (report->model_file[0] != '\0')
+			appendStringInfo(&buf, " The model is written to \"%s\".", report->model_file);
+	}
+
+	ereport(LOG,
+			(errmsg("SolverAPI: solve with \"%s.%s\" took %.3f ms",
+					m->solver_name, m->method_name, stat->time[SL_StatPhase_Total]),
+			 errdetail("%s", buf.data)));
+	pfree(buf.data);
+}
+
+/* Processes the solve query natively. It performs the same steps as "sl_solve_plpgsql":
+ * resolves the solver method, validates parameters, materializes the input relation and
+ * calls the solver. */
+static void sl_solve_native(HeapTupleHeader query, ArrayType * par_val_pairs, ReturnSetInfo * rsinfo,
+							Tuplestorestate ** tupstore, MemoryContext tupcontext, TupleDesc tupdesc)
+{
+	HeapTupleHeader		 problem_h;
+	Datum				 problem;
+	Datum				 d;
+	bool				 isnull;
+	char				*solver_name = NULL;
+	char				*method_name = NULL;
+	char				*input_sql;
+	char				*input_alias;
+	List				*cols_unknown;
+	SL_Solve_Method		*m;
+	List				*params;
+	int32				 api_version;
+	char				*tmp_name;
+	char				*tmp_id;
+	SL_Attribute_Desc	*return_atts;
+	unsigned int		 numReturnAtts;
+	SL_Attribute_Desc	*input_atts;
+	unsigned int		 numInputAtts;
+	TupleDesc			 ad_tupdesc;
+	Datum				*tmp_attrs;
+	unsigned int		 i;
+	ListCell			*c;
+	StringInfoData		 sql;
+	int64				 prb_rowcount;
+	int32				 prb_colcount;
+	Oid					 sarg_typoid;
+	TupleDesc			 sarg_tupdesc;
+	Datum				*sarg_values;
+	bool				*sarg_nulls;
+	Datum				 sarg;
+	MemoryContext		 oldcontext;
+	SL_Input_Store		*input_store = NULL;
+	bool				 direct_call;
+	SL_Stat_Solve		 stat;
+	uint32				 fingerprint = 0;
+	SL_Solve_Report		*report;
+	instr_time			 start_time;
+	instr_time			 phase_time;
+	SL_Profile_Mark		 mark;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+	sl_profile_reset();
+	sl_solve_report_reset();
+	sl_work_mem_reset();
+
+	/* Read the solve query */
+	d = GetAttributeByName(query, "solver_name", &isnull);
+	if (!isnull)
+		solver_name = pstrdup(NameStr(*DatumGetName(d)));
+	d = GetAttributeByName(query, "method_name", &isnull);
+	if (!isnull)
+		method_name = pstrdup(NameStr(*DatumGetName(d)));
+
+	/* Check if user wants help about a solver/method */
+	if (par_val_pairs != NULL && ARR_NDIM(par_val_pairs) > 1)
+	{
+		Datum	   *elems;
+		bool	   *nulls;
+		int			numElems;
+		int			width = ARR_DIMS(par_val_pairs)[1];
+		int			row;
+
+		deconstruct_array(par_val_pairs, TEXTOID, -1, false, 'i', &elems, &nulls, &numElems);
+		for (row = 0; width > 0 && row < numElems / width; row++)
+			if (!nulls[row * width] && pg_strcasecmp(TextDatumGetCString(elems[row * width]), "help") == 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_RAISE_EXCEPTION),
+						 errmsg("Help information requested\r\n%s", sl_solve_get_help(solver_name, method_name))));
+	}
+
+	/* Set's the API's version number, and get unique names of the temporal table and its id column */
+	if (SPI_execute("SELECT sl_get_apiversion(), sl_get_unique_tblname(), sl_get_unique_colname()", false, 1) != SPI_OK_SELECT ||
+		SPI_processed != 1)
+		elog(ERROR, "SolverAPI: Cannot initialize the solver argument");
+	api_version = DatumGetInt32(SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1, &isnull));
+	tmp_name = SPI_getvalue(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 2);
+	tmp_id = SPI_getvalue(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 3);
+
+	/* Checks if the solver is specified */
+	if (solver_name == NULL || solver_name[0] == '\0')
+		ereport(ERROR,
+				(errcode(ERRCODE_RAISE_EXCEPTION),
+				 errmsg("Solver name is not specified.\r\n%s", sl_solve_get_help(solver_name, method_name))));
+
+	/* Search for the solver and the method, and build the parameter list */
+	sl_profile_start(&mark);
+	m = sl_solve_resolve_method(solver_name, method_name);
+	params = sl_solve_build_params(m, par_val_pairs, solver_name, method_name);
+	sl_profile_end(&mark, CurrentMemoryContext, "catalog");
+
+	TRACE_SOLVEDB_SOLVE_START(m->solver_name, m->method_name);
+
+	/* Read the problem */
+	problem = GetAttributeByName(query, "problem", &isnull);
+	if (isnull)
+		ereport(ERROR,
+				(errcode(ERRCODE_RAISE_EXCEPTION),
+				 errmsg("Optimization problem is not specified!")));
+	problem_h = DatumGetHeapTupleHeader(problem);
+	if (sl_stat_enabled())
+		fingerprint = sl_stat_fingerprint(problem_h);
+	input_sql = TextDatumGetCString(GetAttributeByName(problem_h, "input_sql", &isnull));
+	input_alias = pstrdup(NameStr(*DatumGetName(GetAttributeByName(problem_h, "input_alias", &isnull))));
+	d = GetAttributeByName(problem_h, "cols_unknown", &isnull);
+	cols_unknown = isnull ? NIL : sl_get_name_list(d);
+
+	/* Statically analyze the attributes of input SQL -- before the transformation */
+	return_atts = sl_get_query_attributes(input_sql, &numReturnAtts);
+
+	/* Expand "*" expression in the decision column list */
+	foreach(c, cols_unknown)
+		if (strcmp((char *) lfirst(c), "*") == 0)
+		{
+			cols_unknown = NIL;
+			for (i = 0; i < numReturnAtts; i++)
+				cols_unknown = lappend(cols_unknown, return_atts[i].att_name);
+			problem = sl_problem_set_cols_unknown(problem, cols_unknown);
+			problem_h = DatumGetHeapTupleHeader(problem);
+			break;
+		}
+
+	/* Rework the problem, to eliminate CTEs with decision variables */
+	if (m->auto_rewrite_ctes)
+	{
+		problem = sl_solve_rework_ctes(problem);
+		problem_h = DatumGetHeapTupleHeader(problem);
+		input_sql = TextDatumGetCString(GetAttributeByName(problem_h, "input_sql", &isnull));
+		d = GetAttributeByName(problem_h, "cols_unknown", &isnull);
+		cols_unknown = isnull ? NIL : sl_get_name_list(d);
+
+		/* Statically analyze the attributes of input SQL -- after the transformation */
+		input_atts = sl_get_query_attributes(input_sql, &numInputAtts);
+	}
+	else
+	{
+		input_atts = return_atts;
+		numInputAtts = numReturnAtts;
+	}
+
+	/* Check the optimization problem for correctness */
+	sl_solve_check_problem(cols_unknown, input_atts, numInputAtts);
+
+	/* Prepare temp table attribute list while decorating attributes with their kinds */
+	ad_tupdesc = TypeGetTupleDesc(TypenameGetTypid(SL_PGNAME_Sl_Attribute_Desc), NIL);
+	tmp_attrs = palloc(sizeof(Datum) * (numInputAtts + 1));
+	tmp_attrs[0] = sl_build_attribute_desc(ad_tupdesc, tmp_id, "bigint", SL_AttKind_Id);
+	for (i = 0; i < numInputAtts; i++)
+	{
+		bool fnd = false;
+
+		foreach(c, cols_unknown)
+			if ((fnd = (strcmp((char *) lfirst(c), input_atts[i].att_name) == 0)))
+				break;
+
+		tmp_attrs[i + 1] = sl_build_attribute_desc(ad_tupdesc, input_atts[i].att_name, input_atts[i].att_type,
+												   fnd ? SL_AttKind_Unknown : SL_AttKind_Known);
+	}
+
+	/* Materialize the input relation and get basic statistics about the problem */
+	INSTR_TIME_SET_CURRENT(phase_time);
+	sl_profile_start(&mark);
+	initStringInfo(&sql);
+	appendStringInfo(&sql, "SELECT (row_number() OVER ()) AS %s, S.* FROM (%s) AS S", tmp_id, input_sql);
+	prb_colcount = list_length(cols_unknown);
+
+	if (sl_input_mode == SL_InputMode_Tuplestore)
+	{
+		/* Keep the input in memory, and expose it through a view (no heap is written, and no index is built) */
+		input_store = sl_input_store_create(tmp_name, sql.data);
+		prb_rowcount = input_store->numRows;
+
+		resetStringInfo(&sql);
+		appendStringInfo(&sql, "SELECT * FROM sl_input_scan(%s) AS S(%s bigint", quote_literal_cstr(tmp_name), tmp_id);
+		for (i = 0; i < numInputAtts; i++)
+			appendStringInfo(&sql, ", %s %s", quote_identifier(input_atts[i].att_name), input_atts[i].att_type);
+		appendStringInfoChar(&sql, ')');
+		sl_create_tmprelation("VIEW", tmp_name, sql.data);
+	}
+	else
+	{
+		/* Build a temporal table */
+		prb_rowcount = sl_create_tmprelation("TABLE", tmp_name, sql.data);
+
+		/* Add primary key constraint */
+		resetStringInfo(&sql);
+		appendStringInfo(&sql, "CREATE INDEX %s_orderindex ON %s(%s) WITH (fillfactor=100)", tmp_name, tmp_name, tmp_id);
+		if (SPI_exec(sql.data, 0) != SPI_OK_UTILITY)
+			elog(ERROR, "SolverAPI: Cannot create an index on the temporal table %s", tmp_name);
+	}
+	stat.time[SL_StatPhase_Input] = sl_elapsed_ms(phase_time);
+	sl_profile_end(&mark, CurrentMemoryContext, "input");
+
+	/* Build the solver argument */
+	sarg_typoid = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
+	sarg_tupdesc = TypeGetTupleDesc(sarg_typoid, NIL);
+	sarg_values = palloc0(sizeof(Datum) * sarg_tupdesc->natts);
+	sarg_nulls = palloc(sizeof(bool) * sarg_tupdesc->natts);
+	memset(sarg_nulls, true, sizeof(bool) * sarg_tupdesc->natts);
+#define SL_SARG_SET(ATTNAME, VALUE) \
+		do { \
+			AttrNumber attnum = sl_get_attnum(sarg_tupdesc, ATTNAME); \
+			sarg_values[attnum - 1] = (VALUE); \
+			sarg_nulls[attnum - 1] = false; \
+		} while (0)
+	SL_SARG_SET("api_version", Int32GetDatum(api_version));
+	SL_SARG_SET("solver_name", DirectFunctionCall1(namein, CStringGetDatum(m->solver_name)));
+	SL_SARG_SET("method_name", DirectFunctionCall1(namein, CStringGetDatum(m->method_name)));
+	SL_SARG_SET("params", sl_solve_build_param_array(params));
+	SL_SARG_SET("problem", problem);
+	SL_SARG_SET("prb_colcount", Int32GetDatum(prb_colcount));
+	SL_SARG_SET("prb_rowcount", Int64GetDatum(prb_rowcount));
+	SL_SARG_SET("prb_varcount", Int64GetDatum(prb_rowcount * prb_colcount));
+	SL_SARG_SET("tmp_name", DirectFunctionCall1(namein, CStringGetDatum(tmp_name)));
+	SL_SARG_SET("tmp_id", DirectFunctionCall1(namein, CStringGetDatum(tmp_id)));
+	SL_SARG_SET("tmp_attrs", sl_build_composite_array(tmp_attrs, numInputAtts + 1,
+													  TypenameGetTypid(SL_PGNAME_Sl_Attribute_Desc)));
+#undef SL_SARG_SET
+	sarg = HeapTupleGetDatum(heap_form_tuple(sarg_tupdesc, sarg_values, sarg_nulls));
+
+	/* Build the query calling the solver (see "sl_get_dst_prequery") */
+	resetStringInfo(&sql);
+	appendStringInfo(&sql, "WITH %s AS (SELECT * FROM %s($1) AS (",
+					 quote_identifier(NameStr(*DatumGetName(GetAttributeByName(problem_h, "input_alias", &isnull)))),
+					 m->func_sql);
+	for (i = 0; i < numInputAtts; i++)
+		appendStringInfo(&sql, "%s%s %s", i > 0 ? "," : "",
+						 quote_identifier(input_atts[i].att_name), input_atts[i].att_type);
+	appendStringInfoString(&sql, "))");
+
+	d = GetAttributeByName(problem_h, "ctes", &isnull);
+	direct_call = sl_solve_direct && OidIsValid(m->func_oid) &&
+				  (isnull || ArrayGetNItems(ARR_NDIM(DatumGetArrayTypeP(d)), ARR_DIMS(DatumGetArrayTypeP(d))) == 0);
+	if (!isnull)
+		foreach(c, get_datum_array_contents(DatumGetArrayTypeP(d)))
+		{
+			HeapTupleHeader cte;
+			bool			cte_isnull;
+
+			if (lfirst(c) == NULL)
+				continue;
+			cte = DatumGetHeapTupleHeader((Datum) lfirst(c));
+			appendStringInfo(&sql, ", %s AS (%s)",
+							 quote_identifier(NameStr(*DatumGetName(GetAttributeByName(cte, "input_alias", &cte_isnull)))),
+							 TextDatumGetCString(GetAttributeByName(cte, "input_sql", &cte_isnull)));
+		}
+
+	appendStringInfoString(&sql, " SELECT ");
+	for (i = 0; i < numReturnAtts; i++)
+		appendStringInfo(&sql, "%s%s::%s", i > 0 ? "," : "",
+						 quote_identifier(return_atts[i].att_name), return_atts[i].att_type);
+	appendStringInfo(&sql, " FROM %s", input_alias);
+
+	/* The solver can be called directly, if the wrapping query would return its output unchanged */
+	for (i = 0; direct_call && i < numReturnAtts; i++)
+		direct_call = numReturnAtts == numInputAtts &&
+					  strcmp(return_atts[i].att_name, input_atts[i].att_name) == 0 &&
+					  strcmp(return_atts[i].att_type, input_atts[i].att_type) == 0;
+
+	/* Make a call to the solver */
+	INSTR_TIME_SET_CURRENT(phase_time);
+	oldcontext = CurrentMemoryContext;
+	PG_TRY();
+	{
+		if (direct_call)
+			sl_solve_call_direct(m->func_oid, sarg, rsinfo, tupstore, tupdesc);
+		else
+			sl_solve_materialize(sql.data, 1, &sarg_typoid, &sarg, NULL, *tupstore, tupcontext, tupdesc);
+	}
+	PG_CATCH();
+	{
+		ErrorData  *edata;
+
+		MemoryContextSwitchTo(oldcontext);
+		edata = CopyErrorData();
+		if (edata->sqlerrcode != ERRCODE_UNDEFINED_FUNCTION && edata->sqlerrcode != ERRCODE_RAISE_EXCEPTION)
+			PG_RE_THROW();
+		FlushErrorState();
+		edata->sqlerrcode = ERRCODE_RAISE_EXCEPTION;
+		edata->message = psprintf("Error executing the solver \"%s\".\r\nERROR: %s", solver_name, edata->message);
+		ReThrowError(edata);
+	}
+	PG_END_TRY();
+
+	/* Split the solver call into the phases reported by the solver */
+	report = sl_solve_report();
+	stat.time[SL_StatPhase_Model] = report->model_time >= 0 ? report->model_time : 0;
+	stat.time[SL_StatPhase_Solve] = Max(sl_elapsed_ms(phase_time) - stat.time[SL_StatPhase_Model], 0);
+	stat.rows_in = prb_rowcount;
+	stat.variables = report->variables >= 0 ? report->variables : prb_rowcount * prb_colcount;
+	stat.constraints = Max(report->constraints, 0);
+	stat.nonzeros = Max(report->nonzeros, 0);
+	stat.partitions = Max(report->partitions, 0);
+
+	/* Destroy a temporary table (or view) */
+	resetStringInfo(&sql);
+	appendStringInfo(&sql, "DROP %s %s RESTRICT", input_store != NULL ? "VIEW" : "TABLE", tmp_name);
+	if (SPI_exec(sql.data, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "SolverAPI: Cannot drop the temporal relation %s", tmp_name);
+
+	if (input_store != NULL)
+		sl_input_store_drop(input_store);
+
+	stat.time[SL_StatPhase_Total] = sl_elapsed_ms(start_time);
+	TRACE_SOLVEDB_SOLVE_DONE(m->solver_name, m->method_name, stat.rows_in, stat.variables, stat.constraints, stat.nonzeros);
+	sl_stat_store(m->solver_name, m->method_name, fingerprint, &stat);
+
+	if (sl_log_min_solve_duration >= 0 && stat.time[SL_StatPhase_Total] >= sl_log_min_solve_duration)
+		sl_solve_log(m, &stat, report);
+}
+
+/*
+ * The main entrance to the solving routines, the SOLVE function. It finds a solver method,
+ * generates the solver arguments, calls the solver and materializes its output.
+ */
+PG_FUNCTION_INFO_V1(sl_solve);
+Datum sl_solve(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate	   *tupstore;
+	TupleDesc			tupdesc;
+	MemoryContext		oldcontext;
+	int					ret;
+
+	/* Check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize) || rsinfo->expectedDesc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	/* The tuplestore must outlive this call */
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupdesc = CreateTupleDescCopy(rsinfo->expectedDesc);
+	tupstore = tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Connect to SPI manager */
+	if ((ret = SPI_connect()) < 0)
+		elog(ERROR, "SolverAPI: SPI_connect returned %d", ret);
+
+	if (!sl_native_solve)
+		sl_solve_fallback(PG_GETARG_DATUM(0), PG_ARGISNULL(0), PG_GETARG_DATUM(1), PG_ARGISNULL(1),
+						  tupstore, rsinfo->econtext->ecxt_per_query_memory, tupdesc);
+	else
+	{
+		if (PG_ARGISNULL(0))
+			ereport(ERROR,
+					(errcode(ERRCODE_RAISE_EXCEPTION),
+					 errmsg("Optimization problem is not specified!")));
+
+		sl_solve_native(PG_GETARG_HEAPTUPLEHEADER(0), PG_ARGISNULL(1) ? NULL : PG_GETARG_ARRAYTYPE_P(1),
+						rsinfo, &tupstore, rsinfo->econtext->ecxt_per_query_memory, tupdesc);
+	}
+
+	/* release SPI related resources (and return to caller's context) */
+	SPI_finish();
+
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
 PG_FUNCTION_INFO_V1(sl_ctr_in);
 extern Datum sl_ctr_in(PG_FUNCTION_ARGS)
 {
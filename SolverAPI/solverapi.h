@@ -12,10 +12,33 @@
 #include "libsolverapi.h"
 
 Datum sl_get_attributes_from_sql(PG_FUNCTION_ARGS);
+Datum sl_query_cache_stats(PG_FUNCTION_ARGS);
 Datum sl_dummy_solve(PG_FUNCTION_ARGS);
+/* A microbenchmark of the composite datum decoders */
+Datum sl_bench_decode(PG_FUNCTION_ARGS);
+/* Converts a SolverAPI enum value to C and back (for testing) */
+Datum sl_enum_roundtrip(PG_FUNCTION_ARGS);
 /* The function is used to create TMP table in security-restricted environment in PostgreSQL 9.3.1.
  * Hope this will not be needed in later DBMS editions */
 Datum sl_createtmptable_unrestricted(PG_FUNCTION_ARGS);
+/* The native implementation of the SOLVE function */
+Datum sl_solve(PG_FUNCTION_ARGS);
+/* Scans an input relation kept in memory by the SOLVE function */
+Datum sl_input_scan(PG_FUNCTION_ARGS);
+
+/* SQL-callable view SQL generators */
+Datum sl_sql_build_out(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_userdefined(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_vars(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_funcNmap(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_funcNsubst(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_func1subst(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_arrayNsubst(PG_FUNCTION_ARGS);
+Datum sl_sql_build_out_array1subst(PG_FUNCTION_ARGS);
+Datum sl_sql_build_dst_values(PG_FUNCTION_ARGS);
+Datum sl_sql_build_dst_obj(PG_FUNCTION_ARGS);
+Datum sl_sql_build_dst_ctr(PG_FUNCTION_ARGS);
+Datum sl_sql_return(PG_FUNCTION_ARGS);
 
 /* Constraint handling functions */
 extern Datum sl_ctr_in(PG_FUNCTION_ARGS);
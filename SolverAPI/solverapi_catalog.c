@@ -0,0 +1,409 @@
+/*
+ * solverapi_catalog.c
+ *
+ *  A backend-local cache of the SolverAPI catalogs. Solver method descriptors (including
+ *  the OIDs of the method functions, parameter types and converted default values) are
+ *  resolved once and reused by subsequent solves. The cache is flushed when:
+ *   - any of the catalog tables "sl_solver", "sl_solver_method", "sl_parameter", "sl_solver_param"
+ *     and "sl_solver_method_param" changes (the statement-level triggers calling
+ *     "sl_catalog_invalidate" send a relcache invalidation for the table to all backends),
+ *   - the relcache or the "pg_proc" syscache is reset.
+ *  A descriptor is dropped when the function of the method changes (a "pg_proc" invalidation with the
+ *  hash value of the function) or, if the function was not found, when any function changes. As the names
+ *  are resolved with the search_path, a descriptor is reloaded when used with another search_path.
+ */
+
+#include "solverapi_catalog.h"
+#include "executor/spi.h"
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/sysattr.h"
+#include "commands/extension.h"
+#include "commands/trigger.h"
+#include "catalog/indexing.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_extension.h"
+#include "parser/parse_func.h"
+#include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+
+/* The catalog tables the cache depends on */
+#define SL_CATALOG_NUMRELS	5
+static const char * sl_catalog_relnames[SL_CATALOG_NUMRELS] =
+	{"sl_solver", "sl_solver_method", "sl_parameter", "sl_solver_param", "sl_solver_method_param"};
+
+/* A key of the cache. An empty method name stands for the default method of the solver. */
+typedef struct SL_Catalog_Key
+{
+	NameData	solver_name;
+	NameData	method_name;
+} SL_Catalog_Key;
+
+typedef struct SL_Catalog_Entry
+{
+	SL_Catalog_Key		 key;			/* Hash key, must be the first */
+	SL_Solve_Method		 method;		/* The descriptor, allocated in "context" */
+	OverrideSearchPath	*search_path;	/* The search_path the descriptor was resolved with */
+	uint32				 proc_hash;		/* The "pg_proc" syscache hash value of the method function */
+	MemoryContext		 context;		/* A child of sl_catalog_context */
+} SL_Catalog_Entry;
+
+static MemoryContext sl_catalog_context = NULL;	/* Holds the hash table and the descriptors */
+static HTAB 		*sl_catalog_htab = NULL;
+static Oid			 sl_catalog_relids[SL_CATALOG_NUMRELS];
+static bool			 sl_catalog_relids_valid = false;
+static uint64		 sl_catalog_generation = 0;	/* Incremented on every flush or dropped entry */
+
+/* Drops all cached descriptors */
+static void sl_catalog_flush(void)
+{
+	if (sl_catalog_context != NULL)
+		MemoryContextReset(sl_catalog_context);
+	sl_catalog_htab = NULL;
+	sl_catalog_relids_valid = false;
+	sl_catalog_generation++;
+}
+
+static void sl_catalog_relcache_callback(Datum arg, Oid relid)
+{
+	int i;
+
+	if (sl_catalog_htab == NULL)
+		return;
+
+	if (relid == InvalidOid || !sl_catalog_relids_valid)
+	{
+		sl_catalog_flush();
+		return;
+	}
+
+	for (i = 0; i < SL_CATALOG_NUMRELS; i++)
+		if (sl_catalog_relids[i] == relid)
+		{
+			sl_catalog_flush();
+			return;
+		}
+}
+
+/* Drops the descriptors of the methods whose function changed */
+static void sl_catalog_syscache_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS		 status;
+	SL_Catalog_Entry	*entry;
+
+	if (sl_catalog_htab == NULL)
+		return;
+
+	if (hashvalue == 0)
+	{
+		sl_catalog_flush();
+		return;
+	}
+
+	hash_seq_init(&status, sl_catalog_htab);
+	while ((entry = (SL_Catalog_Entry *) hash_seq_search(&status)) != NULL)
+		if (!OidIsValid(entry->method.func_oid) || entry->proc_hash == hashvalue)
+		{
+			MemoryContextDelete(entry->context);
+			hash_search(sl_catalog_htab, &entry->key, HASH_REMOVE, NULL);
+			sl_catalog_generation++;
+		}
+}
+
+extern void sl_catalog_init(void)
+{
+	CacheRegisterRelcacheCallback(sl_catalog_relcache_callback, (Datum) 0);
+	CacheRegisterSyscacheCallback(PROCOID, sl_catalog_syscache_callback, (Datum) 0);
+}
+
+/* Gets the schema of the SolverAPI extension, which holds the catalog tables (as "get_extension_schema",
+ * which is not exported) */
+static Oid sl_catalog_get_schema(void)
+{
+	Oid				 extoid = get_extension_oid("solverapi", false);
+	Oid				 nspid = InvalidOid;
+	Relation		 rel;
+	SysScanDesc		 scan;
+	HeapTuple		 tuple;
+	ScanKeyData		 entry[1];
+
+	rel = heap_open(ExtensionRelationId, AccessShareLock);
+	ScanKeyInit(&entry[0],
+				ObjectIdAttributeNumber,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(extoid));
+	scan = systable_beginscan(rel, ExtensionOidIndexId, true, NULL, 1, entry);
+	tuple = systable_getnext(scan);
+	if (HeapTupleIsValid(tuple))
+		nspid = ((Form_pg_extension) GETSTRUCT(tuple))->extnamespace;
+	systable_endscan(scan);
+	heap_close(rel, AccessShareLock);
+
+	return nspid;
+}
+
+extern void sl_catalog_set_param_value(SL_Solve_ParamValue * pv, SL_Solve_ParType type, const char * value)
+{
+	pv->type = type;
+	pv->isnull = (value == NULL);
+	if (pv->isnull)
+		return;
+
+	switch (type)
+	{
+		case SL_ParType_Int:
+			pv->value_i = DatumGetInt32(DirectFunctionCall1(int4in, CStringGetDatum(value)));
+			break;
+		case SL_ParType_Float:
+			pv->value_f = DatumGetFloat8(DirectFunctionCall1(float8in, CStringGetDatum(value)));
+			break;
+		default:
+			pv->value_t = pstrdup(value);
+			break;
+	}
+}
+
+static char * sl_strdup_or_null(const char * s)
+{
+	return s == NULL ? NULL : pstrdup(s);
+}
+
+/* Copies a method descriptor into the current memory context */
+static void sl_catalog_copy_method(SL_Solve_Method * dst, const SL_Solve_Method * src)
+{
+	int i;
+
+	*dst = *src;
+	dst->solver_name = pstrdup(src->solver_name);
+	dst->method_name = pstrdup(src->method_name);
+	dst->func_name = pstrdup(src->func_name);
+	dst->func_sql = pstrdup(src->func_sql);
+	dst->params = palloc0(sizeof(SL_Solve_Param) * (src->numParams + 1));
+
+	for (i = 0; i < src->numParams; i++)
+	{
+		dst->params[i] = src->params[i];
+		dst->params[i].name = pstrdup(src->params[i].name);
+		dst->params[i].value_default = sl_strdup_or_null(src->params[i].value_default);
+		dst->params[i].value_min = sl_strdup_or_null(src->params[i].value_min);
+		dst->params[i].value_max = sl_strdup_or_null(src->params[i].value_max);
+		dst->params[i].def.param = dst->params[i].name;
+		dst->params[i].def.value_t = sl_strdup_or_null(src->params[i].def.value_t);
+	}
+}
+
+/* Resolves the solver and the method (or the default method) of the solver from the catalogs */
+static SL_Catalog_Result sl_catalog_load_method(const char * solver_name, const char * method_name,
+												SL_Solve_Method * m)
+{
+	Oid				 argtypes[2] = {NAMEOID, NAMEOID};
+	Datum			 values[2];
+	HeapTuple		 tuple;
+	TupleDesc		 tupdesc;
+	bool			 isnull;
+	Oid				 sarg_typoid;
+	int				 i;
+
+	values[0] = DirectFunctionCall1(namein, CStringGetDatum(solver_name));
+	values[1] = DirectFunctionCall1(namein, CStringGetDatum(method_name));
+
+	if (SPI_execute_with_args("SELECT s.sid, s.name, m.mid, m.name, m.func_name, m.auto_rewrite_ctes "
+							  "FROM sl_solver s LEFT OUTER JOIN sl_solver_method m "
+							  "ON (CASE WHEN $2 = ''::name THEN m.mid = s.default_method_id "
+							  "         ELSE (m.sid = s.sid) AND (m.name = $2) END) "
+							  "WHERE s.name = $1",
+							  2, argtypes, values, NULL, true, 2) != SPI_OK_SELECT)
+		elog(ERROR, "SolverAPI: Cannot query the solver catalog");
+
+	if (SPI_processed == 0)
+		return SL_Catalog_NoSolver;
+
+	tuple = SPI_tuptable->vals[0];
+	tupdesc = SPI_tuptable->tupdesc;
+
+	MemSet(m, 0, sizeof(SL_Solve_Method));
+	m->sid = DatumGetInt32(SPI_getbinval(tuple, tupdesc, 1, &isnull));
+	m->solver_name = SPI_getvalue(tuple, tupdesc, 2);
+	m->mid = DatumGetInt32(SPI_getbinval(tuple, tupdesc, 3, &isnull));
+	if (isnull)
+		return SL_Catalog_NoMethod;
+
+	m->method_name = SPI_getvalue(tuple, tupdesc, 4);
+	m->func_name = SPI_getvalue(tuple, tupdesc, 5);
+	m->auto_rewrite_ctes = DatumGetBool(SPI_getbinval(tuple, tupdesc, 6, &isnull));
+	if (isnull)
+		m->auto_rewrite_ctes = false;
+
+	/* Resolve the function implementing the method, i.e., "func_name(sl_solver_arg)" */
+	sarg_typoid = TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg);
+	m->func_oid = LookupFuncName(list_make1(makeString(m->func_name)), 1, &sarg_typoid, true);
+	if (OidIsValid(m->func_oid))
+		m->func_sql = quote_qualified_identifier(get_namespace_name(get_func_namespace(m->func_oid)),
+												 get_func_name(m->func_oid));
+	else
+		m->func_sql = pstrdup(quote_identifier(m->func_name));
+
+	/* Get all parameters of the solver and the solver method */
+	argtypes[0] = INT4OID;
+	argtypes[1] = INT4OID;
+	values[0] = Int32GetDatum(m->sid);
+	values[1] = Int32GetDatum(m->mid);
+
+	if (SPI_execute_with_args("SELECT p.name, p.type::text, p.value_default, p.value_min::text, p.value_max::text, p.push_default "
+							  "FROM sl_parameter p "
+							  "WHERE (p.pid IN (SELECT pid FROM sl_solver_param WHERE sid = $1)) OR "
+							  "      (p.pid IN (SELECT pid FROM sl_solver_method_param WHERE mid = $2)) "
+							  "ORDER BY p.pid",
+							  2, argtypes, values, NULL, true, 0) != SPI_OK_SELECT)
+		elog(ERROR, "SolverAPI: Cannot query the parameter catalog");
+
+	m->numParams = (int) SPI_processed;
+	m->params = palloc0(sizeof(SL_Solve_Param) * (m->numParams + 1));
+
+	for (i = 0; i < m->numParams; i++)
+	{
+		SL_Solve_Param *par 	= &m->params[i];
+		char	   	   *type;
+
+		tuple = SPI_tuptable->vals[i];
+		tupdesc = SPI_tuptable->tupdesc;
+		type = SPI_getvalue(tuple, tupdesc, 2);
+
+		par->name = SPI_getvalue(tuple, tupdesc, 1);
+		par->type = strcmp(type, "int") == 0   ? SL_ParType_Int :
+					strcmp(type, "float") == 0 ? SL_ParType_Float :
+												 SL_ParType_Text;
+		par->value_default = SPI_getvalue(tuple, tupdesc, 3);
+		par->value_min = SPI_getvalue(tuple, tupdesc, 4);
+		par->value_max = SPI_getvalue(tuple, tupdesc, 5);
+		if (par->value_min != NULL)
+			par->min = DatumGetFloat8(DirectFunctionCall1(float8in, CStringGetDatum(par->value_min)));
+		if (par->value_max != NULL)
+			par->max = DatumGetFloat8(DirectFunctionCall1(float8in, CStringGetDatum(par->value_max)));
+		par->push_default = DatumGetBool(SPI_getbinval(tuple, tupdesc, 6, &isnull));
+
+		par->def.param = par->name;
+		sl_catalog_set_param_value(&par->def, par->type, par->value_default);
+	}
+
+	return SL_Catalog_Found;
+}
+
+extern SL_Catalog_Result sl_catalog_get_method(const char * solver_name, const char * method_name,
+											   SL_Solve_Method ** method)
+{
+	SL_Catalog_Key		 key;
+	SL_Catalog_Entry	*entry;
+	SL_Solve_Method		 loaded;
+	SL_Catalog_Result	 res;
+	Oid					 relids[SL_CATALOG_NUMRELS];
+	uint64				 generation;
+	bool				 found;
+	Oid					 nspid;
+	int					 i;
+
+	if (method_name == NULL)
+		method_name = "";
+
+	MemSet(&key, 0, sizeof(key));
+	namestrcpy(&key.solver_name, solver_name);
+	namestrcpy(&key.method_name, method_name);
+
+	/* Fast path: the method is already cached */
+	if (sl_catalog_htab != NULL)
+	{
+		entry = (SL_Catalog_Entry *) hash_search(sl_catalog_htab, &key, HASH_FIND, NULL);
+		if (entry != NULL && OverrideSearchPathMatchesCurrent(entry->search_path))
+		{
+			*method = palloc(sizeof(SL_Solve_Method));
+			sl_catalog_copy_method(*method, &entry->method);
+			return SL_Catalog_Found;
+		}
+	}
+
+	/* Slow path: query the catalogs. Invalidations may arrive while querying, in which case
+	 * the loaded descriptor is used, but not cached. */
+	generation = sl_catalog_generation;
+	res = sl_catalog_load_method(solver_name, method_name, &loaded);
+	if (res != SL_Catalog_Found)
+	{
+		*method = NULL;
+		return res;
+	}
+
+	/* Resolve the OIDs of the catalog tables in the schema of the extension (whatever the search_path),
+	 * so that the relcache callback can recognize them */
+	nspid = sl_catalog_get_schema();
+	for (i = 0; i < SL_CATALOG_NUMRELS; i++)
+		relids[i] = get_relname_relid(sl_catalog_relnames[i], nspid);
+
+	if (generation == sl_catalog_generation)
+	{
+		MemoryContext oldcontext;
+
+		if (sl_catalog_context == NULL)
+			sl_catalog_context = AllocSetContextCreate(CacheMemoryContext,
+													   "SolverAPI catalog cache",
+													   ALLOCSET_DEFAULT_MINSIZE,
+													   ALLOCSET_DEFAULT_INITSIZE,
+													   ALLOCSET_DEFAULT_MAXSIZE);
+		if (sl_catalog_htab == NULL)
+		{
+			HASHCTL ctl;
+
+			MemSet(&ctl, 0, sizeof(ctl));
+			ctl.keysize = sizeof(SL_Catalog_Key);
+			ctl.entrysize = sizeof(SL_Catalog_Entry);
+			ctl.hash = tag_hash;
+			ctl.hcxt = sl_catalog_context;
+			sl_catalog_htab = hash_create("SolverAPI solver methods", 64, &ctl,
+										  HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+			memcpy(sl_catalog_relids, relids, sizeof(relids));
+			sl_catalog_relids_valid = true;
+		}
+
+		/* An entry resolved with another search_path is replaced */
+		entry = (SL_Catalog_Entry *) hash_search(sl_catalog_htab, &key, HASH_ENTER, &found);
+		if (found)
+			MemoryContextDelete(entry->context);
+		entry->context = AllocSetContextCreate(sl_catalog_context,
+											   "SolverAPI solver method",
+											   ALLOCSET_SMALL_MINSIZE,
+											   ALLOCSET_SMALL_INITSIZE,
+											   ALLOCSET_SMALL_MAXSIZE);
+		oldcontext = MemoryContextSwitchTo(entry->context);
+		sl_catalog_copy_method(&entry->method, &loaded);
+		entry->search_path = GetOverrideSearchPath(entry->context);
+		entry->proc_hash = OidIsValid(loaded.func_oid) ?
+						   GetSysCacheHashValue1(PROCOID, ObjectIdGetDatum(loaded.func_oid)) : 0;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	*method = palloc(sizeof(SL_Solve_Method));
+	**method = loaded;
+	return SL_Catalog_Found;
+}
+
+/*
+ * A statement-level trigger on the SolverAPI catalog tables. It sends a relcache invalidation
+ * for the modified table, so that all backends drop their cached solver method descriptors.
+ */
+PG_FUNCTION_INFO_V1(sl_catalog_invalidate);
+Datum sl_catalog_invalidate(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "SolverAPI: sl_catalog_invalidate() must be called as a trigger");
+
+	CacheInvalidateRelcache(trigdata->tg_relation);
+
+	return PointerGetDatum(NULL);
+}
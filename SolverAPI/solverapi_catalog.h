@@ -0,0 +1,72 @@
+/*
+ * solverapi_catalog.h
+ *
+ *  A backend-local cache of the SolverAPI catalogs, i.e., the solvers, the solver methods
+ *  and their parameters.
+ */
+
+#ifndef SOLVERAPI_CATALOG_H_
+#define SOLVERAPI_CATALOG_H_
+
+#include "solverapi.h"
+
+/* A type of a solver or method parameter as declared in "sl_parameter" */
+typedef enum { SL_ParType_Int = 0, SL_ParType_Float, SL_ParType_Text } SL_Solve_ParType;
+
+/* A parameter-value pair passed to a solver, i.e., the "sl_parameter_value" */
+typedef struct SL_Solve_ParamValue
+{
+	char			 *param;		/* A parameter name */
+	SL_Solve_ParType  type;			/* Which of the values is set */
+	bool			  isnull;		/* True, if no value is set */
+	int32			  value_i;
+	float8			  value_f;
+	char			 *value_t;
+} SL_Solve_ParamValue;
+
+/* A solver or method parameter as declared in "sl_parameter" */
+typedef struct SL_Solve_Param
+{
+	char			 *name;			/* A parameter name */
+	SL_Solve_ParType  type;			/* A type of the parameter */
+	char			 *value_default;/* A default value represented as text, or NULL */
+	char			 *value_min;	/* A minimum numeric value represented as text, or NULL */
+	char			 *value_max;	/* A maximum numeric value represented as text, or NULL */
+	float8			  min;			/* The minimum value, valid if value_min is not NULL */
+	float8			  max;			/* The maximum value, valid if value_max is not NULL */
+	SL_Solve_ParamValue def;		/* The default value converted to the parameter type */
+	bool			  push_default;	/* Should the default value be pushed to the solver */
+} SL_Solve_Param;
+
+/* A solver method resolved from the SolverAPI catalogs */
+typedef struct SL_Solve_Method
+{
+	int32		 	 sid;				/* ID of the solver */
+	char			*solver_name;		/* A name of the solver */
+	int32		 	 mid;				/* ID of the solver method */
+	char			*method_name;		/* A name of the solver method */
+	char			*func_name;			/* A name of PG function implementing the method */
+	Oid				 func_oid;			/* OID of the function, or InvalidOid if it cannot be resolved */
+	char			*func_sql;			/* A quoted (and schema-qualified, if resolved) function name */
+	bool		 	 auto_rewrite_ctes;	/* Should CTEs with decision variables be rewritten */
+	int				 numParams;			/* A number of parameters of the solver and the method */
+	SL_Solve_Param	*params;			/* Parameters of the solver and the method, ordered by "pid" */
+} SL_Solve_Method;
+
+/* Outcomes of a solver method lookup */
+typedef enum { SL_Catalog_Found = 0, SL_Catalog_NoSolver, SL_Catalog_NoMethod } SL_Catalog_Result;
+
+/* Registers the cache invalidation callbacks. Called once, from "_PG_init" of the module. */
+extern void sl_catalog_init(void);
+/* Looks up the method "method_name" (or the default method, if NULL or empty) of the solver "solver_name".
+ * On success, sets "method" to a copy of the descriptor allocated in the current memory context.
+ * On a cache miss the catalogs are queried, thus the caller must be connected to SPI. */
+extern SL_Catalog_Result sl_catalog_get_method(const char * solver_name, const char * method_name,
+											   SL_Solve_Method ** method);
+/* Converts a parameter value from text to the type of the parameter */
+extern void sl_catalog_set_param_value(SL_Solve_ParamValue * pv, SL_Solve_ParType type, const char * value);
+
+/* A trigger function invalidating the cache in all backends, when the catalogs change */
+extern Datum sl_catalog_invalidate(PG_FUNCTION_ARGS);
+
+#endif /* SOLVERAPI_CATALOG_H_ */
@@ -0,0 +1,486 @@
+/*
+ * solverapi_explain.c
+ *
+ *  EXPLAIN [ANALYZE] support for SOLVESELECT. A SOLVESELECT is parsed into a query scanning
+ *  the "sl_solve" function, thus EXPLAIN alone only shows a function scan. The hook below
+ *  explains such queries as usual, and then describes each solve of the query (found also in
+ *  WITH queries and sublinks) in a "SolveDB" section of the query:
+ *   - the resolved solver, method and function, and the solver parameters,
+ *   - the input query with its plan, the objective and the constraint queries.
+ *  Under ANALYZE, the solves are run, and the section also shows the queries generated by the
+ *  view SQL builders (planned while the input relation exists), the model reported by the
+ *  solver and the phases of the solve (see "sl_last_solve_profile"). If a query runs several
+ *  solves, the model and the phases are the ones of the last solve.
+ *
+ *  The hook is installed when the module loads. To explain a SOLVESELECT as the first statement
+ *  of a session, load the module via "shared_preload_libraries", "session_preload_libraries" or LOAD.
+ */
+
+#include "solverapi_explain.h"
+#include "solverapi_catalog.h"
+#include "access/xact.h"
+#include "commands/createas.h"
+#include "commands/explain.h"
+#include "executor/executor.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/planner.h"
+#include "optimizer/var.h"
+#include "parser/parsetree.h"
+#include "tcop/tcopprot.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/snapmgr.h"
+
+static ExplainOneQuery_hook_type prev_ExplainOneQuery = NULL;
+
+/*
+ * Collects the calls of "sl_solve" in the query, its subqueries, WITH queries and sublinks. Only
+ * set-returning calls with two arguments are looked up by name, as SOLVESELECT produces.
+ */
+static bool sl_explain_find_solves(Node * node, List ** solves)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, FuncExpr))
+	{
+		FuncExpr *fexpr = (FuncExpr *) node;
+
+		if (fexpr->funcretset && list_length(fexpr->args) == 2)
+		{
+			char *fname = get_func_name(fexpr->funcid);
+
+			/* The call is copied, as the planner may scribble on the query */
+			if (fname != NULL && strcmp(fname, "sl_solve") == 0)
+				*solves = lappend(*solves, copyObject(fexpr));
+		}
+	}
+	else if (IsA(node, Query))
+		return query_tree_walker((Query *) node, sl_explain_find_solves, (void *) solves, 0);
+
+	return expression_tree_walker(node, sl_explain_find_solves, (void *) solves);
+}
+
+/* Shows a query and the text of its plan, if any */
+static void sl_explain_query(const char * label, const char * sql, const char * plan, ExplainState * es)
+{
+	ExplainPropertyText(label, sql, es);
+	if (plan == NULL)
+		return;
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		const char *line = plan;
+
+		/* Indent the plan under the query */
+		while (*line != '\0')
+		{
+			const char *end = strchr(line, '\n');
+			int			len = end != NULL ? end - line : strlen(line);
+
+			appendStringInfoSpaces(es->str, (es->indent + 1) * 2);
+			appendBinaryStringInfo(es->str, line, len);
+			appendStringInfoChar(es->str, '\n');
+			line += len + (end != NULL ? 1 : 0);
+		}
+	}
+	else
+		ExplainPropertyText(psprintf("%s Plan", label), plan, es);
+}
+
+/* Plans a query of the problem. Returns the text of the plan. */
+static char * sl_explain_plan(const char * sql, ExplainState * es)
+{
+	StringInfoData	buf;
+	uint64			i;
+
+	if (SPI_execute(psprintf("EXPLAIN (COSTS %s) %s", es->costs ? "ON" : "OFF", sql), false, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "SolverAPI: Cannot explain the query \"%s\"", sql);
+
+	initStringInfo(&buf);
+	for (i = 0; i < SPI_processed; i++)
+		appendStringInfo(&buf, "%s%s", i > 0 ? "\n" : "", SPI_getvalue(SPI_tuptable->vals[i], SPI_tuptable->tupdesc, 1));
+
+	return buf.data;
+}
+
+/* Evaluates an argument of "sl_solve". Returns false, if it cannot be evaluated before the query runs. */
+static bool sl_explain_eval_arg(Node * arg, ExprContext * econtext, Datum * value, bool * isnull)
+{
+	Expr	   *expr;
+	ExprState  *state;
+
+	if (contain_subplans(arg) || contain_var_clause(arg) || contain_volatile_functions(arg))
+		return false;
+
+	expr = expression_planner((Expr *) copyObject(arg));
+	state = ExecInitExpr(expr, NULL);
+	*value = ExecEvalExprSwitchContext(state, econtext, isnull, NULL);
+
+	return true;
+}
+
+/* Describes a solve of the explained query */
+static void sl_explain_solve(FuncExpr * fexpr, ExplainState * es, ParamListInfo params)
+{
+	ExprContext		   *econtext = CreateStandaloneExprContext();
+	Datum				query;
+	Datum				pairs;
+	bool				query_isnull;
+	bool				pairs_isnull;
+	HeapTupleHeader		query_h;
+	HeapTupleHeader		problem_h;
+	Datum				d;
+	bool				isnull;
+	char			   *solver_name = NULL;
+	char			   *method_name = NULL;
+	SL_Solve_Method	   *m;
+
+	econtext->ecxt_param_list_info = params;
+
+	ExplainOpenGroup("Solve", NULL, true, es);
+
+	if (!sl_explain_eval_arg((Node *) linitial(fexpr->args), econtext, &query, &query_isnull) ||
+		!sl_explain_eval_arg((Node *) lsecond(fexpr->args), econtext, &pairs, &pairs_isnull) || query_isnull)
+	{
+		ExplainPropertyText("Solver", "(computed at run time)", es);
+		ExplainCloseGroup("Solve", NULL, true, es);
+		FreeExprContext(econtext, true);
+		return;
+	}
+
+	query_h = DatumGetHeapTupleHeader(query);
+	d = GetAttributeByName(query_h, "solver_name", &isnull);
+	if (!isnull)
+		solver_name = pstrdup(NameStr(*DatumGetName(d)));
+	d = GetAttributeByName(query_h, "method_name", &isnull);
+	if (!isnull)
+		method_name = pstrdup(NameStr(*DatumGetName(d)));
+
+	if (SPI_connect() < 0)
+		elog(ERROR, "SolverAPI: SPI_connect failed");
+
+	/* The resolved solver and method */
+	ExplainPropertyText("Solver", solver_name != NULL ? solver_name : "(not specified)", es);
+	if (solver_name != NULL &&
+		sl_catalog_get_method(solver_name, method_name != NULL ? method_name : "", &m) == SL_Catalog_Found)
+	{
+		ExplainPropertyText("Method", m->method_name, es);
+		ExplainPropertyText("Function", m->func_sql, es);
+	}
+	else
+		ExplainPropertyText("Method", psprintf("%s (not found)", method_name != NULL ? method_name : "default"), es);
+
+	/* The parameters as given by the user */
+	if (!pairs_isnull && ARR_NDIM(DatumGetArrayTypeP(pairs)) == 2)
+	{
+		ArrayType  *array = DatumGetArrayTypeP(pairs);
+		Datum	   *elems;
+		bool	   *nulls;
+		int			numElems;
+		int			i;
+		StringInfoData buf;
+
+		deconstruct_array(array, TEXTOID, -1, false, 'i', &elems, &nulls, &numElems);
+		initStringInfo(&buf);
+		for (i = 0; i + 1 < numElems; i += 2)
+			appendStringInfo(&buf, "%s%s%s%s", i > 0 ? ", " : "",
+							 nulls[i] ? "" : TextDatumGetCString(elems[i]),
+							 nulls[i + 1] ? "" : " := ",
+							 nulls[i + 1] ? "" : TextDatumGetCString(elems[i + 1]));
+		ExplainPropertyText("Parameters", buf.data, es);
+	}
+
+	/* The queries of the problem */
+	d = GetAttributeByName(query_h, "problem", &isnull);
+	if (!isnull)
+	{
+		bool	has_ctes;
+		int		i = 0;
+		ListCell *c;
+
+		problem_h = DatumGetHeapTupleHeader(d);
+
+		d = GetAttributeByName(problem_h, "ctes", &isnull);
+		has_ctes = !isnull && ArrayGetNItems(ARR_NDIM(DatumGetArrayTypeP(d)), ARR_DIMS(DatumGetArrayTypeP(d))) > 0;
+
+		/* The input query can be planned, unless it refers to the relations of the WITH clause */
+		d = GetAttributeByName(problem_h, "input_sql", &isnull);
+		if (!isnull)
+		{
+			char *input_sql = TextDatumGetCString(d);
+
+			sl_explain_query("Input Query", input_sql, has_ctes ? NULL : sl_explain_plan(input_sql, es), es);
+		}
+
+		d = GetAttributeByName(problem_h, "obj_dir", &isnull);
+		if (!isnull)
+			ExplainPropertyText("Objective Direction", DatumGetCString(DirectFunctionCall1(enum_out, d)), es);
+		d = GetAttributeByName(problem_h, "obj_sql", &isnull);
+		if (!isnull)
+			ExplainPropertyText("Objective", TextDatumGetCString(d), es);
+
+		d = GetAttributeByName(problem_h, "ctr_sql", &isnull);
+		if (!isnull)
+			foreach(c, get_datum_array_contents(DatumGetArrayTypeP(d)))
+			{
+				i++;
+				if (lfirst(c) != NULL)
+					ExplainPropertyText(psprintf("Constraint %d", i), TextDatumGetCString((Datum) lfirst(c)), es);
+			}
+	}
+
+	SPI_finish();
+
+	ExplainCloseGroup("Solve", NULL, true, es);
+	FreeExprContext(econtext, true);
+}
+
+/* Shows the queries generated by the solves, the reported model and the phases of the last solve */
+static void sl_explain_analyze(ExplainState * es)
+{
+	SL_Explain		*e = sl_explain();
+	SL_Solve_Report	*report = sl_solve_report();
+	SL_Profile		*profile = sl_solve_profile();
+	ListCell		*c;
+	int				 i;
+
+	foreach(c, e->queries)
+	{
+		SL_Explain_Query *q = (SL_Explain_Query *) lfirst(c);
+
+		sl_explain_query(q->name, q->sql, q->plan, es);
+	}
+
+	if (report->variables >= 0)
+		ExplainPropertyLong("Model Variables", (long) report->variables, es);
+	if (report->constraints >= 0)
+		ExplainPropertyLong("Model Constraints", (long) report->constraints, es);
+	if (report->nonzeros >= 0)
+		ExplainPropertyLong("Model Nonzeros", (long) report->nonzeros, es);
+	if (report->partitions >= 0)
+		ExplainPropertyLong("Model Partitions", (long) report->partitions, es);
+	ExplainPropertyLong("Solver Work Memory Peak", (long) ((sl_work_mem()->peak + 1023) / 1024), es);
+
+	ExplainOpenGroup("Phases", "Phases", false, es);
+	for (i = 0; i < profile->numPhases; i++)
+	{
+		SL_Profile_Phase *phase = &profile->phases[i];
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Phase %s: time=%.3f ms cpu=%.3f ms end_memory=" INT64_FORMAT "kB work_mem=" INT64_FORMAT "kB\n",
+							 phase->name, phase->wall_time, phase->cpu_time, (phase->end_mem + 1023) / 1024,
+							 (phase->work_mem_peak + 1023) / 1024);
+		}
+		else
+		{
+			ExplainOpenGroup("Phase", NULL, true, es);
+			ExplainPropertyText("Name", phase->name, es);
+			ExplainPropertyFloat("Time", phase->wall_time, 3, es);
+			ExplainPropertyFloat("CPU Time", phase->cpu_time, 3, es);
+			ExplainPropertyLong("End Memory", (long) ((phase->end_mem + 1023) / 1024), es);
+			ExplainPropertyLong("Work Memory Peak", (long) ((phase->work_mem_peak + 1023) / 1024), es);
+			ExplainCloseGroup("Phase", NULL, true, es);
+		}
+	}
+	ExplainCloseGroup("Phases", "Phases", false, es);
+}
+
+/* Describes the solves of the explained query */
+static void sl_explain_solves(List * solves, ExplainState * es, ParamListInfo params)
+{
+	ListCell	*c;
+	int			 i = 0;
+
+	ExplainOpenGroup("SolveDB", "SolveDB", true, es);
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoString(es->str, "SolveDB:\n");
+		es->indent++;
+	}
+
+	ExplainOpenGroup("Solves", "Solves", false, es);
+	foreach(c, solves)
+	{
+		if (es->format == EXPLAIN_FORMAT_TEXT && list_length(solves) > 1)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Solve %d:\n", ++i);
+		}
+		sl_explain_solve((FuncExpr *) lfirst(c), es, params);
+	}
+	ExplainCloseGroup("Solves", "Solves", false, es);
+
+	if (es->analyze)
+		sl_explain_analyze(es);
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		es->indent--;
+	ExplainCloseGroup("SolveDB", "SolveDB", true, es);
+}
+
+/* Returns the time elapsed since "starttime", in seconds, and resets "starttime" */
+static double sl_explain_elapsed(instr_time * starttime)
+{
+	instr_time	endtime;
+
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_SUBTRACT(endtime, *starttime);
+	return INSTR_TIME_GET_DOUBLE(endtime);
+}
+
+/*
+ * Explains a planned query with its solves. It follows "ExplainOnePlan", except that the
+ * solves are described inside the "Query" group, which "ExplainOnePlan" closes itself.
+ */
+static void sl_explain_one_plan(PlannedStmt * plannedstmt, IntoClause * into, ExplainState * es,
+								const char * queryString, ParamListInfo params,
+								const instr_time * planduration, List * solves)
+{
+	DestReceiver   *dest;
+	QueryDesc	   *queryDesc;
+	instr_time		starttime;
+	double			totaltime = 0;
+	int				eflags;
+	int				instrument_option = 0;
+
+	if (es->analyze && es->timing)
+		instrument_option |= INSTRUMENT_TIMER;
+	else if (es->analyze)
+		instrument_option |= INSTRUMENT_ROWS;
+	if (es->buffers)
+		instrument_option |= INSTRUMENT_BUFFERS;
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	PushCopiedSnapshot(GetActiveSnapshot());
+	UpdateActiveSnapshotCommandId();
+
+	dest = into ? CreateIntoRelDestReceiver(into) : None_Receiver;
+	queryDesc = CreateQueryDesc(plannedstmt, queryString, GetActiveSnapshot(), InvalidSnapshot,
+								dest, params, instrument_option);
+
+	eflags = es->analyze ? 0 : EXEC_FLAG_EXPLAIN_ONLY;
+	if (into)
+		eflags |= GetIntoRelEFlags(into);
+
+	ExecutorStart(queryDesc, eflags);
+
+	if (es->analyze)
+	{
+		/* The solves capture the queries generated by the view SQL builders */
+		sl_explain_capture_start(es->costs);
+		PG_TRY();
+		{
+			ExecutorRun(queryDesc, (into && into->skipData) ? NoMovementScanDirection : ForwardScanDirection, 0L);
+			ExecutorFinish(queryDesc);
+		}
+		PG_CATCH();
+		{
+			sl_explain_capture_stop();
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+		sl_explain_capture_stop();
+
+		totaltime += sl_explain_elapsed(&starttime);
+	}
+
+	ExplainOpenGroup("Query", NULL, true, es);
+
+	ExplainPrintPlan(es, queryDesc);
+
+	if (es->summary && planduration)
+	{
+		double		plantime = INSTR_TIME_GET_DOUBLE(*planduration);
+
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+			appendStringInfo(es->str, "Planning time: %.3f ms\n", 1000.0 * plantime);
+		else
+			ExplainPropertyFloat("Planning Time", 1000.0 * plantime, 3, es);
+	}
+
+	if (es->analyze)
+		ExplainPrintTriggers(es, queryDesc);
+
+	INSTR_TIME_SET_CURRENT(starttime);
+
+	ExecutorEnd(queryDesc);
+	FreeQueryDesc(queryDesc);
+	PopActiveSnapshot();
+
+	if (es->analyze)
+		CommandCounterIncrement();
+
+	totaltime += sl_explain_elapsed(&starttime);
+
+	if (es->summary)
+	{
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+			appendStringInfo(es->str, "Execution time: %.3f ms\n", 1000.0 * totaltime);
+		else
+			ExplainPropertyFloat("Execution Time", 1000.0 * totaltime, 3, es);
+	}
+
+	/* The section follows the plan of the query */
+	sl_explain_solves(solves, es, params);
+
+	ExplainCloseGroup("Query", NULL, true, es);
+}
+
+/*
+ * Explains a query. A query calling "sl_solve" is planned and explained here (see "ExplainOneQuery"),
+ * unless another module hooks EXPLAIN. In that case, the solves are only described in the text
+ * format, as the other module closes the group of the query.
+ */
+static void sl_explain_one_query(Query * query, IntoClause * into, ExplainState * es,
+								 const char * queryString, ParamListInfo params)
+{
+	List		   *solves = NIL;
+	PlannedStmt	   *plan;
+	instr_time		planstart;
+	instr_time		planduration;
+
+	sl_explain_find_solves((Node *) query, &solves);
+
+	if (prev_ExplainOneQuery)
+	{
+		if (solves != NIL && es->analyze)
+			sl_explain_capture_start(es->costs);
+		PG_TRY();
+		{
+			(*prev_ExplainOneQuery) (query, into, es, queryString, params);
+		}
+		PG_CATCH();
+		{
+			sl_explain_capture_stop();
+			PG_RE_THROW();
+		}
+		PG_END_TRY();
+		sl_explain_capture_stop();
+
+		if (solves != NIL && es->format == EXPLAIN_FORMAT_TEXT)
+			sl_explain_solves(solves, es, params);
+		return;
+	}
+
+	INSTR_TIME_SET_CURRENT(planstart);
+	plan = pg_plan_query(query, into ? 0 : CURSOR_OPT_PARALLEL_OK, params);
+	INSTR_TIME_SET_CURRENT(planduration);
+	INSTR_TIME_SUBTRACT(planduration, planstart);
+
+	if (solves == NIL)
+		ExplainOnePlan(plan, into, es, queryString, params, &planduration);
+	else
+		sl_explain_one_plan(plan, into, es, queryString, params, &planduration, solves);
+}
+
+extern void sl_explain_init(void)
+{
+	prev_ExplainOneQuery = ExplainOneQuery_hook;
+	ExplainOneQuery_hook = sl_explain_one_query;
+}
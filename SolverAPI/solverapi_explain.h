@@ -0,0 +1,16 @@
+/*
+ * solverapi_explain.h
+ *
+ *  EXPLAIN [ANALYZE] support for SOLVESELECT. The solves of an explained query are described
+ *  in a "SolveDB" section following the plan of the query.
+ */
+
+#ifndef SOLVERAPI_EXPLAIN_H_
+#define SOLVERAPI_EXPLAIN_H_
+
+#include "solverapi.h"
+
+/* Installs the EXPLAIN hook. Called once when the module loads. */
+extern void sl_explain_init(void);
+
+#endif /* SOLVERAPI_EXPLAIN_H_ */
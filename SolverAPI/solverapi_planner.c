@@ -0,0 +1,256 @@
+/*
+ * solverapi_planner.c
+ *
+ *  Planner estimates of the solves. A SOLVESELECT is planned as a scan of the "sl_solve" function,
+ *  which the planner estimates with the fixed ROWS and COST of the function. Queries joining the
+ *  solver output to other tables are thus planned as if every solve returned 1000 rows. The hook
+ *  below replaces the estimates of the function scans:
+ *   - "sl_solve" returns a row per row of its input, so the rows are estimated by planning the input
+ *     query of the problem, when it is known at the plan time and does not refer to the relations of
+ *     the WITH clause,
+ *   - a solver function, i.e., a function of "sl_solver_arg" called by "sl_solve", returns a row per
+ *     row of the input relation, whose size is given by the argument.
+ *  The cost of a solve is the cost of the input, plus the cost of an operator per variable and
+ *  constraint, as each constraint query is expected to produce a constraint per input row.
+ *
+ *  The hook is installed when the module loads. To plan a SOLVESELECT as the first statement
+ *  of a session, load the module via "shared_preload_libraries", "session_preload_libraries" or LOAD.
+ */
+
+#include "solverapi_planner.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "optimizer/paths.h"
+#include "optimizer/planner.h"
+#include "optimizer/var.h"
+#include "tcop/tcopprot.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+
+/* The estimate of a solve */
+typedef struct SL_Solve_Estimate
+{
+	double		rows;				/* Rows of the input relation, and of the output */
+	double		variables;			/* Unknown variables */
+	double		constraints;		/* Constraints */
+	Cost		input_cost;			/* The cost of the input query */
+} SL_Solve_Estimate;
+
+/* GUC: estimate the solves */
+static bool sl_solve_estimates = true;
+
+static set_rel_pathlist_hook_type prev_set_rel_pathlist = NULL;
+
+/* Checks if an expression refers to parameters, which are unknown at the plan time */
+static bool sl_planner_contain_params(Node * node, void * context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+		return true;
+
+	return expression_tree_walker(node, sl_planner_contain_params, context);
+}
+
+/* Evaluates an argument of a function scan. Returns false, if it cannot be evaluated at the plan time. */
+static bool sl_planner_eval_arg(Node * arg, ExprContext * econtext, Datum * value, bool * isnull)
+{
+	Expr	   *expr;
+	ExprState  *state;
+
+	if (contain_subplans(arg) || contain_var_clause(arg) || contain_volatile_functions(arg) ||
+		sl_planner_contain_params(arg, NULL))
+		return false;
+
+	expr = expression_planner((Expr *) copyObject(arg));
+	state = ExecInitExpr(expr, NULL);
+	*value = ExecEvalExprSwitchContext(state, econtext, isnull, NULL);
+
+	return true;
+}
+
+/* Gets the number of elements of a one-dimensional array attribute */
+static int sl_planner_array_length(HeapTupleHeader tuple, const char * attname)
+{
+	bool		isnull;
+	Datum		d = GetAttributeByName(tuple, attname, &isnull);
+	ArrayType  *array;
+
+	if (isnull)
+		return 0;
+	array = DatumGetArrayTypeP(d);
+
+	return ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+}
+
+/* Plans a query. Returns false, if the query is not a single SELECT. */
+static bool sl_planner_plan_query(const char * sql, double * rows, Cost * cost)
+{
+	List		   *raw_parsetrees = pg_parse_query(sql);
+	List		   *queries;
+	Query		   *query;
+	PlannedStmt	   *plan;
+
+	if (list_length(raw_parsetrees) != 1)
+		return false;
+	queries = pg_analyze_and_rewrite((Node *) linitial(raw_parsetrees), sql, NULL, 0);
+	if (list_length(queries) != 1)
+		return false;
+	query = (Query *) linitial(queries);
+	if (query->commandType != CMD_SELECT || query->utilityStmt != NULL)
+		return false;
+
+	plan = pg_plan_query(query, 0, NULL);
+	*rows = plan->planTree->plan_rows;
+	*cost = plan->planTree->total_cost;
+
+	return true;
+}
+
+/* Estimates a call of "sl_solve" from its problem. Returns false, if the problem is unknown at the plan time. */
+static bool sl_planner_estimate_solve(FuncExpr * fexpr, RangeTblEntry * rte, SL_Solve_Estimate * est)
+{
+	ExprContext	   *econtext = CreateStandaloneExprContext();
+	Datum			query;
+	bool			isnull;
+	HeapTupleHeader	problem_h;
+	Datum			d;
+	int				numUnknowns;
+	ListCell	   *c;
+
+	if (!sl_planner_eval_arg((Node *) linitial(fexpr->args), econtext, &query, &isnull) || isnull)
+	{
+		FreeExprContext(econtext, true);
+		return false;
+	}
+
+	d = GetAttributeByName(DatumGetHeapTupleHeader(query), "problem", &isnull);
+	if (isnull)
+	{
+		FreeExprContext(econtext, true);
+		return false;
+	}
+	problem_h = DatumGetHeapTupleHeader(d);
+
+	/* The input query cannot be planned alone, if it refers to the relations of the WITH clause */
+	d = GetAttributeByName(problem_h, "input_sql", &isnull);
+	if (isnull || sl_planner_array_length(problem_h, "ctes") > 0 ||
+		!sl_planner_plan_query(TextDatumGetCString(d), &est->rows, &est->input_cost))
+	{
+		FreeExprContext(econtext, true);
+		return false;
+	}
+
+	/* "*" makes every column of the input unknown */
+	numUnknowns = 0;
+	d = GetAttributeByName(problem_h, "cols_unknown", &isnull);
+	if (!isnull)
+		foreach(c, get_datum_array_contents(DatumGetArrayTypeP(d)))
+		{
+			if (lfirst(c) != NULL && strcmp(TextDatumGetCString((Datum) lfirst(c)), "*") == 0)
+			{
+				numUnknowns = list_length(rte->eref->colnames);
+				break;
+			}
+			numUnknowns++;
+		}
+
+	est->variables = est->rows * numUnknowns;
+	est->constraints = est->rows * sl_planner_array_length(problem_h, "ctr_sql");
+
+	FreeExprContext(econtext, true);
+	return true;
+}
+
+/* Estimates a call of a solver function from its argument. Returns false, if it is unknown at the plan time. */
+static bool sl_planner_estimate_solver(FuncExpr * fexpr, SL_Solve_Estimate * est)
+{
+	Node		   *arg = (Node *) linitial(fexpr->args);
+	SL_Solver_Arg  *sarg;
+
+	/* The argument is built by "sl_solve", and is a constant in the custom plan of the solver call */
+	if (!IsA(arg, Const) || ((Const *) arg)->constisnull)
+		return false;
+
+	sarg = DatumGetSLSolverArg(((Const *) arg)->constvalue);
+	est->rows = sarg->prb_rowcount;
+	est->variables = sarg->prb_varcount;
+	est->constraints = (double) sarg->prb_rowcount * list_length(sarg->problem->ctr_sql);
+	est->input_cost = 0;
+
+	return true;
+}
+
+/* Replaces the estimates of the scans of "sl_solve" and of the solver functions */
+static void sl_planner_set_rel_pathlist(PlannerInfo * root, RelOptInfo * rel, Index rti, RangeTblEntry * rte)
+{
+	FuncExpr		   *fexpr;
+	SL_Solve_Estimate	est;
+	bool				estimated = false;
+
+	if (prev_set_rel_pathlist)
+		prev_set_rel_pathlist(root, rel, rti, rte);
+
+	if (!sl_solve_estimates || rte->rtekind != RTE_FUNCTION || list_length(rte->functions) != 1)
+		return;
+
+	fexpr = (FuncExpr *) ((RangeTblFunction *) linitial(rte->functions))->funcexpr;
+	if (fexpr == NULL || !IsA(fexpr, FuncExpr) || !fexpr->funcretset || fexpr->funcresulttype != RECORDOID)
+		return;
+
+	if (list_length(fexpr->args) == 2)
+	{
+		char *fname = get_func_name(fexpr->funcid);
+
+		if (fname != NULL && strcmp(fname, "sl_solve") == 0)
+			estimated = sl_planner_estimate_solve(fexpr, rte, &est);
+	}
+	else if (list_length(fexpr->args) == 1 &&
+			 exprType((Node *) linitial(fexpr->args)) == TypenameGetTypid(SL_PGNAME_Sl_Solver_Arg))
+		estimated = sl_planner_estimate_solver(fexpr, &est);
+
+	if (estimated)
+	{
+		Cost		startup_cost;
+		ListCell   *c;
+
+		/* The output is available when the model is solved */
+		rel->rows = clamp_row_est(est.rows);
+		startup_cost = est.input_cost + cpu_operator_cost * clamp_row_est(est.variables) *
+										clamp_row_est(est.constraints);
+
+		foreach(c, rel->pathlist)
+		{
+			Path *path = (Path *) lfirst(c);
+
+			if (path->param_info != NULL)
+				continue;
+			path->rows = rel->rows;
+			path->startup_cost = startup_cost;
+			path->total_cost = startup_cost + cpu_tuple_cost * rel->rows;
+		}
+	}
+}
+
+extern void sl_planner_init(void)
+{
+	DefineCustomBoolVariable("solvedb.solve_estimates",
+							 "Estimates the rows and the cost of the solves from their problems.",
+							 "When off, the solves are estimated with the ROWS and COST of the functions.",
+							 &sl_solve_estimates,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	prev_set_rel_pathlist = set_rel_pathlist_hook;
+	set_rel_pathlist_hook = sl_planner_set_rel_pathlist;
+}
@@ -0,0 +1,16 @@
+/*
+ * solverapi_planner.h
+ *
+ *  Planner estimates of the solves. The rows and the cost of the "sl_solve" function and of the
+ *  solver functions are estimated from the problem, instead of the fixed ROWS and COST of the functions.
+ */
+
+#ifndef SOLVERAPI_PLANNER_H_
+#define SOLVERAPI_PLANNER_H_
+
+#include "solverapi.h"
+
+/* Installs the planner hook. Called once when the module loads. */
+extern void sl_planner_init(void);
+
+#endif /* SOLVERAPI_PLANNER_H_ */
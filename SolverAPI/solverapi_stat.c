@@ -0,0 +1,595 @@
+/*
+ * solverapi_stat.c
+ *
+ *  Cluster-wide cumulative statistics of the solves. The native SOLVE function measures each
+ *  solve (see "SL_Stat_Solve") and accumulates the measures in a shared hash table keyed by
+ *  the user, the database, the solver, the method and the fingerprint of the problem. The
+ *  statistics are exposed through the "sl_stat_solves" view, and are lost on a server restart.
+ *
+ *  The hash table is protected by a lock: it is held shared to look up and update an entry
+ *  (the counters of an entry are protected by its spinlock), and exclusive to add or remove
+ *  entries. When the table is full, the entries with the fewest calls are evicted in bulk, as in
+ *  pg_stat_statements, so that a scan of the table is paid once per many new entries.
+ *
+ *  The solves processed by the PL/pgSQL fallback (solvedb.native_solve = off) are not measured.
+ */
+
+#include "solverapi_stat.h"
+#include <limits.h>
+#include <math.h>
+#include <ctype.h>
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/tuplestore.h"
+
+#define SL_STAT_TRANCHE		"solverapi"
+#define SL_STAT_COLS		31
+#define SL_STAT_DEALLOC_PERCENT	5	/* The percentage of the entries evicted when the table is full */
+
+/* A key of the statistics. Must be zeroed before filling it, as it is hashed as a blob. */
+typedef struct SL_Stat_Key
+{
+	Oid			userid;			/* A user who run the solve */
+	Oid			dbid;			/* A database the solve was run in */
+	NameData	solver_name;
+	NameData	method_name;
+	uint32		fingerprint;	/* See "sl_stat_fingerprint" */
+} SL_Stat_Key;
+
+/* Timing statistics of a phase */
+typedef struct SL_Stat_Timing
+{
+	double		total;
+	double		min;
+	double		max;
+	double		mean;
+	double		sum_var;		/* A sum of squared differences from the mean (Welford's method) */
+} SL_Stat_Timing;
+
+typedef struct SL_Stat_Counters
+{
+	int64			calls;
+	SL_Stat_Timing	time[SL_StatPhase_Count];
+	int64			rows_in;
+	int64			variables;
+	int64			constraints;
+	int64			nonzeros;
+	int64			partitions;
+} SL_Stat_Counters;
+
+typedef struct SL_Stat_Entry
+{
+	SL_Stat_Key			key;		/* Hash key, must be the first */
+	SL_Stat_Counters	counters;
+	slock_t				mutex;		/* Protects the counters */
+} SL_Stat_Entry;
+
+typedef struct SL_Stat_Shared
+{
+	LWLock		   *lock;			/* Protects the hash table */
+} SL_Stat_Shared;
+
+/* GUCs */
+static int	sl_stat_max = 1000;
+static bool sl_track_solves = true;
+
+/* Shared state, set up only when loaded via "shared_preload_libraries" */
+static SL_Stat_Shared *sl_stat_shared = NULL;
+static HTAB *sl_stat_htab = NULL;
+
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static Size sl_stat_memsize(void)
+{
+	return add_size(MAXALIGN(sizeof(SL_Stat_Shared)), hash_estimate_size(sl_stat_max, sizeof(SL_Stat_Entry)));
+}
+
+static void sl_stat_shmem_startup(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	sl_stat_shared = ShmemInitStruct("SolverAPI solve statistics", sizeof(SL_Stat_Shared), &found);
+	if (!found)
+		sl_stat_shared->lock = &(GetNamedLWLockTranche(SL_STAT_TRANCHE))->lock;
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(SL_Stat_Key);
+	info.entrysize = sizeof(SL_Stat_Entry);
+	sl_stat_htab = ShmemInitHash("SolverAPI solve statistics hash", sl_stat_max, sl_stat_max,
+								 &info, HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+extern void sl_stat_init(void)
+{
+	DefineCustomBoolVariable("solvedb.track_solves",
+							 "Collects the cumulative statistics of the solves.",
+							 "The statistics are collected only when SolverAPI is loaded via shared_preload_libraries.",
+							 &sl_track_solves,
+							 true,
+							 PGC_SUSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomIntVariable("solvedb.stat_max",
+							"Sets the maximum number of the solve statistics entries.",
+							NULL,
+							&sl_stat_max,
+							1000,
+							100,
+							INT_MAX,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+	RequestAddinShmemSpace(sl_stat_memsize());
+	RequestNamedLWLockTranche(SL_STAT_TRANCHE, 1);
+
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = sl_stat_shmem_startup;
+}
+
+extern bool sl_stat_enabled(void)
+{
+	return sl_stat_shared != NULL && sl_track_solves;
+}
+
+/*
+ * Appends a normalized SQL statement: the constants are replaced by "?", the white-spaces and comments
+ * are collapsed into a single space, and the unquoted identifiers and keywords are lower-cased.
+ */
+static void sl_stat_normalize(StringInfo buf, const char * sql)
+{
+	const char *p = sql;
+	bool		space = false;
+
+	while (*p != '\0')
+	{
+		if (isspace((unsigned char) *p))
+		{
+			space = true;
+			p++;
+			continue;
+		}
+		if (p[0] == '-' && p[1] == '-')
+		{
+			while (*p != '\0' && *p != '\n')
+				p++;
+			space = true;
+			continue;
+		}
+
+		if (space && buf->len > 0)
+			appendStringInfoChar(buf, ' ');
+		space = false;
+
+		if (*p == '\'')
+		{
+			/* A string literal, where '' stands for a quote */
+			for (p++; *p != '\0'; p++)
+				if (*p == '\'' && *(++p) != '\'')
+					break;
+			appendStringInfoChar(buf, '?');
+		}
+		else if (*p == '"')
+		{
+			/* A quoted identifier is kept as is */
+			const char *start = p;
+
+			for (p++; *p != '\0'; p++)
+				if (*p == '"' && *(++p) != '"')
+					break;
+			appendBinaryStringInfo(buf, start, p - start);
+		}
+		else if (isdigit((unsigned char) *p) || (*p == '.' && isdigit((unsigned char) p[1])))
+		{
+			/* A numeric literal */
+			while (isdigit((unsigned char) *p) || *p == '.')
+				p++;
+			if ((*p == 'e' || *p == 'E') &&
+				(isdigit((unsigned char) p[1]) || ((p[1] == '+' || p[1] == '-') && isdigit((unsigned char) p[2]))))
+				for (p += 2; isdigit((unsigned char) *p); p++)
+					;
+			appendStringInfoChar(buf, '?');
+		}
+		else if (isalpha((unsigned char) *p) || *p == '_' || IS_HIGHBIT_SET(*p))
+		{
+			/* An identifier or a keyword */
+			while (isalnum((unsigned char) *p) || *p == '_' || *p == '$' || IS_HIGHBIT_SET(*p))
+				appendStringInfoChar(buf, pg_tolower((unsigned char) *(p++)));
+		}
+		else
+			appendStringInfoChar(buf, *(p++));
+	}
+}
+
+/* Appends the normalized elements of a text or name array */
+static void sl_stat_normalize_array(StringInfo buf, Datum array, Oid elemtype)
+{
+	Datum	   *elems;
+	bool	   *nulls;
+	int			numElems;
+	int			i;
+
+	if (elemtype == NAMEOID)
+		deconstruct_array(DatumGetArrayTypeP(array), NAMEOID, NAMEDATALEN, false, 'c', &elems, &nulls, &numElems);
+	else
+		deconstruct_array(DatumGetArrayTypeP(array), TEXTOID, -1, false, 'i', &elems, &nulls, &numElems);
+
+	for (i = 0; i < numElems; i++)
+	{
+		appendStringInfoChar(buf, ',');
+		if (!nulls[i])
+			sl_stat_normalize(buf, elemtype == NAMEOID ? NameStr(*DatumGetName(elems[i])) : TextDatumGetCString(elems[i]));
+	}
+}
+
+extern uint32 sl_stat_fingerprint(HeapTupleHeader problem)
+{
+	StringInfoData	buf;
+	Datum			d;
+	bool			isnull;
+	uint32			fingerprint;
+
+	initStringInfo(&buf);
+
+	d = GetAttributeByName(problem, "input_sql", &isnull);
+	if (!isnull)
+		sl_stat_normalize(&buf, TextDatumGetCString(d));
+	appendStringInfoChar(&buf, '\n');
+	d = GetAttributeByName(problem, "cols_unknown", &isnull);
+	if (!isnull)
+		sl_stat_normalize_array(&buf, d, NAMEOID);
+	appendStringInfoChar(&buf, '\n');
+	d = GetAttributeByName(problem, "obj_dir", &isnull);
+	if (!isnull)
+		appendStringInfo(&buf, "%u", DatumGetObjectId(d));
+	appendStringInfoChar(&buf, '\n');
+	d = GetAttributeByName(problem, "obj_sql", &isnull);
+	if (!isnull)
+		sl_stat_normalize(&buf, TextDatumGetCString(d));
+	appendStringInfoChar(&buf, '\n');
+	d = GetAttributeByName(problem, "ctr_sql", &isnull);
+	if (!isnull)
+		sl_stat_normalize_array(&buf, d, TEXTOID);
+	appendStringInfoChar(&buf, '\n');
+	d = GetAttributeByName(problem, "ctes", &isnull);
+	if (!isnull)
+	{
+		ListCell   *c;
+
+		foreach(c, get_datum_array_contents(DatumGetArrayTypeP(d)))
+		{
+			bool cte_isnull;
+
+			if (lfirst(c) == NULL)
+				continue;
+			d = GetAttributeByName(DatumGetHeapTupleHeader((Datum) lfirst(c)), "input_sql", &cte_isnull);
+			appendStringInfoChar(&buf, ',');
+			if (!cte_isnull)
+				sl_stat_normalize(&buf, TextDatumGetCString(d));
+		}
+	}
+
+	fingerprint = DatumGetUInt32(hash_any((unsigned char *) buf.data, buf.len));
+	pfree(buf.data);
+
+	return fingerprint;
+}
+
+/* Orders the entries by the number of calls */
+static int sl_stat_entry_cmp(const void * lhs, const void * rhs)
+{
+	int64	l = (*(SL_Stat_Entry * const *) lhs)->counters.calls;
+	int64	r = (*(SL_Stat_Entry * const *) rhs)->counters.calls;
+
+	return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+/*
+ * Evicts SL_STAT_DEALLOC_PERCENT of the entries (at least 10) with the fewest calls. The lock must be held
+ * exclusive, thus the counters are not updated concurrently.
+ */
+static void sl_stat_entry_dealloc(void)
+{
+	HASH_SEQ_STATUS	hash_seq;
+	SL_Stat_Entry **entries;
+	SL_Stat_Entry  *entry;
+	int				numEntries = 0;
+	int				numVictims;
+	int				i;
+
+	entries = palloc(hash_get_num_entries(sl_stat_htab) * sizeof(SL_Stat_Entry *));
+
+	hash_seq_init(&hash_seq, sl_stat_htab);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		entries[numEntries++] = entry;
+
+	qsort(entries, numEntries, sizeof(SL_Stat_Entry *), sl_stat_entry_cmp);
+
+	numVictims = Min(Max(10, numEntries * SL_STAT_DEALLOC_PERCENT / 100), numEntries);
+	for (i = 0; i < numVictims; i++)
+		hash_search(sl_stat_htab, &entries[i]->key, HASH_REMOVE, NULL);
+
+	pfree(entries);
+}
+
+/* Adds an entry, evicting the entries with the fewest calls if the table is full. The lock must be held exclusive. */
+static SL_Stat_Entry * sl_stat_entry_alloc(SL_Stat_Key * key)
+{
+	SL_Stat_Entry  *entry;
+	bool			found;
+
+	if (hash_get_num_entries(sl_stat_htab) >= sl_stat_max &&
+		hash_search(sl_stat_htab, key, HASH_FIND, NULL) == NULL)
+		sl_stat_entry_dealloc();
+
+	entry = (SL_Stat_Entry *) hash_search(sl_stat_htab, key, HASH_ENTER, &found);
+	if (!found)
+	{
+		memset(&entry->counters, 0, sizeof(SL_Stat_Counters));
+		SpinLockInit(&entry->mutex);
+	}
+
+	return entry;
+}
+
+extern void sl_stat_store(const char * solver_name, const char * method_name, uint32 fingerprint,
+						  const SL_Stat_Solve * solve)
+{
+	SL_Stat_Key		key;
+	SL_Stat_Entry  *entry;
+	int				i;
+
+	if (!sl_stat_enabled())
+		return;
+
+	memset(&key, 0, sizeof(key));
+	key.userid = GetUserId();
+	key.dbid = MyDatabaseId;
+	namestrcpy(&key.solver_name, solver_name);
+	namestrcpy(&key.method_name, method_name != NULL ? method_name : "");
+	key.fingerprint = fingerprint;
+
+	LWLockAcquire(sl_stat_shared->lock, LW_SHARED);
+
+	entry = (SL_Stat_Entry *) hash_search(sl_stat_htab, &key, HASH_FIND, NULL);
+	if (entry == NULL)
+	{
+		/* Re-acquire the lock exclusive to add the entry */
+		LWLockRelease(sl_stat_shared->lock);
+		LWLockAcquire(sl_stat_shared->lock, LW_EXCLUSIVE);
+		entry = sl_stat_entry_alloc(&key);
+	}
+
+	{
+		volatile SL_Stat_Entry *e = entry;
+
+		SpinLockAcquire(&e->mutex);
+
+		e->counters.calls += 1;
+		for (i = 0; i < SL_StatPhase_Count; i++)
+		{
+			volatile SL_Stat_Timing *t = &e->counters.time[i];
+			double					 old_mean = t->mean;
+
+			if (e->counters.calls == 1)
+			{
+				t->min = solve->time[i];
+				t->max = solve->time[i];
+			}
+			else
+			{
+				if (t->min > solve->time[i])
+					t->min = solve->time[i];
+				if (t->max < solve->time[i])
+					t->max = solve->time[i];
+			}
+			t->total += solve->time[i];
+			t->mean += (solve->time[i] - old_mean) / e->counters.calls;
+			t->sum_var += (solve->time[i] - old_mean) * (solve->time[i] - t->mean);
+		}
+		e->counters.rows_in += solve->rows_in;
+		e->counters.variables += solve->variables;
+		e->counters.constraints += solve->constraints;
+		e->counters.nonzeros += solve->nonzeros;
+		e->counters.partitions += solve->partitions;
+
+		SpinLockRelease(&e->mutex);
+	}
+
+	LWLockRelease(sl_stat_shared->lock);
+}
+
+static void sl_stat_check_shared(void)
+{
+	if (sl_stat_shared == NULL || sl_stat_htab == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("SolverAPI must be loaded via shared_preload_libraries to collect the solve statistics")));
+}
+
+/* Outputs the solve statistics */
+PG_FUNCTION_INFO_V1(sl_stat_solves);
+Datum sl_stat_solves(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate	   *tupstore;
+	TupleDesc			tupdesc;
+	MemoryContext		oldcontext;
+	HASH_SEQ_STATUS		hash_seq;
+	SL_Stat_Entry	   *entry;
+
+	sl_stat_check_shared();
+
+	/* Check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "SolverAPI: return type must be a row type");
+	if (tupdesc->natts != SL_STAT_COLS)
+		elog(ERROR, "SolverAPI: incorrect number of output arguments");
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupdesc = CreateTupleDescCopy(tupdesc);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+
+	LWLockAcquire(sl_stat_shared->lock, LW_SHARED);
+
+	hash_seq_init(&hash_seq, sl_stat_htab);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+	{
+		Datum				values[SL_STAT_COLS];
+		bool				nulls[SL_STAT_COLS];
+		SL_Stat_Counters	tmp;
+		int					i = 0;
+		int					p;
+
+		/* Copy the counters, as they may be updated concurrently */
+		{
+			volatile SL_Stat_Entry *e = entry;
+
+			SpinLockAcquire(&e->mutex);
+			tmp = e->counters;
+			SpinLockRelease(&e->mutex);
+		}
+
+		memset(nulls, false, sizeof(nulls));
+		values[i++] = ObjectIdGetDatum(entry->key.userid);
+		values[i++] = ObjectIdGetDatum(entry->key.dbid);
+		values[i++] = NameGetDatum(&entry->key.solver_name);
+		values[i++] = NameGetDatum(&entry->key.method_name);
+		values[i++] = Int64GetDatum((int64) entry->key.fingerprint);
+		values[i++] = Int64GetDatum(tmp.calls);
+		for (p = 0; p < SL_StatPhase_Count; p++)
+		{
+			values[i++] = Float8GetDatum(tmp.time[p].total);
+			values[i++] = Float8GetDatum(tmp.time[p].min);
+			values[i++] = Float8GetDatum(tmp.time[p].max);
+			values[i++] = Float8GetDatum(tmp.time[p].mean);
+			values[i++] = Float8GetDatum(tmp.calls > 1 ? sqrt(tmp.time[p].sum_var / tmp.calls) : 0.0);
+		}
+		values[i++] = Int64GetDatum(tmp.rows_in);
+		values[i++] = Int64GetDatum(tmp.variables);
+		values[i++] = Int64GetDatum(tmp.constraints);
+		values[i++] = Int64GetDatum(tmp.nonzeros);
+		values[i++] = Int64GetDatum(tmp.partitions);
+		Assert(i == SL_STAT_COLS);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	LWLockRelease(sl_stat_shared->lock);
+
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
+/* Discards all solve statistics */
+PG_FUNCTION_INFO_V1(sl_stat_solves_reset);
+Datum sl_stat_solves_reset(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS		hash_seq;
+	SL_Stat_Entry	   *entry;
+
+	sl_stat_check_shared();
+
+	LWLockAcquire(sl_stat_shared->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&hash_seq, sl_stat_htab);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
+		hash_search(sl_stat_htab, &entry->key, HASH_REMOVE, NULL);
+
+	LWLockRelease(sl_stat_shared->lock);
+
+	PG_RETURN_VOID();
+}
+
+/* Outputs the phases of the most recent solve of the session */
+PG_FUNCTION_INFO_V1(sl_last_solve_profile);
+Datum sl_last_solve_profile(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo	   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Tuplestorestate	   *tupstore;
+	TupleDesc			tupdesc;
+	MemoryContext		oldcontext;
+	SL_Profile		   *profile = sl_solve_profile();
+	int					i;
+
+	/* Check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "SolverAPI: return type must be a row type");
+
+	oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupdesc = CreateTupleDescCopy(tupdesc);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	MemoryContextSwitchTo(oldcontext);
+
+	for (i = 0; i < profile->numPhases; i++)
+	{
+		SL_Profile_Phase   *phase = &profile->phases[i];
+		Datum				values[6];
+		bool				nulls[6] = {false, false, false, false, false, false};
+
+		values[0] = Int32GetDatum(i + 1);
+		values[1] = CStringGetTextDatum(phase->name);
+		values[2] = Float8GetDatum(phase->wall_time);
+		values[3] = Float8GetDatum(phase->cpu_time);
+		values[4] = Int64GetDatum(phase->end_mem);
+		values[5] = Int64GetDatum(phase->work_mem_peak);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
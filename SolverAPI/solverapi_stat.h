@@ -0,0 +1,48 @@
+/*
+ * solverapi_stat.h
+ *
+ *  Cluster-wide cumulative statistics of the solves, kept in shared memory. The statistics are
+ *  collected only when SolverAPI is loaded via "shared_preload_libraries".
+ */
+
+#ifndef SOLVERAPI_STAT_H_
+#define SOLVERAPI_STAT_H_
+
+#include "solverapi.h"
+
+/* Phases of a solve, timed separately */
+typedef enum { SL_StatPhase_Input = 0,	/* Materializing the input relation */
+			   SL_StatPhase_Model,		/* Building the model, as reported by the solver */
+			   SL_StatPhase_Solve,		/* The rest of the solver call, i.e., solving and returning the output */
+			   SL_StatPhase_Total,		/* The whole solve */
+			   SL_StatPhase_Count
+			 } SL_Stat_Phase;
+
+/* Measures of a single solve */
+typedef struct SL_Stat_Solve
+{
+	double		time[SL_StatPhase_Count];	/* Time spent in each phase, in milliseconds */
+	int64		rows_in;					/* A number of rows in the input relation */
+	int64		variables;					/* A number of variables */
+	int64		constraints;				/* A number of constraints, or 0 if not reported by the solver */
+	int64		nonzeros;					/* A number of non-zero constraint coefficients, or 0 if not reported */
+	int64		partitions;					/* A number of partitions, or 0 if not reported */
+} SL_Stat_Solve;
+
+/* Defines the settings and requests the shared memory. Called once when the module loads. */
+extern void sl_stat_init(void);
+/* Checks if the solves are tracked, i.e., the shared memory is set up and "solvedb.track_solves" is on */
+extern bool sl_stat_enabled(void);
+/* Computes a fingerprint of the problem, which ignores the constants, the letter case and the white-spaces
+ * of its SQL statements. Thus, the solves of the same problem with different data share the fingerprint. */
+extern uint32 sl_stat_fingerprint(HeapTupleHeader problem);
+/* Accumulates the measures of a solve */
+extern void sl_stat_store(const char * solver_name, const char * method_name, uint32 fingerprint,
+						  const SL_Stat_Solve * solve);
+
+/* SQL interface */
+extern Datum sl_stat_solves(PG_FUNCTION_ARGS);
+extern Datum sl_stat_solves_reset(PG_FUNCTION_ARGS);
+extern Datum sl_last_solve_profile(PG_FUNCTION_ARGS);
+
+#endif /* SOLVERAPI_STAT_H_ */
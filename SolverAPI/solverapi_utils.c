@@ -14,12 +14,122 @@
 #include "nodes/nodes.h"
 #include "utils/syscache.h"
 #include "catalog/namespace.h"
+#include "optimizer/planmain.h"
+#include "access/hash.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+
+/*
+ * A per-transaction cache of the analyzed queries. The key is "<search_path>\n<sql>". The cache and its
+ * counters are per module, as each solver module links its own copy of this library.
+ */
+typedef struct SL_Query_Cache_Entry
+{
+	char				*key;			/* Hash key, must be the first */
+	SL_Attribute_Desc	*attrs;			/* Attributes of the query */
+	unsigned int		 numAttrs;
+	List				*relationOids;	/* Relations the query depends on */
+} SL_Query_Cache_Entry;
+
+static HTAB 				 *sl_qcache = NULL;
+static MemoryContext		  sl_qcache_context = NULL;
+static MemoryContextCallback  sl_qcache_reset_cb;
+static bool					  sl_qcache_callbacks = false;
+static uint64				  sl_qcache_hits = 0;
+static uint64				  sl_qcache_misses = 0;
+
+static uint32 sl_qcache_hash(const void * key, Size keysize)
+{
+	const char * s = *((char * const *) key);
+
+	return DatumGetUInt32(hash_any((const unsigned char *) s, strlen(s)));
+}
+
+static int sl_qcache_match(const void * key1, const void * key2, Size keysize)
+{
+	return strcmp(*((char * const *) key1), *((char * const *) key2));
+}
+
+/* The cache goes away with the transaction */
+static void sl_qcache_reset(void * arg)
+{
+	sl_qcache = NULL;
+	sl_qcache_context = NULL;
+}
+
+/* Drops the queries depending on the relation "relid" (or all queries, if relid is InvalidOid) */
+static void sl_qcache_relcache_callback(Datum arg, Oid relid)
+{
+	HASH_SEQ_STATUS 		 status;
+	SL_Query_Cache_Entry	*entry;
+
+	if (sl_qcache == NULL)
+		return;
+
+	hash_seq_init(&status, sl_qcache);
+	while ((entry = (SL_Query_Cache_Entry *) hash_seq_search(&status)) != NULL)
+		if (relid == InvalidOid || list_member_oid(entry->relationOids, relid))
+			hash_search(sl_qcache, &entry->key, HASH_REMOVE, NULL);
+}
+
+/* Types and functions used by the queries may change, thus all queries are dropped */
+static void sl_qcache_syscache_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	sl_qcache_relcache_callback(arg, InvalidOid);
+}
+
+static void sl_qcache_init(void)
+{
+	HASHCTL ctl;
+
+	if (!sl_qcache_callbacks)
+	{
+		CacheRegisterRelcacheCallback(sl_qcache_relcache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(TYPEOID, sl_qcache_syscache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PROCOID, sl_qcache_syscache_callback, (Datum) 0);
+		sl_qcache_callbacks = true;
+	}
+
+	sl_qcache_context = AllocSetContextCreate(TopTransactionContext,
+											  "SolverAPI query cache",
+											  ALLOCSET_DEFAULT_MINSIZE,
+											  ALLOCSET_DEFAULT_INITSIZE,
+											  ALLOCSET_DEFAULT_MAXSIZE);
+	sl_qcache_reset_cb.func = sl_qcache_reset;
+	sl_qcache_reset_cb.arg = NULL;
+	MemoryContextRegisterResetCallback(sl_qcache_context, &sl_qcache_reset_cb);
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(char *);
+	ctl.entrysize = sizeof(SL_Query_Cache_Entry);
+	ctl.hash = sl_qcache_hash;
+	ctl.match = sl_qcache_match;
+	ctl.hcxt = sl_qcache_context;
+	sl_qcache = hash_create("SolverAPI analyzed queries", 64, &ctl,
+							HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+}
+
+/* Copies an attribute list into the current memory context */
+static SL_Attribute_Desc * sl_copy_attributes(SL_Attribute_Desc * attrs, unsigned int numAttrs)
+{
+	SL_Attribute_Desc	*result = palloc(sizeof(SL_Attribute_Desc) * (numAttrs + 1));
+	unsigned int		 i;
+
+	for (i = 0; i < numAttrs; i++)
+	{
+		result[i].att_name = pstrdup(attrs[i].att_name);
+		result[i].att_type = pstrdup(attrs[i].att_type);
+		result[i].att_kind = attrs[i].att_kind;
+	}
+	return result;
+}
 
 /*
  * We call the parsing and analysis directly. Alternative less efficient implementation is to
- * to SPI_Execute and then analyze the HEAPTUPLE.
+ * to SPI_Execute and then analyze the HEAPTUPLE. The OIDs of the relations the query depends on
+ * are returned in "relationOids".
  * */
-extern SL_Attribute_Desc * sl_get_query_attributes(char * sql, unsigned int * numAttrs)
+static SL_Attribute_Desc * sl_analyze_query_attributes(char * sql, unsigned int * numAttrs, List ** relationOids)
 {
 	SL_Attribute_Desc	*result=NULL;
 	MemoryContext 		 oldcontext;
@@ -61,6 +171,17 @@ extern SL_Attribute_Desc * sl_get_query_attributes(char * sql, unsigned int * nu
 	Assert(query->utilityStmt == NULL);
 	/* Prepare a target list */
 	MemoryContextSwitchTo(oldcontext);
+	if (relationOids != NULL)
+	{
+		List	*invalItems;
+		List	*oids;
+		bool	 hasRowSecurity;
+
+		MemoryContextSwitchTo(parsecontext);
+		extract_query_dependencies((Node *) stmt_list, &oids, &invalItems, &hasRowSecurity);
+		MemoryContextSwitchTo(oldcontext);
+		*relationOids = list_copy(oids);
+	}
 	// Count non-junk attributes
 	*numAttrs = 0;
 	foreach(c, query->targetList)
@@ -89,3 +210,59 @@ extern SL_Attribute_Desc * sl_get_query_attributes(char * sql, unsigned int * nu
 	return result;
 }
 
+
+/*
+ * Gets the attributes of the query "sql". The analysis is cached for the duration of the transaction,
+ * separately for each "search_path". The result is allocated in the current memory context.
+ */
+extern SL_Attribute_Desc * sl_get_query_attributes(char * sql, unsigned int * numAttrs)
+{
+	SL_Query_Cache_Entry	*entry;
+	SL_Attribute_Desc		*attrs;
+	List					*relationOids;
+	char					*key;
+	bool					 found;
+	MemoryContext			 oldcontext;
+
+	if (sl_qcache == NULL)
+		sl_qcache_init();
+
+	key = psprintf("%s\n%s", namespace_search_path == NULL ? "" : namespace_search_path, sql);
+	entry = (SL_Query_Cache_Entry *) hash_search(sl_qcache, &key, HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		sl_qcache_hits++;
+		pfree(key);
+		*numAttrs = entry->numAttrs;
+		return sl_copy_attributes(entry->attrs, entry->numAttrs);
+	}
+
+	sl_qcache_misses++;
+	attrs = sl_analyze_query_attributes(sql, numAttrs, &relationOids);
+
+	/* The analysis may have processed invalidations, which could have dropped the cache */
+	if (sl_qcache == NULL)
+		sl_qcache_init();
+
+	entry = (SL_Query_Cache_Entry *) hash_search(sl_qcache, &key, HASH_ENTER, &found);
+	if (!found)
+	{
+		oldcontext = MemoryContextSwitchTo(sl_qcache_context);
+		entry->key = pstrdup(key);
+		entry->attrs = sl_copy_attributes(attrs, *numAttrs);
+		entry->numAttrs = *numAttrs;
+		entry->relationOids = list_copy(relationOids);
+		MemoryContextSwitchTo(oldcontext);
+	}
+	pfree(key);
+
+	return attrs;
+}
+
+/* Gets the hit and miss counters of the query cache (cumulative for the backend), and the number of cached queries */
+extern void sl_get_query_cache_stats(uint64 * hits, uint64 * misses, long * entries)
+{
+	*hits = sl_qcache_hits;
+	*misses = sl_qcache_misses;
+	*entries = sl_qcache == NULL ? 0 : hash_get_num_entries(sl_qcache);
+}
@@ -11,5 +11,6 @@
 #include "solverapi.h"
 
 extern SL_Attribute_Desc * sl_get_query_attributes(char * sql, unsigned int * numAttrs);
+extern void sl_get_query_cache_stats(uint64 * hits, uint64 * misses, long * entries);
 
 #endif /* SOLVERAPI_UTILS_H_ */
@@ -0,0 +1,53 @@
+-- Checks that the cached solver methods follow the changes of the method functions and of the search_path
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+RESET client_min_messages;
+
+CREATE FUNCTION cc_solve(arg sl_solver_arg) RETURNS setof record AS $$
+BEGIN
+  RAISE NOTICE 'cc_solve: version 1';
+  RETURN QUERY EXECUTE sl_return(arg, sl_build_out(arg));
+END;
+$$ LANGUAGE plpgsql VOLATILE STRICT;
+
+WITH solver AS (INSERT INTO sl_solver(name) VALUES ('cc_solver') RETURNING sid)
+INSERT INTO sl_solver_method(sid, name, func_name) SELECT sid, 'cc_method', 'cc_solve' FROM solver;
+
+SELECT id, x IS NULL AS x_is_null FROM (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t USING cc_solver.cc_method) AS s;
+
+-- CREATE OR REPLACE keeps the function
+CREATE OR REPLACE FUNCTION cc_solve(arg sl_solver_arg) RETURNS setof record AS $$
+BEGIN
+  RAISE NOTICE 'cc_solve: version 2';
+  RETURN QUERY EXECUTE sl_return(arg, sl_build_out(arg));
+END;
+$$ LANGUAGE plpgsql VOLATILE STRICT;
+SELECT id, x IS NULL AS x_is_null FROM (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t USING cc_solver.cc_method) AS s;
+
+-- A function created again after DROP is another function
+DROP FUNCTION cc_solve(sl_solver_arg);
+CREATE FUNCTION cc_solve(arg sl_solver_arg) RETURNS setof record AS $$
+BEGIN
+  RAISE NOTICE 'cc_solve: version 3';
+  RETURN QUERY EXECUTE sl_return(arg, sl_build_out(arg));
+END;
+$$ LANGUAGE plpgsql VOLATILE STRICT;
+SELECT id, x IS NULL AS x_is_null FROM (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t USING cc_solver.cc_method) AS s;
+
+-- A function of a schema earlier in the search_path takes over
+CREATE SCHEMA cc;
+CREATE FUNCTION cc.cc_solve(arg sl_solver_arg) RETURNS setof record AS $$
+BEGIN
+  RAISE NOTICE 'cc.cc_solve';
+  RETURN QUERY EXECUTE sl_return(arg, sl_build_out(arg));
+END;
+$$ LANGUAGE plpgsql VOLATILE STRICT;
+SET search_path = cc, public;
+SELECT id, x IS NULL AS x_is_null FROM (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t USING cc_solver.cc_method) AS s;
+RESET search_path;
+SELECT id, x IS NULL AS x_is_null FROM (SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t USING cc_solver.cc_method) AS s;
+
+DROP FUNCTION cc.cc_solve(sl_solver_arg);
+DROP SCHEMA cc;
+DELETE FROM sl_solver WHERE name = 'cc_solver';
+DROP FUNCTION cc_solve(sl_solver_arg);
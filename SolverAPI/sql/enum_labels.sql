@@ -0,0 +1,22 @@
+-- Checks the conversions of all labels of the SolverAPI enum types to C values and back
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+RESET client_min_messages;
+
+SELECT u.type, u.label::text AS label, u.ok
+FROM (SELECT 'sl_attribute_kind' AS type, l::text AS label, sl_enum_roundtrip(l) = l AS ok, n
+      FROM unnest(enum_range(NULL::sl_attribute_kind)) WITH ORDINALITY AS e(l, n)
+      UNION ALL
+      SELECT 'sl_obj_dir', l::text, sl_enum_roundtrip(l) = l, n
+      FROM unnest(enum_range(NULL::sl_obj_dir)) WITH ORDINALITY AS e(l, n)
+      UNION ALL
+      SELECT 'sl_ctr_type', l::text, sl_enum_roundtrip(l) = l, n
+      FROM unnest(enum_range(NULL::sl_ctr_type)) WITH ORDINALITY AS e(l, n)) AS u
+ORDER BY u.type, u.n;
+
+-- The constraint operators are converted when building and reading constraints
+SELECT op, sl_ctr_get_op(sl_ctr_make(1, op, sl_unkvar_make(1))) = op AS ok
+FROM unnest(enum_range(NULL::sl_ctr_type)) AS op;
+
+-- Values of other enum types are rejected
+SELECT sl_enum_roundtrip('int'::sl_parameter_type);
@@ -0,0 +1,32 @@
+-- Checks the per-transaction cache of the analyzed queries: the hits, the misses, and the invalidation
+-- after DDL on a relation of a cached query. The counters are those of the solverapi module.
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+RESET client_min_messages;
+
+CREATE TABLE qc_input (id int, x float8);
+
+BEGIN;
+SELECT hits AS base_hits, misses AS base_misses FROM sl_get_query_cache_stats() \gset
+
+-- A miss, then a hit
+SELECT att_name, att_type FROM sl_get_attributes_from_sql('SELECT id, x FROM qc_input');
+SELECT att_name, att_type FROM sl_get_attributes_from_sql('SELECT id, x FROM qc_input');
+SELECT hits - :base_hits AS hits, misses - :base_misses AS misses, entries FROM sl_get_query_cache_stats();
+
+-- Another search_path is another entry
+SET LOCAL search_path = pg_catalog, public;
+SELECT att_name, att_type FROM sl_get_attributes_from_sql('SELECT id, x FROM qc_input');
+SELECT hits - :base_hits AS hits, misses - :base_misses AS misses, entries FROM sl_get_query_cache_stats();
+
+-- DDL on the input relation drops the entries of the queries reading it
+ALTER TABLE qc_input ALTER COLUMN x TYPE numeric;
+SELECT hits - :base_hits AS hits, misses - :base_misses AS misses, entries FROM sl_get_query_cache_stats();
+SELECT att_name, att_type FROM sl_get_attributes_from_sql('SELECT id, x FROM qc_input');
+SELECT hits - :base_hits AS hits, misses - :base_misses AS misses, entries FROM sl_get_query_cache_stats();
+COMMIT;
+
+-- The cache goes away with the transaction
+SELECT entries FROM sl_get_query_cache_stats();
+
+DROP TABLE qc_input;
@@ -0,0 +1,82 @@
+-- Checks EXPLAIN [ANALYZE] SOLVESELECT in the text, JSON, YAML and XML formats
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+RESET client_min_messages;
+
+-- The objective query can be planned alone, the constraint query refers to the parameter of the solver ("$1[1]")
+CREATE FUNCTION ex_solve(arg sl_solver_arg) RETURNS setof record AS $$
+DECLARE
+  obj sl_viewsql_dst := sl_build_dst_obj(arg, sl_build_out(arg));
+  ctr sl_viewsql_dst := sl_build_dst_ctr(arg, sl_build_out_array1subst(arg, 1), 1);
+BEGIN
+  RETURN QUERY EXECUTE sl_return(arg, sl_build_out(arg));
+END;
+$$ LANGUAGE plpgsql VOLATILE STRICT;
+
+WITH solver AS (INSERT INTO sl_solver(name) VALUES ('ex_solver') RETURNING sid)
+INSERT INTO sl_solver_method(sid, name, func_name) SELECT sid, 'ex_method', 'ex_solve' FROM solver;
+
+-- Returns the output of EXPLAIN as a single text
+CREATE FUNCTION ex_explain(query text) RETURNS text AS $$
+DECLARE
+  ln text;
+  res text := '';
+BEGIN
+  FOR ln IN EXECUTE query LOOP
+    res := res || ln || E'\n';
+  END LOOP;
+  RETURN res;
+END;
+$$ LANGUAGE plpgsql;
+
+\set q 'SOLVESELECT x IN (SELECT 1 AS id, NULL::float8 AS x) AS t MINIMIZE (SELECT sum(x) FROM t) SUBJECTTO (SELECT x >= 0 FROM t) USING ex_solver.ex_method'
+
+-- Loads the module, which installs the hook
+SELECT id, x IS NULL AS x_is_null FROM (:q) AS s;
+
+SELECT e LIKE E'%\nSolveDB:\n  Solver: ex_solver\n  Method: ex_method\n%' AS solve,
+       e LIKE '%Objective Direction: minimize%' AS direction
+FROM ex_explain('EXPLAIN (COSTS OFF) ' || :'q') AS e;
+
+-- The section is a member of the query
+SELECT json_array_length(e) AS queries,
+       e -> 0 -> 'Plan' IS NOT NULL AS plan,
+       e -> 0 -> 'SolveDB' -> 'Solves' -> 0 ->> 'Solver' AS solver,
+       e -> 0 -> 'SolveDB' -> 'Solves' -> 0 ->> 'Method' AS method,
+       e -> 0 -> 'SolveDB' -> 'Solves' -> 0 ->> 'Input Query Plan' IS NOT NULL AS input_plan
+FROM (SELECT ex_explain('EXPLAIN (COSTS OFF, FORMAT JSON) ' || :'q')::json AS e) AS s;
+
+SELECT e LIKE E'%\n  SolveDB: \n%' AS solvedb_in_query
+FROM ex_explain('EXPLAIN (COSTS OFF, FORMAT YAML) ' || :'q') AS e;
+
+SELECT position('<Query>' IN e) < position('<SolveDB>' IN e) AND position('</SolveDB>' IN e) < position('</Query>' IN e) AS solvedb_in_query,
+       e LIKE '%<Solver>ex_solver</Solver>%' AS solver
+FROM ex_explain('EXPLAIN (COSTS OFF, FORMAT XML) ' || :'q') AS e;
+
+-- The solves of WITH queries and sublinks
+SELECT json_array_length(e -> 0 -> 'SolveDB' -> 'Solves') AS solves
+FROM (SELECT ex_explain('EXPLAIN (COSTS OFF, FORMAT JSON) WITH s AS (' || :'q' || ') SELECT count(*) FROM s')::json AS e) AS s;
+SELECT json_array_length(e -> 0 -> 'SolveDB' -> 'Solves') AS solves
+FROM (SELECT ex_explain('EXPLAIN (COSTS OFF, FORMAT JSON) SELECT (SELECT count(*) FROM (' || :'q' || ') AS s)')::json AS e) AS s;
+
+-- Under ANALYZE, a generated query that cannot be planned alone does not abort the solve
+SELECT e LIKE '%Objective Query: %' AS objective,
+       e LIKE E'%Constraint Query 1: %\n    Plan unavailable: there is no parameter $1\n%' AS constraint_plan,
+       e LIKE '%Phase %: time=%' AS phases
+FROM ex_explain('EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF) ' || :'q') AS e;
+
+SELECT s ->> 'Objective Query Plan' NOT LIKE 'Plan unavailable%' AS objective_planned,
+       s ->> 'Constraint Query 1 Plan' AS constraint_plan,
+       json_array_length(s -> 'Phases') > 0 AS phases
+FROM (SELECT ex_explain('EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, FORMAT JSON) ' || :'q')::json -> 0 -> 'SolveDB' AS s) AS e;
+
+SELECT position('<Query>' IN e) < position('<SolveDB>' IN e) AND position('</SolveDB>' IN e) < position('</Query>' IN e) AS solvedb_in_query,
+       e LIKE '%<Constraint-Query-1-Plan>Plan unavailable: there is no parameter $1</Constraint-Query-1-Plan>%' AS constraint_plan
+FROM ex_explain('EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, FORMAT XML) ' || :'q') AS e;
+
+-- The solve still runs after the explained ones
+SELECT id, x IS NULL AS x_is_null FROM (:q) AS s;
+
+DELETE FROM sl_solver WHERE name = 'ex_solver';
+DROP FUNCTION ex_explain(text);
+DROP FUNCTION ex_solve(sl_solver_arg);
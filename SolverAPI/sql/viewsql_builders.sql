@@ -0,0 +1,160 @@
+-- Compares the C-native view SQL generators with the reference SQL implementations byte for byte
+CREATE EXTENSION solverapi;
+-- The reference implementations, i.e., the SQL generators of SolverAPI 1.2
+
+CREATE FUNCTION ref_sl_build_out(arg sl_solver_arg) RETURNS sl_viewsql_out AS $$
+	SELECT ROW(format('SELECT * FROM %s', arg.tmp_name))::sl_viewsql_out;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_userdefined(arg sl_solver_arg, user_sql text) RETURNS sl_viewsql_out AS $$
+	SELECT ROW(format('SELECT %s FROM (%s) AS s',
+		(SELECT string_agg(quote_ident(arg.tmp_attrs[i].att_name), ',')
+	         FROM generate_subscripts(arg.tmp_attrs, 1) AS i),
+	         user_sql))::sl_viewsql_out;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_vars(arg sl_solver_arg) RETURNS sl_viewsql_out AS $$
+	SELECT ROW(format('SELECT %s, %s FROM %s',
+		  arg.tmp_id,
+		  array_to_string(
+		  ARRAY[
+		     -- Build substitution for unknown variables
+	             (SELECT string_agg(format('(%s + (%s * %s)) AS %s',
+			                      arg.tmp_id,
+					     (att_nr - 1)::text,
+					      arg.prb_rowcount::text,
+					      att_name), ',')
+	              FROM (SELECT (row_number() OVER ()) AS att_nr, att_name, att_type
+	                    FROM sl_get_attributes(arg) AS A
+	                    WHERE A.att_kind = 'unknown') AS S),
+	              -- Simply list all rest attributes
+	             (SELECT string_agg(att_name, ',')
+	              FROM sl_get_attributes(arg) AS A
+	              WHERE A.att_kind = 'known')
+	                ], ','),
+		      arg.tmp_name))::sl_viewsql_out;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_funcNmap(arg sl_solver_arg, base sl_viewsql_out, funcs text[]) RETURNS sl_viewsql_out AS $$
+	SELECT ROW(format('SELECT %s, %s FROM (%s) AS s',
+		  arg.tmp_id,
+		  array_to_string(
+		  ARRAY[
+		     -- Build substitution for unknown variables
+	             (SELECT string_agg(format('%s(%s) AS %2$s',
+					      funcs[att_nr]::text,
+					      att_name), ','
+				       )
+	              FROM (SELECT (row_number() OVER ()) AS att_nr, att_name, att_type
+	                    FROM sl_get_attributes(arg) AS A
+	                    WHERE A.att_kind = 'unknown') AS S),
+	              -- Simply list all rest attributes
+	             (SELECT string_agg(att_name, ',')
+	              FROM sl_get_attributes(arg) AS A
+	              WHERE A.att_kind = 'known')
+	                ], ','),
+		      base.sql))::sl_viewsql_out;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_funcNsubst(arg sl_solver_arg, funcs text[]) RETURNS sl_viewsql_out AS $$
+	SELECT ref_sl_build_out_funcNmap(arg, ref_sl_build_out_vars(arg),funcs)
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_func1subst(arg sl_solver_arg, func text) RETURNS sl_viewsql_out AS $$
+	SELECT ref_sl_build_out_funcNsubst(arg, array_fill(func, ARRAY[arg.prb_colcount]));
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_arrayNsubst(arg sl_solver_arg, par_pos int[]) RETURNS sl_viewsql_out AS $$
+	SELECT ROW(format('SELECT %s, %s FROM %s',
+		  arg.tmp_id,
+		  array_to_string(
+		  ARRAY[
+		     -- Build substitution for unknown variables
+	             (SELECT string_agg(format('($%s[%s + (%s * %s)])::%s AS %s',
+					      par_pos[att_nr]::text,
+			                      arg.tmp_id,
+					     (att_nr - 1)::text,
+					      arg.prb_rowcount::text,
+					      att_type,
+					      att_name), ','
+				       )
+	              FROM (SELECT (row_number() OVER ()) AS att_nr, att_name, att_type
+	                    FROM sl_get_attributes(arg) AS A
+	                    WHERE A.att_kind = 'unknown') AS S),
+	              -- Simply list all rest attributes
+	             (SELECT string_agg(att_name, ',')
+	              FROM sl_get_attributes(arg) AS A
+	              WHERE A.att_kind = 'known')
+	                ], ','),
+		      arg.tmp_name))::sl_viewsql_out;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_out_array1subst(arg sl_solver_arg, par_nr int DEFAULT 1) RETURNS sl_viewsql_out AS $$
+	SELECT ref_sl_build_out_arrayNsubst(arg, array_fill(par_nr, ARRAY[arg.prb_colcount]));
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_dst_values(arg sl_solver_arg, vsout sl_viewsql_out, cast_to text DEFAULT 'text') RETURNS sl_viewsql_dst AS $$
+	SELECT ROW((SELECT string_agg(
+			      format('SELECT %s + (%s * %s)::int AS var_nr, (%s)::%s AS value FROM (%s) AS S',
+				     (arg).tmp_id, (att_nr-1)::text, arg.prb_rowcount,att_name, quote_ident(cast_to), vsout.sql), ' UNION ALL ')
+			     FROM (SELECT (row_number() OVER ()) AS att_nr, att_name
+	                           FROM sl_get_attributes(arg) AS A
+	                           WHERE A.att_kind = 'unknown') AS S)
+		  )::sl_viewsql_dst;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_dst_obj(arg sl_solver_arg, vsout sl_viewsql_out) RETURNS sl_viewsql_dst AS $$
+	SELECT ROW(format('%s SELECT * FROM (%s) AS S', sl_get_dst_prequery(arg.problem, vsout), (arg.problem).obj_sql))::sl_viewsql_dst;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_build_dst_ctr(arg sl_solver_arg, vsout sl_viewsql_out, ctr_nr int) RETURNS sl_viewsql_dst AS $$
+	SELECT ROW(format('%s SELECT * FROM (%s) AS S', sl_get_dst_prequery(arg.problem, vsout), (arg.problem).ctr_sql[ctr_nr]))::sl_viewsql_dst;
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+CREATE FUNCTION ref_sl_return(arg sl_solver_arg, vsout sl_viewsql_out) RETURNS text AS $$
+	SELECT format('SELECT %s FROM (%s) AS s',
+	    (SELECT string_agg(format('%s::%s',quote_ident((arg.tmp_attrs[i]).att_name),
+							   (arg.tmp_attrs[i]).att_type), ',')
+	     FROM generate_subscripts(arg.tmp_attrs, 1) AS i
+	     WHERE (arg.tmp_attrs[i]).att_kind != 'id'::sl_attribute_kind), vsout.sql);
+$$ LANGUAGE SQL IMMUTABLE STRICT;
+
+-- Solver arguments: with CTEs and known columns; without CTEs, known columns and the objective
+CREATE TEMP TABLE viewsql_arg AS
+SELECT 1 AS nr, ROW(120, 'test_solver', 'test_method', ARRAY[]::sl_parameter_value[],
+           ROW('SELECT 1 AS id, NULL::float8 AS x, NULL::float8 AS "Y", 2.5 AS w', 'input relation', ARRAY['x', 'Y']::name[],
+               'maximize', 'SELECT sum(x) FROM "input relation"',
+               ARRAY['SELECT x <= 1 FROM "input relation"', 'SELECT "Y" >= w FROM "input relation"'],
+               ARRAY[ROW('SELECT 2 AS c', 'My CTE', NULL)::sl_CTE_relation, ROW('SELECT 3 AS d', 'cte2', NULL)::sl_CTE_relation]
+              )::sl_problem,
+           2, 10::bigint, 20::bigint, 'sl_tbl_1', 'sl_col_1',
+           ARRAY[ROW('sl_col_1', 'int8', 'id')::sl_attribute_desc, ROW('x', 'float8', 'unknown')::sl_attribute_desc,
+                 ROW('w', 'numeric', 'known')::sl_attribute_desc, ROW('Y', 'float8', 'unknown')::sl_attribute_desc]
+          )::sl_solver_arg AS arg
+UNION ALL
+SELECT 2, ROW(120, 'test_solver', 'test_method', ARRAY[]::sl_parameter_value[],
+           ROW('SELECT NULL::int AS x', 'input_relation', ARRAY['x']::name[], 'undefined', NULL, ARRAY[]::text[], NULL)::sl_problem,
+           1, 3::bigint, 3::bigint, 'sl_tbl_2', 'sl_col_2',
+           ARRAY[ROW('sl_col_2', 'int8', 'id')::sl_attribute_desc, ROW('x', 'int4', 'unknown')::sl_attribute_desc]
+          )::sl_solver_arg;
+-- Lists the generators producing a different SQL
+SELECT a.nr, b.builder
+FROM viewsql_arg AS a,
+     LATERAL (VALUES
+       ('sl_build_out',             (sl_build_out(a.arg)).sql,                                (ref_sl_build_out(a.arg)).sql),
+       ('sl_build_out_userdefined', (sl_build_out_userdefined(a.arg, 'SELECT 1')).sql,        (ref_sl_build_out_userdefined(a.arg, 'SELECT 1')).sql),
+       ('sl_build_out_vars',        (sl_build_out_vars(a.arg)).sql,                           (ref_sl_build_out_vars(a.arg)).sql),
+       ('sl_build_out_funcNmap',    (sl_build_out_funcNmap(a.arg, sl_build_out(a.arg), ARRAY['f1', 'f2'])).sql,
+                                    (ref_sl_build_out_funcNmap(a.arg, sl_build_out(a.arg), ARRAY['f1', 'f2'])).sql),
+       ('sl_build_out_funcNsubst',  (sl_build_out_funcNsubst(a.arg, ARRAY['f1', 'f2'])).sql,  (ref_sl_build_out_funcNsubst(a.arg, ARRAY['f1', 'f2'])).sql),
+       ('sl_build_out_func1subst',  (sl_build_out_func1subst(a.arg, 'f')).sql,                (ref_sl_build_out_func1subst(a.arg, 'f')).sql),
+       ('sl_build_out_arrayNsubst', (sl_build_out_arrayNsubst(a.arg, ARRAY[3, 6])).sql,       (ref_sl_build_out_arrayNsubst(a.arg, ARRAY[3, 6])).sql),
+       ('sl_build_out_array1subst', (sl_build_out_array1subst(a.arg)).sql,                    (ref_sl_build_out_array1subst(a.arg)).sql),
+       ('sl_build_dst_values',      (sl_build_dst_values(a.arg, sl_build_out(a.arg), 'float8')).sql,
+                                    (ref_sl_build_dst_values(a.arg, sl_build_out(a.arg), 'float8')).sql),
+       ('sl_build_dst_obj',         (sl_build_dst_obj(a.arg, sl_build_out(a.arg))).sql,       (ref_sl_build_dst_obj(a.arg, sl_build_out(a.arg))).sql),
+       ('sl_build_dst_ctr',         (sl_build_dst_ctr(a.arg, sl_build_out(a.arg), 2)).sql,    (ref_sl_build_dst_ctr(a.arg, sl_build_out(a.arg), 2)).sql),
+       ('sl_return',                sl_return(a.arg, sl_build_out_vars(a.arg)),               ref_sl_return(a.arg, sl_build_out_vars(a.arg)))
+     ) AS b(builder, generated, reference)
+WHERE b.generated IS DISTINCT FROM b.reference
+ORDER BY a.nr, b.builder;
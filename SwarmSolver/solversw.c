@@ -15,6 +15,7 @@
 #include "fmgr.h"
 #include "libSwarmOps.h" /* The library compiled with C++ */
 #include "libsolverapi.h"
+#include "solvedb_probes.h"
 #include "catalog/pg_type.h"
 #include "utils/memutils.h"
 #include "catalog/namespace.h"
@@ -24,10 +25,14 @@ PG_MODULE_MAGIC;
 
 /* A list of parameters used by the solver (every method) */
 #define SPAR_COUNT 3
-#define SPAR_NAMES ((const char * [SPAR_COUNT]) {"n", "rndseed", "runs"})
 #define SPAR_pIterationCount 0
 #define SPAR_pRndSeed 1
 #define SPAR_pRuns 2
+static const SL_Param_Decl SPAR_DECLS[SPAR_COUNT] = {
+		{"n", 		SL_ParamType_Int, NULL},
+		{"rndseed", SL_ParamType_Int, NULL},
+		{"runs", 	SL_ParamType_Int, "1"}		/* By default, run once (1) */
+};
 
 /* The solver's context. It carries all information needed to evaluate the prepared query for the fitness function*/
 typedef struct SolverContext {
@@ -36,7 +41,7 @@ typedef struct SolverContext {
 	SPIPlanPtr			plan;			/* A prepared query plan to evaluate the fitness function */
 } SolverContext;
 
-static SwarmOpsParameter * getMethodParameters(SL_Solver_Arg *arg, int * numParameters);
+static SwarmOpsParameter * getMethodParameters(SL_Solver_Arg *arg, SL_Param_Table *params, int * numParameters);
 static void setupInits(SL_Solver_Arg * arg, Datum arg_d, SwarmOpsProblem * prob);
 static void setupBounds(SL_Solver_Arg * arg, Datum arg_d, SwarmOpsProblem *	prob);
 static bool callTheSolver(SL_Solver_Arg * arg, Datum arg_d, SwarmOpsProblem * prob, double * sol_result);
@@ -64,6 +69,7 @@ Datum swarmops_solve(PG_FUNCTION_ARGS)
 	Datum 				arg_d = PG_GETARG_SLSOLVERARGDATUM(0);  /* Get solver argument as DATUM */
 	SL_Solver_Arg 		*arg  = PG_GETARG_SLSOLVERARG(0);		/* Get solver argument as SL_Solver_Arg */
 	SwarmOpsProblem		prob;	/* A definition of black-box problem */
+	SL_Param_Table		*params;
 	double				*solresult;
 	bool				solfound;
 	int					ret;
@@ -76,20 +82,19 @@ Datum swarmops_solve(PG_FUNCTION_ARGS)
              errdetail("SwarmOPS: The solver can only solve the minimization problem. To maximize the objective, please change the sign of the objective function.")));
 	/* Sets a method's name */
 	prob.methodName = arg->method_name;
+	/* Resolve the solver parameters once */
+	params = sl_param_table_create(arg, SPAR_DECLS, SPAR_COUNT);
 	/* Sets parameters to override */
-	prob.methodParams = getMethodParameters(arg, &(prob.numMethodParams));
+	prob.methodParams = getMethodParameters(arg, params, &(prob.numMethodParams));
 	/* Set the number of iterations. SolverAPI promises to always set it */
-	prob.numIterations = sl_param_get_as_int(arg, SPAR_NAMES[SPAR_pIterationCount]);
+	prob.numIterations = sl_param_table_get_int(params, SPAR_DECLS[SPAR_pIterationCount].name);
 
 	/* Set the random seed parameter. SolverAPI will not push the default value if a user does not specify */
-	prob.rndSeedSet = sl_param_isset(arg, SPAR_NAMES[SPAR_pRndSeed]);
+	prob.rndSeedSet = sl_param_table_isset(params, SPAR_DECLS[SPAR_pRndSeed].name);
 	if (prob.rndSeedSet)
-		prob.rndSeed = sl_param_get_as_int(arg, SPAR_NAMES[SPAR_pRndSeed]);
+		prob.rndSeed = sl_param_table_get_int(params, SPAR_DECLS[SPAR_pRndSeed].name);
 
-	if (sl_param_isset(arg, SPAR_NAMES[SPAR_pRuns]))
-		prob.numRuns = sl_param_get_as_int(arg, SPAR_NAMES[SPAR_pRuns]);
-	else
-		prob.numRuns = 1;	/* By default, run once (1) */
+	prob.numRuns = sl_param_table_get_int(params, SPAR_DECLS[SPAR_pRuns].name);
 
 	/* Initialize the problem */
 	prob.numUknowns = arg->prb_varcount;
@@ -135,12 +140,10 @@ Datum swarmops_solve(PG_FUNCTION_ARGS)
 	SL_SOLVER_END
 }
 
-static SwarmOpsParameter * getMethodParameters(SL_Solver_Arg *arg, int * numParameters)
+static SwarmOpsParameter * getMethodParameters(SL_Solver_Arg *arg, SL_Param_Table *params, int * numParameters)
 {
 	SwarmOpsParameter * result;
 	ListCell 	*c;
-	int 	 	i;
-	bool 		mtdParam;
 
 	result = palloc(sizeof(SwarmOpsParameter) * list_length(arg->params));
 	*numParameters = 0;
@@ -149,13 +152,7 @@ static SwarmOpsParameter * getMethodParameters(SL_Solver_Arg *arg, int * numPara
 		SL_Parameter_Value * pv = lfirst(c);
 
 		/* Skip solver parameters, leave only method parameters*/
-		mtdParam = true;
-		for (i = 0; i < SPAR_COUNT; i++)
-			if (strcasecmp(pv->param, SPAR_NAMES [i]) == 0) {
-				mtdParam = false;
-				break;
-			}
-		if (mtdParam) {
+		if (!sl_param_table_isdeclared(params, pv->param)) {
 			result[*numParameters].param = pv->param;
 			result[*numParameters].value = pv->value_f;
 			(*numParameters)++;
@@ -358,11 +355,7 @@ static bool callTheSolver(SL_Solver_Arg * arg, Datum arg_d, SwarmOpsProblem * pr
 	SwarmOpsOutput		solResult;
 
 	/* Initiaize a new memory context to prevent leak of memory when solving a problem */
-	solver_context = AllocSetContextCreate(CurrentMemoryContext,
-									   "SwarmOPS temporary context",
-									   ALLOCSET_DEFAULT_MINSIZE,
-									   ALLOCSET_DEFAULT_INITSIZE,
-									   ALLOCSET_DEFAULT_MAXSIZE);
+	solver_context = sl_work_mem_context_create(CurrentMemoryContext, "SwarmOPS temporary context");
 	old_context = MemoryContextSwitchTo(solver_context);
 
 	/* Run the solver by calling C++ code */
@@ -441,6 +434,8 @@ static double fitness_function(const double *x, void *context, const double fitn
 	double				fitness_val;
 	bool				is_null;
 
+	TRACE_SOLVEDB_SWARM_FITNESS_START(ctx->prob->numUknowns);
+
 	/* Copy a new solution to existing array */
     memcpy(ARR_DATA_PTR(ctx->x_arr), x, sizeof(double)*ctx->prob->numUknowns);
 
@@ -466,6 +461,8 @@ static double fitness_function(const double *x, void *context, const double fitn
 
     SPI_freetuptable(SPI_tuptable);
 
+    TRACE_SOLVEDB_SWARM_FITNESS_DONE(ctx->prob->numUknowns);
+
     return fitness_val;
 }
 
@@ -0,0 +1,32 @@
+-- Measures decoding of SolverAPI composite datums: 1M "sl_unkvar" and 1M "sl_attribute_desc" datums,
+-- with the cached attribute number maps (by_name = false) and with the fetch-by-name decoding (by_name = true).
+--
+-- Usage: psql -d <database> -f bench/decode_composites.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+
+\timing on
+
+\echo === sl_unkvar, 1M datums, by name
+SELECT sl_bench_decode('unkvar', 1000000, true);
+SELECT sl_bench_decode('unkvar', 1000000, true);
+SELECT sl_bench_decode('unkvar', 1000000, true);
+
+\echo === sl_unkvar, 1M datums, cached map
+SELECT sl_bench_decode('unkvar', 1000000);
+SELECT sl_bench_decode('unkvar', 1000000);
+SELECT sl_bench_decode('unkvar', 1000000);
+
+\echo === sl_attribute_desc, 1M datums, by name
+SELECT sl_bench_decode('attribute', 1000000, true);
+SELECT sl_bench_decode('attribute', 1000000, true);
+SELECT sl_bench_decode('attribute', 1000000, true);
+
+\echo === sl_attribute_desc, 1M datums, cached map
+SELECT sl_bench_decode('attribute', 1000000);
+SELECT sl_bench_decode('attribute', 1000000);
+SELECT sl_bench_decode('attribute', 1000000);
+
+\timing off
@@ -0,0 +1,57 @@
+-- Compares the input relation materialization modes of the native SOLVE function
+-- ("solvedb.input_mode" = table | tuplestore) on 10k- and 1M-row inputs.
+--
+-- The solves use the dummy solver of SolverAPI (sl_dummy_solve), which outputs the input relation
+-- unchanged, so the timings are dominated by materializing, scanning and dropping the input.
+-- The dummy solver is registered in a transaction which is rolled back at the end.
+--
+-- Usage: psql -d <database> -f bench/input_mode.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+
+BEGIN;
+
+INSERT INTO sl_solver(name, description) VALUES ('bench_dummy', 'Outputs the input relation unchanged');
+INSERT INTO sl_solver_method(sid, name, func_name, description)
+	SELECT sid, 'dummy', 'sl_dummy_solve', 'Outputs the input relation unchanged' FROM sl_solver WHERE name = 'bench_dummy';
+UPDATE sl_solver s SET default_method_id = m.mid
+	FROM sl_solver_method m WHERE m.sid = s.sid AND s.name = 'bench_dummy';
+
+CREATE TEMP TABLE bench_10k AS
+	SELECT i AS id, (i % 97)::float8 AS w, md5(i::text) AS label, NULL::float8 AS x FROM generate_series(1, 10000) AS i;
+CREATE TEMP TABLE bench_1m AS
+	SELECT i AS id, (i % 97)::float8 AS w, md5(i::text) AS label, NULL::float8 AS x FROM generate_series(1, 1000000) AS i;
+ANALYZE bench_10k;
+ANALYZE bench_1m;
+
+\timing on
+
+\echo === table, 10k rows
+SET solvedb.input_mode = table;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10k) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10k) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10k) AS t USING bench_dummy()) AS s;
+
+\echo === tuplestore, 10k rows
+SET solvedb.input_mode = tuplestore;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10k) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10k) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10k) AS t USING bench_dummy()) AS s;
+
+\echo === table, 1M rows
+SET solvedb.input_mode = table;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s;
+
+\echo === tuplestore, 1M rows
+SET solvedb.input_mode = tuplestore;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s;
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s;
+
+\timing off
+
+ROLLBACK;
@@ -0,0 +1,71 @@
+-- Measures the lp_function operators and aggregates with lp_function_bench() over 10^3 to 10^6 terms:
+--
+--   1. every operation with distinct variables, with 90% duplicate terms, and with sparse variable numbers
+--      (1 in 100 numbers used). "chain" adds the terms one by one with "+" (x1 + x2 + ... + xn), which
+--      extends an expanded lp_function in place, thus its time per term does not grow with the terms
+--   2. the aggregates over terms ordered by the variable number
+--   3. the default sum (an open-addressing table) against sum_hash (dynahash) over 10^7 terms, with the
+--      speedup of sum
+--   4. the adaptive sum against the fixed strategies (sum_hash, sum_array) on dense, sparse and skewed
+--      variable numbers, with the speedup of sum over the fastest fixed strategy
+--
+-- "ns_per_term" is the fastest of 5 loops, and "peak_bytes" is the memory held at the peak (see
+-- LPsolver_v1.5/lp_function_bench.c). sum_sorted merges its whole state on every shuffled term, so it
+-- is measured on up to 10^4 shuffled terms only.
+--
+-- Usage: psql -d <database> -f bench/lp_function.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverlp CASCADE;
+
+\echo === 1. shuffled terms
+SELECT o.operation, t.terms, p.density, p.duplicates, b.distinct_vars, b.result_terms,
+	   round(b.ns_per_term::numeric, 1) AS ns_per_term, b.peak_bytes
+FROM unnest(array['sum', 'sum_hash', 'sum_sorted', 'sum_array', '+', 'chain', '*', 'unnest']) WITH ORDINALITY AS o(operation, n),
+	 unnest(array[1000, 10000, 100000, 1000000]) AS t(terms),
+	 (VALUES (1.0, 0.0), (1.0, 0.9), (0.01, 0.0)) AS p(density, duplicates),
+	 LATERAL lp_function_bench(o.operation, t.terms, p.density, p.duplicates) AS b
+WHERE o.operation <> 'sum_sorted' OR t.terms <= 10000
+ORDER BY o.n, p.density DESC, p.duplicates, t.terms;
+
+\echo === 2. ordered terms
+SELECT o.operation, t.terms, p.duplicates, b.distinct_vars, b.result_terms,
+	   round(b.ns_per_term::numeric, 1) AS ns_per_term, b.peak_bytes
+FROM unnest(array['sum', 'sum_sorted', 'sum_array']) WITH ORDINALITY AS o(operation, n),
+	 unnest(array[1000, 10000, 100000, 1000000]) AS t(terms),
+	 (VALUES (0.0), (0.9)) AS p(duplicates),
+	 LATERAL lp_function_bench(o.operation, t.terms, 1, p.duplicates, ordered := true) AS b
+ORDER BY o.n, p.duplicates, t.terms;
+
+\echo === 3. sum against sum_hash over 10^7 terms
+SELECT p.density, p.duplicates, p.ordered, s.distinct_vars, s.result_terms,
+	   round(s.ns_per_term::numeric, 1) AS sum_ns_per_term, round(h.ns_per_term::numeric, 1) AS sum_hash_ns_per_term,
+	   round((h.ns_per_term / s.ns_per_term)::numeric, 2) AS speedup, s.peak_bytes AS sum_peak_bytes, h.peak_bytes AS sum_hash_peak_bytes
+FROM (VALUES (1.0, 0.0, false), (1.0, 0.9, false), (1.0, 0.99, false), (0.01, 0.0, false), (1.0, 0.9, true))
+		AS p(density, duplicates, ordered),
+	 LATERAL lp_function_bench('sum', 10000000, p.density, p.duplicates, p.ordered, loops := 3) AS s,
+	 LATERAL lp_function_bench('sum_hash', 10000000, p.density, p.duplicates, p.ordered, loops := 3) AS h;
+
+\echo === 4. the adaptive sum on dense, sparse and skewed variable numbers
+WITH runs AS (
+	SELECT d.distribution, d.n AS dn, t.terms, o.operation, b.result_terms, b.ns_per_term, b.peak_bytes
+	FROM (VALUES ('dense', 1.0, 0.5, 0.0, false), ('dense ordered', 1.0, 0.5, 0.0, true),
+				 ('sparse', 0.01, 0.5, 0.0, false),
+				 ('skewed', 1.0, 0.5, 0.9, false), ('skewed sparse', 0.01, 0.5, 0.9, false))
+			WITH ORDINALITY AS d(distribution, density, duplicates, skew, ordered, n),
+		 unnest(array[10000, 100000, 1000000]) AS t(terms),
+		 unnest(array['sum', 'sum_hash', 'sum_array']) AS o(operation),
+		 LATERAL lp_function_bench(o.operation, t.terms, d.density, d.duplicates, d.ordered, skew := d.skew) AS b
+)
+SELECT s.distribution, s.terms, s.result_terms,
+	   round(s.ns_per_term::numeric, 1) AS sum_ns_per_term,
+	   round(h.ns_per_term::numeric, 1) AS sum_hash_ns_per_term,
+	   round(a.ns_per_term::numeric, 1) AS sum_array_ns_per_term,
+	   round((least(h.ns_per_term, a.ns_per_term) / s.ns_per_term)::numeric, 2) AS speedup,
+	   s.peak_bytes AS sum_peak_bytes, h.peak_bytes AS sum_hash_peak_bytes, a.peak_bytes AS sum_array_peak_bytes
+FROM runs s
+	 JOIN runs h ON h.dn = s.dn AND h.terms = s.terms AND h.operation = 'sum_hash'
+	 JOIN runs a ON a.dn = s.dn AND a.terms = s.terms AND a.operation = 'sum_array'
+WHERE s.operation = 'sum'
+ORDER BY s.dn, s.terms;
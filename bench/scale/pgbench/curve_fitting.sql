@@ -0,0 +1,8 @@
+-- The line fitting of DemoQueries/curve_fitting.sql over bench_points. The black-box objective of the
+-- demo is replaced by the maximum absolute deviation, so the fit is an LP with a constraint pair per point.
+SELECT * FROM (
+	SOLVESELECT a, b, d IN (SELECT NULL::float8 AS a, NULL::float8 AS b, NULL::float8 AS d) AS t
+	MINIMIZE  (SELECT sum(d) FROM t)
+	SUBJECTTO (SELECT d >= y - (a * x + b), d >= a * x + b - y FROM t, bench_points),
+			  (SELECT -100 <= a <= 100, -100 <= b <= 100 FROM t)
+	USING solverlp) AS s;
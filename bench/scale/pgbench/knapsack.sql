@@ -0,0 +1,8 @@
+-- The knapsack problem of DemoQueries/knapsack.sql over bench_item. The quantities are continuous
+-- (a fractional knapsack), so the time of GLPK grows with the size of the model only.
+SELECT count(*) FROM (
+	SOLVESELECT quantity IN (SELECT * FROM bench_item) AS u
+	MAXIMIZE  (SELECT sum(quantity * profit) FROM u)
+	SUBJECTTO (SELECT sum(quantity * weight) <= :rows * 12 FROM u),
+			  (SELECT 0 <= quantity <= 1 FROM u)
+	USING solverlp) AS s;
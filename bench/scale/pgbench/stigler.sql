@@ -0,0 +1,10 @@
+-- The diet problem of DemoQueries/stigler.sql over bench_commodities, minimizing the cost of the diet.
+SELECT count(*) FROM (
+	SOLVESELECT exp_daily IN (SELECT cid, price, NULL::float8 AS exp_daily FROM bench_commodities) AS t
+	MINIMIZE  (SELECT sum(price * exp_daily) FROM t)
+	SUBJECTTO (SELECT exp_daily >= 0 FROM t),
+			  (SELECT sum(v.value * exp_daily) >= (SELECT value FROM bench_allowance AS a WHERE a.nid = v.nid)
+			   FROM t INNER JOIN bench_cnvalues AS v ON t.cid = v.cid
+			   GROUP BY v.nid)
+	USING solverlp) AS s
+WHERE exp_daily > 0;
@@ -0,0 +1,12 @@
+-- The Sudoku problem of DemoQueries/sudoku.sql over all puzzles of bench_sudoku at once. The puzzles
+-- share no constraints, so SolverLP solves each of them in a separate partition.
+SELECT count(*) FROM (
+	SOLVESELECT sel IN (SELECT id, col, lin, v AS val, (val = v) AS giv, NULL::boolean AS sel
+						FROM bench_sudoku, generate_series(1, 9) AS v) AS sudoku
+	SUBJECTTO (SELECT sel = giv FROM sudoku WHERE giv),
+			  (SELECT sum(sel) = 1 FROM sudoku GROUP BY id, lin, col),
+			  (SELECT sum(sel) = 1 FROM sudoku GROUP BY id, val, lin),
+			  (SELECT sum(sel) = 1 FROM sudoku GROUP BY id, val, col),
+			  (SELECT sum(sel) = 1 FROM sudoku GROUP BY id, val, ((col - 1) / 3), ((lin - 1) / 3))
+	USING solverlp) AS s
+WHERE sel;
@@ -0,0 +1,99 @@
+#!/bin/bash
+#
+# Runs the scaling SOLVESELECT workloads (knapsack, stigler, sudoku and curve_fitting) with pgbench and
+# writes a CSV report, one line per workload and size:
+#
+#   workload, rows, clients, transactions, tps,
+#   latency_{min,mean,p50,p90,p95,p99,max}_ms         - from the pgbench transaction logs
+#   {input,model,solve,total}_ms                       - the mean phase times of the solves, from sl_stat_solves
+#   rows_in, variables, constraints, nonzeros, partitions - the mean size of the solves, from sl_stat_solves
+#
+# The phase columns are empty unless SolverAPI is loaded via "shared_preload_libraries" and
+# "solvedb.track_solves" is on. The statistics are reset before each run, which requires a superuser.
+# Each run first creates the data of its size with bench/scale/setup/<workload>.sql, and the tables
+# are dropped at the end.
+#
+# Usage: bench/scale/run.sh [-d database] [-w "workloads"] [-s "sizes"] [-c clients] [-t transactions] [-o report.csv]
+#
+#   -w   workloads to run (default: "knapsack stigler sudoku curve_fitting")
+#   -s   input sizes in rows (default: "100 1000 10000 100000 1000000 10000000")
+#   -c   pgbench clients (default: 1)
+#   -t   transactions per client (default: 10)
+#   -o   the report file (default: the standard output)
+#
+# The connection is set up with the usual libpq environment variables (PGHOST, PGPORT, PGUSER).
+
+set -e
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+WORKLOADS="knapsack stigler sudoku curve_fitting"
+SIZES="100 1000 10000 100000 1000000 10000000"
+CLIENTS=1
+TRANSACTIONS=10
+REPORT=/dev/stdout
+
+while getopts "d:w:s:c:t:o:" opt; do
+	case $opt in
+		d) export PGDATABASE=$OPTARG ;;
+		w) WORKLOADS=$OPTARG ;;
+		s) SIZES=$OPTARG ;;
+		c) CLIENTS=$OPTARG ;;
+		t) TRANSACTIONS=$OPTARG ;;
+		o) REPORT=$OPTARG ;;
+		*) sed -n 's/^# Usage: //p' "$0" >&2; exit 1 ;;
+	esac
+done
+
+PSQL="psql -X -q -A -t -v ON_ERROR_STOP=1"
+LOG_DIR=$(mktemp -d)
+trap 'rm -rf "$LOG_DIR"' EXIT
+
+$PSQL -c "SET client_min_messages = warning; CREATE EXTENSION IF NOT EXISTS solverlp CASCADE;"
+
+# The phase times are collected only if the solve statistics can be reset
+if $PSQL -c "SELECT sl_stat_solves_reset();" > /dev/null 2>&1; then
+	TRACK=1
+else
+	TRACK=0
+	echo "run.sh: the solve statistics are not available, the phase columns are left empty" >&2
+fi
+
+echo "workload,rows,clients,transactions,tps,latency_min_ms,latency_mean_ms,latency_p50_ms,latency_p90_ms,latency_p95_ms,latency_p99_ms,latency_max_ms,input_ms,model_ms,solve_ms,total_ms,rows_in,variables,constraints,nonzeros,partitions" > "$REPORT"
+
+for workload in $WORKLOADS; do
+	for rows in $SIZES; do
+		echo "run.sh: $workload, $rows rows" >&2
+		$PSQL -v rows="$rows" -f "$BENCH_DIR/setup/$workload.sql"
+
+		[ $TRACK -eq 1 ] && $PSQL -c "SELECT sl_stat_solves_reset();" > /dev/null
+
+		rm -f "$LOG_DIR"/run.*
+		tps=$(cd "$LOG_DIR" && pgbench -n -c "$CLIENTS" -j "$CLIENTS" -t "$TRANSACTIONS" -D rows="$rows" \
+					-l --log-prefix=run -f "$BENCH_DIR/pgbench/$workload.sql" | sed -n 's/^tps = \([0-9.]*\).*/\1/p' | tail -1)
+
+		# The third column of a transaction log line is the latency in microseconds
+		latency=$(cat "$LOG_DIR"/run.* | awk '{ print $3 / 1000.0 }' | sort -n | awk '
+			{ v[NR] = $1; sum += $1 }
+			function pct(p) { i = int(p * NR + 0.999999); if (i < 1) i = 1; return v[i] }
+			END { printf "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f", v[1], sum / NR, pct(0.50), pct(0.90), pct(0.95), pct(0.99), v[NR] }')
+
+		phases=",,,,,,,,"
+		if [ $TRACK -eq 1 ]; then
+			phases=$($PSQL -F, -c "
+				SELECT round((sum(mean_input_time * calls) / sum(calls))::numeric, 3),
+					   round((sum(mean_model_time * calls) / sum(calls))::numeric, 3),
+					   round((sum(mean_solve_time * calls) / sum(calls))::numeric, 3),
+					   round((sum(mean_total_time * calls) / sum(calls))::numeric, 3),
+					   round(sum(rows_in) / sum(calls)), round(sum(variables) / sum(calls)),
+					   round(sum(constraints) / sum(calls)), round(sum(nonzeros) / sum(calls)),
+					   round(sum(partitions) / sum(calls))
+				FROM sl_stat_solves
+				WHERE dbid = (SELECT oid FROM pg_database WHERE datname = current_database());")
+		fi
+
+		echo "$workload,$rows,$CLIENTS,$TRANSACTIONS,$tps,$latency,$phases" >> "$REPORT"
+	done
+done
+
+$PSQL -c "SET client_min_messages = warning;
+		  DROP TABLE IF EXISTS bench_item, bench_cnvalues, bench_commodities, bench_allowance, bench_sudoku, bench_points;"
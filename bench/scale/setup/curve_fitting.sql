@@ -0,0 +1,12 @@
+-- Points of bench/scale/run.sh: :rows points around the line y = 1.3x + 1, with a small deterministic noise.
+--
+-- Usage: psql -d <database> -v rows=<n> -f bench/scale/setup/curve_fitting.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+
+DROP TABLE IF EXISTS bench_points;
+CREATE UNLOGGED TABLE bench_points AS
+	SELECT id, x, 1.3 * x + 1 + ((id * 7919) % 13 - 6) * 0.1 AS y
+	FROM (SELECT id, (id * 2.0 / :rows * 100)::float8 AS x FROM generate_series(1, :rows) AS id) AS p;
+ANALYZE bench_points;
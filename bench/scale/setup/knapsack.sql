@@ -0,0 +1,14 @@
+-- Knapsack items of bench/scale/run.sh: :rows items with deterministic weights and profits.
+-- The capacity of the knapsack (:rows * 12) is about a quarter of the total weight.
+--
+-- Usage: psql -d <database> -v rows=<n> -f bench/scale/setup/knapsack.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+
+DROP TABLE IF EXISTS bench_item;
+CREATE UNLOGGED TABLE bench_item AS
+	SELECT i AS item, (1 + i % 97)::float8 AS weight, (1 + (i * 7919) % 89)::float8 AS profit,
+		   NULL::float8 AS quantity
+	FROM generate_series(1, :rows) AS i;
+ANALYZE bench_item;
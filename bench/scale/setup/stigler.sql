@@ -0,0 +1,22 @@
+-- The diet problem of bench/scale/run.sh: :rows / 9 commodities, each with the values of 9 nutrients,
+-- so the nutrient values (bench_cnvalues) have about :rows rows.
+--
+-- Usage: psql -d <database> -v rows=<n> -f bench/scale/setup/stigler.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+
+DROP TABLE IF EXISTS bench_cnvalues, bench_commodities, bench_allowance;
+CREATE UNLOGGED TABLE bench_allowance AS
+	SELECT nid, (10 * nid)::float8 AS value FROM generate_series(1, 9) AS nid;
+CREATE UNLOGGED TABLE bench_commodities AS
+	SELECT cid, (1 + cid % 50)::float8 AS price FROM generate_series(1, greatest(:rows / 9, 1)) AS cid;
+CREATE UNLOGGED TABLE bench_cnvalues AS
+	SELECT c.cid, a.nid, ((c.cid * 31 + a.nid * 17) % 100 / 10.0)::float8 AS value
+	FROM bench_commodities AS c, bench_allowance AS a;
+ALTER TABLE bench_allowance ADD PRIMARY KEY (nid);
+ALTER TABLE bench_commodities ADD PRIMARY KEY (cid);
+ALTER TABLE bench_cnvalues ADD PRIMARY KEY (cid, nid);
+ANALYZE bench_allowance;
+ANALYZE bench_commodities;
+ANALYZE bench_cnvalues;
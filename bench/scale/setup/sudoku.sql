@@ -0,0 +1,19 @@
+-- Sudoku puzzles of bench/scale/run.sh. The SOLVESELECT input pairs each cell with the 9 values, so
+-- :rows / 729 puzzles make an input of about :rows rows. Every puzzle is a shifted copy of the same
+-- valid grid, with about a third of the cells given.
+--
+-- Usage: psql -d <database> -v rows=<n> -f bench/scale/setup/sudoku.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+
+DROP TABLE IF EXISTS bench_sudoku;
+CREATE UNLOGGED TABLE bench_sudoku AS
+	SELECT id, col, lin,
+		   CASE WHEN (id * 7 + col * 5 + lin * 3) % 3 = 0
+				THEN ((lin - 1) * 3 + (lin - 1) / 3 + (col - 1) + id) % 9 + 1
+				ELSE 0 END AS val
+	FROM generate_series(1, greatest(:rows / 729, 1)) AS id, generate_series(1, 9) AS col,
+		 generate_series(1, 9) AS lin;
+ALTER TABLE bench_sudoku ADD PRIMARY KEY (id, col, lin);
+ANALYZE bench_sudoku;
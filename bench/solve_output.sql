@@ -0,0 +1,64 @@
+-- Measures the latency and the peak memory of returning a 10M-row solver output from SOLVESELECT:
+--
+--   1. through a wrapping query, with the solver output returned tuple by tuple (the former path)
+--   2. through a wrapping query, with the solver output returned in the materialize mode
+--   3. with a direct solver call, handing the solver's tuplestore to the consumer (no copies)
+--
+-- Every run starts in a new connection, so the "max resident size" reported by log_statement_stats is the peak
+-- of that run. log_statement_stats requires a superuser. The dummy solver (sl_dummy_solve) outputs its input
+-- unchanged; it is registered at the start and removed at the end, together with the input table.
+--
+-- Usage: psql -d <database> -f bench/solve_output.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+
+INSERT INTO sl_solver(name, description) VALUES ('bench_dummy', 'Outputs the input relation unchanged');
+INSERT INTO sl_solver_method(sid, name, func_name, description)
+	SELECT sid, 'dummy', 'sl_dummy_solve', 'Outputs the input relation unchanged' FROM sl_solver WHERE name = 'bench_dummy';
+UPDATE sl_solver s SET default_method_id = m.mid
+	FROM sl_solver_method m WHERE m.sid = s.sid AND s.name = 'bench_dummy';
+
+DROP TABLE IF EXISTS bench_10m;
+CREATE UNLOGGED TABLE bench_10m AS
+	SELECT i AS id, (i % 97)::float8 AS w, NULL::float8 AS x FROM generate_series(1, 10000000) AS i;
+ANALYZE bench_10m;
+
+\echo === 1. wrapping query, tuple by tuple
+\connect
+SET solvedb.input_mode = tuplestore;
+SET solvedb.solve_direct_call = off;
+SET solvedb.solver_return_materialize = off;
+SET client_min_messages = log;
+SET log_statement_stats = on;
+\timing on
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10m) AS t USING bench_dummy()) AS s;
+\timing off
+
+\echo === 2. wrapping query, materialize mode
+\connect
+SET solvedb.input_mode = tuplestore;
+SET solvedb.solve_direct_call = off;
+SET solvedb.solver_return_materialize = on;
+SET client_min_messages = log;
+SET log_statement_stats = on;
+\timing on
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10m) AS t USING bench_dummy()) AS s;
+\timing off
+
+\echo === 3. direct solver call
+\connect
+SET solvedb.input_mode = tuplestore;
+SET solvedb.solve_direct_call = on;
+SET solvedb.solver_return_materialize = on;
+SET client_min_messages = log;
+SET log_statement_stats = on;
+\timing on
+SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_10m) AS t USING bench_dummy()) AS s;
+\timing off
+
+\connect
+SET client_min_messages = warning;
+DROP TABLE bench_10m;
+DELETE FROM sl_solver WHERE name = 'bench_dummy';
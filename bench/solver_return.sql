@@ -0,0 +1,51 @@
+-- Measures the throughput (rows/second) of returning a solver output through SL_SOLVER_RETURN:
+-- the materialize mode ("solvedb.solver_return_materialize" = on) against the tuple-by-tuple mode with
+-- different fetch sizes ("solvedb.solver_fetch_size").
+--
+-- The solves use the dummy solver of SolverAPI (sl_dummy_solve), which outputs the 1M-row input relation
+-- unchanged. The dummy solver is registered in a transaction which is rolled back at the end.
+--
+-- Usage: psql -d <database> -f bench/solver_return.sql
+
+\set ON_ERROR_STOP on
+SET client_min_messages = notice;
+CREATE EXTENSION IF NOT EXISTS solverapi;
+
+BEGIN;
+
+INSERT INTO sl_solver(name, description) VALUES ('bench_dummy', 'Outputs the input relation unchanged');
+INSERT INTO sl_solver_method(sid, name, func_name, description)
+	SELECT sid, 'dummy', 'sl_dummy_solve', 'Outputs the input relation unchanged' FROM sl_solver WHERE name = 'bench_dummy';
+UPDATE sl_solver s SET default_method_id = m.mid
+	FROM sl_solver_method m WHERE m.sid = s.sid AND s.name = 'bench_dummy';
+
+CREATE TEMP TABLE bench_1m AS
+	SELECT i AS id, (i % 97)::float8 AS w, md5(i::text) AS label, NULL::float8 AS x FROM generate_series(1, 1000000) AS i;
+ANALYZE bench_1m;
+
+-- Runs the solve "runs" times with the given settings and reports the best throughput
+CREATE FUNCTION pg_temp.bench_return(materialize boolean, fetch_size int, runs int DEFAULT 3) RETURNS void AS $$
+DECLARE
+	t0		timestamptz;
+	secs	float8;
+	best	float8 = 0;
+	n		bigint;
+BEGIN
+	PERFORM set_config('solvedb.solver_return_materialize', materialize::text, true);
+	PERFORM set_config('solvedb.solver_fetch_size', fetch_size::text, true);
+	FOR i IN 1..runs LOOP
+		t0 = clock_timestamp();
+		EXECUTE 'SELECT count(*) FROM (SOLVESELECT x IN (SELECT * FROM bench_1m) AS t USING bench_dummy()) AS s' INTO n;
+		secs = extract(epoch FROM clock_timestamp() - t0);
+		best = greatest(best, n / secs);
+	END LOOP;
+	RAISE NOTICE 'materialize=%, fetch_size=%: % rows, % rows/s', materialize, fetch_size, n, round(best::numeric);
+END;
+$$ LANGUAGE plpgsql;
+
+SELECT pg_temp.bench_return(false, 50);
+SELECT pg_temp.bench_return(false, 1000);
+SELECT pg_temp.bench_return(false, 10000);
+SELECT pg_temp.bench_return(true, 50);
+
+ROLLBACK;